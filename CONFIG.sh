@@ -1,5 +1,6 @@
 # General Setup-------------------------------------------------
-# Choose the number of unique params configs to check (!!!FOR NOW 1000 is a max limit - WORK ON IT TO ENABLE MORE):
+# Choose the number of unique params configs to check (per-config SLURM jobs are limited by MaxArraySize, larger ranges
+# are meant for 'sweep' together with GEN_PARAMS_SPEC="TRUE" or SWEEP_ARCHIVE="TRUE"):
 N_CONFIG_SETS=1000
 
 # Choose actions (does not matter as for now since there is no launcher (RUN.sh) script managing tasks):
@@ -25,16 +26,37 @@ W31=-4.75; W32=0.00; W33=1.10
 
 # Choose the control parameter {nu, x0, y0, z0, w11, w12, ..., w33}:
 CONTROL_PARAM_NAME="nu"
-# Choose the range and the step for control parameter (currently minimal possible value is 0.001):
+# Choose the range and the step for control parameter (any number of decimals, the values are kept exactly):
 CONTROL_PARAM_MIN=0.001
 CONTROL_PARAM_MAX=3.200 # currently this value does not matter, the max value will be set automatically based on N_CONFIG_SETS and CONTROL_PARAM_STEP
 CONTROL_PARAM_STEP=0.001
+# Store the parameters (and, with 'sweep --archive', the results) of the whole range in one archive file
+# data/time-evol/<CONTROL_PARAM_NAME>/archive_config-XXXXXXX-YYYYYYY.hfa instead of one file per config ("TRUE"/"FALSE"):
+SWEEP_ARCHIVE="FALSE"
+# Store the range as one sweep spec parameters/configs/<CONTROL_PARAM_NAME>/config-XXXXXXX-YYYYYYY.spec (base parameters,
+# min, step) instead of one wparams file per config; the solvers materialise the configs from it ("TRUE"/"FALSE"):
+GEN_PARAMS_SPEC="FALSE"
+# What gen_params does with parameter files of the new IDs that already exist ("keep"/"overwrite"/"fail"):
+GEN_PARAMS_ON_EXISTS="keep"
+# Second control parameter of a 2D parameter-plane sweep ("" for a 1D range): every value of CONTROL_PARAM_NAME is combined
+# with N_CONFIG_SETS2 values CONTROL_PARAM2_MIN + j*CONTROL_PARAM2_STEP (stored as a sweep spec, solved with 'sweep --grid'):
+CONTROL_PARAM2_NAME=""
+CONTROL_PARAM2_MIN=-5.00
+CONTROL_PARAM2_STEP=0.01
+N_CONFIG_SETS2=100
 
 # PERF_TEVOL Setup----------------------------------------------
 # Choose the number of time-evol iterations 
 N_ITER=100000
 # Choose the maximum time of calculations (single proccess) hh:mm:ss
 PERF_TEVOL_TIME="02:00:00"
+# Convolution engine of time-evol (--engine=..., see time-evol.cpp): cached, tiled, threaded, fft, soe, short or auto
+# (fastest one for N_ITER on the node, needs a tuning profile from "time-evol --calibrate" run once per node type)
+TEVOL_ENGINE="cached"
+# Run telemetry of time-evol (see code/src/telemetry.hpp): <output file>.heartbeat with step, steps/s and projected end,
+# rewritten every 60 s, and <output file>.summary.json with the phase times at exit; add --perf-counters for cycles,
+# instructions and LLC misses ("" switches it off)
+TEVOL_TELEMETRY="--heartbeat=60 --summary"
 
 #PLOT_TEVOL Setup-----------------------------------------------
 # Choose the maximum time for plotting (single proccess) hh:mm:ss
@@ -44,6 +66,11 @@ PLOT_TEVOL_TIME="00:30:00"
 # Choose the number of iterations to plot for a single value of control parameter
 N_ITER_LAST=500
 PLOT_BIFUR_TIME="00:30:00"
+# Render the diagram with the native density renderer code/src/bifur_render (built from bifur_render.cpp) instead of
+# scattering every point in Python ("TRUE"/"FALSE"), and its raster size (width 0 = one column per config):
+PLOT_BIFUR_NATIVE="FALSE"
+PLOT_BIFUR_WIDTH=0
+PLOT_BIFUR_HEIGHT=1000
 
 # Paths---------------------------------------------------------
 DATA_DIR="$PROJECT/data"
@@ -52,3 +79,12 @@ SOURCE_CODE_DIR="$PROJECT/code/src"
 PARAMS_DIR="$PROJECT/parameters"
 LOGS_DIR="$PROJECT/logs"
 ERRORS_DIR="$PROJECT/errors"
+# Directory of the on-disk gammafrac kernel cache shared by all time-evol/sweep processes (set to "off" to disable it).
+# Missing kernels are only stored when nu is fixed for the whole range (a nu sweep would write one file per config);
+# the cache is never trimmed automatically, remove the directory (or old files: find ... -atime +30 -delete) to clean it
+export HOPFIELD_KERNEL_CACHE="$DATA_DIR/kernel_cache"
+if [ "$CONTROL_PARAM_NAME" != "nu" ] && [ "$CONTROL_PARAM2_NAME" != "nu" ]; then
+    export HOPFIELD_KERNEL_CACHE_WRITE=1
+else
+    export HOPFIELD_KERNEL_CACHE_WRITE=0
+fi
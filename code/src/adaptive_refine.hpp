@@ -0,0 +1,131 @@
+#pragma once
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+ * Adaptive refinement of a bifurcation sweep (sweep --refine=S): instead of solving every config of a gen_params range,
+ * the range is solved on every S-th config ID first (plus its last ID), and an interval between two neighbouring solved
+ * configs is bisected only while its ends differ:
+ *
+ *      - in their class: period k of the tail (1: fixed point), aperiodic (chaotic or quasi-periodic) or failed, or
+ *      - in their tail statistics: min or max of x, y or z further apart than refine_tol.
+ *
+ * Refinement stops at neighbouring config IDs, so the resolution is the CONTROL_PARAM_STEP of the range (a gen_params
+ * --spec range can have a step far below 0.001 without writing a file per config). Bifurcation points are located to
+ * one step with about S + n_transitions*log2(S) runs instead of one run per step. Windows narrower than S steps whose
+ * ends look alike are not seen, so S should be below the width of the narrowest window of interest.
+ */
+enum TailPeriod : int
+{
+    tail_failed = -1,   // not solved or not finite
+    tail_aperiodic = 0  // no period up to period_max
+};
+
+struct TailClass
+{
+    int period;             // k >= 1, tail_aperiodic or tail_failed
+    double param;           // value of the control parameter
+    double min[3], max[3];  // of x, y, z over the tail
+};
+
+// Class of the tail x[k], y[k], z[k] (k < n): the smallest period p <= period_max with |v[k] - v[k-p]| <= tol for
+// all steps of all three neurons
+inline TailClass classifyTail(double param, const double* x, const double* y, const double* z, int n, int period_max, double tol)
+{
+    TailClass c {tail_failed, param, {0, 0, 0}, {0, 0, 0}};
+    if(n <= 0) return c;
+
+    const double* v[3] = {x, y, z};
+    for(int i=0; i<3; i++)
+    {
+        c.min[i] = *std::min_element(v[i], v[i] + n);
+        c.max[i] = *std::max_element(v[i], v[i] + n);
+        for(int k=0; k<n; k++) if(!std::isfinite(v[i][k])) return c;
+    }
+
+    c.period = tail_aperiodic;
+    for(int p=1; p<=period_max && 2*p<=n; p++)
+    {
+        bool periodic = true;
+        for(int i=0; i<3 && periodic; i++)
+            for(int k=p; k<n && periodic; k++) periodic = std::fabs(v[i][k] - v[i][k-p]) <= tol;
+        if(periodic)
+        {
+            c.period = p;
+            break;
+        }
+    }
+    return c;
+}
+
+inline bool tailsDiffer(const TailClass& a, const TailClass& b, double refine_tol)
+{
+    if(a.period != b.period) return true;
+    if(a.period == tail_failed) return false;
+    for(int i=0; i<3; i++)
+        if(std::fabs(a.min[i] - b.min[i]) > refine_tol || std::fabs(a.max[i] - b.max[i]) > refine_tol) return true;
+    return false;
+}
+
+// Human readable class ("fixed point", "period 2", "aperiodic", "failed")
+inline std::string periodName(int period)
+{
+    if(period == tail_failed) return "failed";
+    if(period == tail_aperiodic) return "aperiodic";
+    return period == 1 ? "fixed point" : "period " + std::to_string(period);
+}
+
+// Solved configs of one contiguous ID range and the configs to solve next
+class Refinement
+{
+    int id_low, id_high;
+    std::map<int, TailClass> solved;
+
+public:
+    Refinement(int id_low_, int id_high_) : id_low(id_low_), id_high(id_high_) {}
+
+    // Every stride-th ID from id_low, and id_high
+    std::vector<int> coarse(int stride) const
+    {
+        std::vector<int> ids;
+        for(long id=id_low; id<id_high; id+=stride) ids.push_back((int)id);
+        ids.push_back(id_high);
+        return ids;
+    }
+
+    void add(int config_id, const TailClass& c) {solved[config_id] = c;}
+
+    // Midpoints of the intervals between neighbouring solved configs that are longer than one step and whose ends differ
+    std::vector<int> next(double refine_tol) const
+    {
+        std::vector<int> ids;
+        if(solved.empty()) return ids;
+        for(auto a = solved.begin(), b = std::next(a); a != solved.end() && b != solved.end(); ++a, ++b)
+            if(b->first - a->first > 1 && tailsDiffer(a->second, b->second, refine_tol))
+                ids.push_back(a->first + (b->first - a->first) / 2);
+        return ids;
+    }
+
+    const std::map<int, TailClass>& configs() const {return solved;}
+
+    // Prints the class changes between neighbouring IDs, i.e. the bifurcation points resolved to one step
+    void printTransitions(std::ostream& out, const std::string& control_param_name) const
+    {
+        if(solved.empty()) return;
+        const std::streamsize precision = out.precision(12);
+        for(auto a = solved.begin(), b = std::next(a); a != solved.end() && b != solved.end(); ++a, ++b)
+        {
+            if(a->second.period == b->second.period) continue;
+            out << "  " << periodName(a->second.period) << " -> " << periodName(b->second.period) << " between "
+                << control_param_name << "=" << a->second.param << " (config " << a->first << ") and "
+                << b->second.param << " (config " << b->first << ")\n";
+        }
+        out.precision(precision);
+    }
+};
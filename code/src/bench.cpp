@@ -0,0 +1,351 @@
+/*
+    Benchmark of the time-evolution engines: reproducible timings of the hot loop, of the kernel construction and of
+    the output writing, to compare builds and machines before a sweep is submitted.
+
+    Usage: bench [--engines=a,b,...] [--n-iter=N1,N2,...] [--nu=v1,v2,...] [--formats=f1,f2,...] [--repeat=R]
+                 [--min-time=T] [--time-limit=S] [--json=FILE] [--csv=FILE] [--baseline=FILE] [--tolerance=F]
+                 [--label=TEXT]
+
+    Three kinds of measurements (column 'kind', the variant measured in column 'variant'):
+        solve    HopfieldNetwork::run with --engine=<variant> on the base configuration of CONFIG.sh with the given nu,
+                 n_iter steps, output discarded; includes the kernel construction of the engine like a real first run
+        kernel   loadGammafracKernel(nu, n_iter) alone (variant 'build')
+        output   n_iter synthetic steps written through openTrajectoryWriter in format <variant> (writer thread as in
+                 time-evol) to a file in $TMPDIR (or /tmp), including the final flush; independent of nu (nu 0)
+    Defaults: every engine of HopfieldNetwork::engines() (naive included), n_iter 1000,10000,100000,1000000, nu
+    0.3,0.6,0.9, formats csv,bin,bin32. Every measurement is repeated at least R times (default 3) and, for short ones,
+    until the repetitions have taken --min-time seconds (default 0.5; at most 10000 repetitions). A measurement whose
+    time, extrapolated quadratically from the previous n_iter of the same variant, would exceed --time-limit seconds
+    (default 60) is skipped (status 'skipped', e.g. naive from 1e5 on), and repetitions stop once they have taken
+    --time-limit seconds together.
+
+    Reported per measurement: best and median seconds, steps/s (n_iter / best) and the peak resident set size during
+    the measurement (VmHWM after resetting it through /proc/self/clear_refs, in KiB; the process peak if that is not
+    possible). The results go to stdout as a table, to --csv=FILE as CSV and to --json=FILE together with the machine
+    (engine_tuning.hpp), compiler and label.
+
+    --baseline=FILE compares every measurement with the same kind, variant, nu and n_iter in an earlier --csv file and
+    prints the ratio of steps/s; anything slower than (1 - tolerance) times the baseline (--tolerance, default 0.1) is
+    flagged REGRESSION and makes bench exit with status 2. Timings are only comparable on the same node type with
+    nothing else running on it (a baseline from a shared login node is noise); raise --tolerance where that cannot be
+    had.
+
+    The on-disk kernel cache is switched off (HOPFIELD_KERNEL_CACHE=off), so every run builds its kernel.
+
+    Build: g++ -std=c++17 -O2 bench.cpp -o bench -lgsl -lgslcblas -pthread
+*/
+
+#include "hopfield.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <limits>
+#include <map>
+
+#include <sys/resource.h>
+
+struct BenchResult
+{
+    std::string kind, variant;
+    double nu;
+    int n_iter;
+    int repeats {0};
+    double best {0}, median {0};
+    long peak_rss_kib {0};
+    std::string status {"ok"};
+
+    double stepsPerSecond() const {return (repeats > 0 && best > 0) ? n_iter / best : 0.0;}
+    std::string key() const {return kind + "," + variant + "," + exactDecimal(nu) + "," + std::to_string(n_iter);}
+};
+
+// Resets the peak resident set size of the process (false if the kernel does not support it)
+bool resetPeakRss()
+{
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+    clear_refs.close();
+    return clear_refs.good();
+}
+
+// Peak resident set size in KiB since the last resetPeakRss(), or since the start of the process
+long peakRss()
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while(std::getline(status, line))
+        if(line.rfind("VmHWM:", 0) == 0) return std::stol(line.substr(6));
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// Runs 'work' (which returns false on failure) at least 'repeat' times and for at least min_time seconds (short
+// measurements are repeated until the best time is stable), stopping early once time_limit seconds have passed
+template<typename Work>
+void measure(BenchResult& r, int repeat, double min_time, double time_limit, Work&& work)
+{
+    std::vector<double> seconds;
+    double total = 0.0;
+    resetPeakRss();
+    for(int k=0; (k < repeat || total < min_time) && k < 10000 && (k == 0 || total < time_limit); k++)
+    {
+        const auto t0 = std::chrono::steady_clock::now();
+        if(!work())
+        {
+            r.status = "failed";
+            return;
+        }
+        seconds.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+        total += seconds.back();
+    }
+    r.peak_rss_kib = peakRss();
+    std::sort(seconds.begin(), seconds.end());
+    r.repeats = (int)seconds.size();
+    r.best = seconds.front();
+    r.median = seconds[seconds.size() / 2];
+}
+
+std::vector<std::string> splitList(const std::string& list)
+{
+    std::vector<std::string> items;
+    std::istringstream iss(list);
+    std::string item;
+    while(std::getline(iss, item, ',')) if(!item.empty()) items.push_back(item);
+    return items;
+}
+
+std::string jsonString(const std::string& s)
+{
+    std::string out = "\"";
+    for(char c : s)
+    {
+        if(c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> engines;
+    for(const HopfieldNetwork::Engine& engine : HopfieldNetwork::engines()) engines.push_back(engine.name);
+    std::vector<int> n_iters {1000, 10000, 100000, 1000000};
+    std::vector<double> nus {0.3, 0.6, 0.9};
+    std::vector<std::string> formats {"csv", "bin", "bin32"};
+    int repeat = 3;
+    double min_time = 0.5, time_limit = 60.0, tolerance = 0.1;
+    std::string json_path, csv_path, baseline_path, label;
+
+    for(int i=1; i<argc; i++)
+    {
+        const std::string arg = argv[i];
+        if(arg.rfind("--engines=", 0) == 0) engines = splitList(arg.substr(10));
+        else if(arg.rfind("--n-iter=", 0) == 0)
+        {
+            n_iters.clear();
+            for(const std::string& v : splitList(arg.substr(9))) n_iters.push_back((int)std::stod(v));
+        }
+        else if(arg.rfind("--nu=", 0) == 0)
+        {
+            nus.clear();
+            for(const std::string& v : splitList(arg.substr(5))) nus.push_back(std::stod(v));
+        }
+        else if(arg.rfind("--formats=", 0) == 0) formats = splitList(arg.substr(10));
+        else if(arg.rfind("--repeat=", 0) == 0) repeat = std::stoi(arg.substr(9));
+        else if(arg.rfind("--min-time=", 0) == 0) min_time = std::stod(arg.substr(11));
+        else if(arg.rfind("--time-limit=", 0) == 0) time_limit = std::stod(arg.substr(13));
+        else if(arg.rfind("--json=", 0) == 0) json_path = arg.substr(7);
+        else if(arg.rfind("--csv=", 0) == 0) csv_path = arg.substr(6);
+        else if(arg.rfind("--baseline=", 0) == 0) baseline_path = arg.substr(11);
+        else if(arg.rfind("--tolerance=", 0) == 0) tolerance = std::stod(arg.substr(12));
+        else if(arg.rfind("--label=", 0) == 0) label = arg.substr(8);
+        else
+        {
+            std::cerr << "ERROR unknown argument " << arg << '\n';
+            return 1;
+        }
+    }
+    for(const std::string& engine : engines) if(HopfieldNetwork::findEngine(engine) == nullptr) return 1;
+    for(const std::string& format : formats)
+    {
+        if(!validTrajectoryFormat(format))
+        {
+            std::cerr << "ERROR unknown output format " << format << '\n';
+            return 1;
+        }
+    }
+    if(repeat < 1) repeat = 1;
+    std::sort(n_iters.begin(), n_iters.end());
+
+    setenv("HOPFIELD_KERNEL_CACHE", "off", 1);
+    const char* tmpdir = std::getenv("TMPDIR");
+    const fs::path output_dir = (tmpdir != nullptr && *tmpdir != '\0') ? fs::path(tmpdir) : fs::path("/tmp");
+
+    std::vector<BenchResult> results;
+    std::map<std::string, std::pair<int, double>> previous; // variant (and nu) -> last n_iter measured and its time
+
+    // Skips r (status 'skipped') if its predicted time is above the limit, true if it should be measured
+    auto admit = [&](BenchResult& r, const std::string& series) {
+        auto found = previous.find(series);
+        if(found == previous.end()) return true;
+        const double ratio = (double)r.n_iter / found->second.first;
+        if(found->second.second * ratio * ratio <= time_limit) return true;
+        r.status = "skipped";
+        return false;
+    };
+    auto report = [&](BenchResult& r, const std::string& series) {
+        if(r.status == "ok") previous[series] = {r.n_iter, r.best};
+        std::cout << std::left << std::setw(7) << r.kind << std::setw(10) << r.variant << std::right << " nu " << std::setw(5)
+                  << exactDecimal(r.nu) << "  n_iter " << std::setw(8) << r.n_iter;
+        if(r.status == "ok")
+            std::cout << std::scientific << std::setprecision(3) << "  best " << r.best << " s  median " << r.median
+                      << " s  " << r.stepsPerSecond() << " steps/s" << std::defaultfloat << "  peak RSS " << r.peak_rss_kib << " KiB\n";
+        else std::cout << "  " << r.status << '\n';
+        results.push_back(r);
+    };
+
+    std::cout << "bench: " << engines.size() << " engines, " << n_iters.size() << " n_iter, " << nus.size() << " nu, "
+              << repeat << " repetitions, time limit " << time_limit << " s\n";
+
+    for(double nu : nus)
+    {
+        for(int n_iter : n_iters)
+        {
+            BenchResult r {"kernel", "build", nu, n_iter};
+            if(admit(r, "kernel " + exactDecimal(nu)))
+                measure(r, repeat, min_time, time_limit, [&] { return loadGammafracKernel(nu, n_iter, kernel_anchor_interval).size() == (size_t)n_iter; });
+            report(r, "kernel " + exactDecimal(nu));
+        }
+
+        for(const std::string& engine : engines)
+        {
+            for(int n_iter : n_iters)
+            {
+                BenchResult r {"solve", engine, nu, n_iter};
+                const std::string series = "solve " + engine + " " + exactDecimal(nu);
+                if(admit(r, series))
+                {
+                    SolverOptions options;
+                    options.engine = engine;
+                    const TrajectoryInfo info {nu, 0.2, -0.5, 0.8, {2.0, -1.2, 0.0, 1.9, 1.71, 1.15, -4.75, 0.0, 1.1}, n_iter, 0};
+                    measure(r, repeat, min_time, time_limit, [&] {
+                        Params wparams(info);
+                        HopfieldNetwork H(&wparams);
+                        H.verbose = false;
+                        H.output_writer = [] { return std::unique_ptr<TrajectoryWriter>(new DiscardWriter()); };
+                        return H.run(options, "");
+                    });
+                }
+                report(r, series);
+            }
+        }
+    }
+
+    for(const std::string& format : formats)
+    {
+        for(int n_iter : n_iters)
+        {
+            BenchResult r {"output", format, 0.0, n_iter};
+            if(admit(r, "output " + format))
+            {
+                const fs::path path = output_dir / ("hopfield_bench_" + std::to_string(getpid()) + trajectoryExtension(format));
+                const TrajectoryInfo info {0.5, 0.2, -0.5, 0.8, {2.0, -1.2, 0.0, 1.9, 1.71, 1.15, -4.75, 0.0, 1.1}, n_iter, 0};
+                measure(r, repeat, min_time, time_limit, [&] {
+                    std::unique_ptr<TrajectoryWriter> file = openTrajectoryWriter(path, format, info);
+                    if(!file) return false;
+                    for(int n=0; n<n_iter; n++) file->write(n, std::sin(0.1*n), std::cos(0.1*n), std::sin(0.05*n) - 0.5);
+                    file->close();
+                    return true;
+                });
+                std::error_code ec;
+                fs::remove(path, ec);
+            }
+            report(r, "output " + format);
+        }
+    }
+
+    if(!csv_path.empty())
+    {
+        std::ofstream csv(csv_path);
+        if(!csv.is_open())
+        {
+            std::cerr << "ERROR opening " << csv_path << '\n';
+            return 1;
+        }
+        csv << "kind,variant,nu,n_iter,repeats,best_s,median_s,steps_per_s,peak_rss_kib,status\n" << std::setprecision(9);
+        for(const BenchResult& r : results)
+            csv << r.key() << ',' << r.repeats << ',' << r.best << ',' << r.median << ',' << r.stepsPerSecond() << ','
+                << r.peak_rss_kib << ',' << r.status << '\n';
+        std::cout << "results written to " << csv_path << '\n';
+    }
+
+    if(!json_path.empty())
+    {
+        std::ofstream json(json_path);
+        if(!json.is_open())
+        {
+            std::cerr << "ERROR opening " << json_path << '\n';
+            return 1;
+        }
+
+        const std::time_t now = std::time(nullptr);
+        char date[32];
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+        json << "{\n  \"label\": " << jsonString(label) << ",\n  \"date\": " << jsonString(date)
+             << ",\n  \"compiler\": " << jsonString(__VERSION__) << ",\n  \"machine\": {";
+        std::istringstream machine(hardwareSignature());
+        std::string name, value;
+        for(int k=0; machine >> name >> value; k++) json << (k ? ", " : "") << jsonString(name) << ": " << jsonString(value);
+        json << "},\n  \"repeat\": " << repeat << ",\n  \"min_time\": " << min_time << ",\n  \"time_limit\": " << time_limit << ",\n  \"results\": [\n" << std::setprecision(9);
+        for(size_t k=0; k<results.size(); k++)
+        {
+            const BenchResult& r = results[k];
+            json << "    {\"kind\": " << jsonString(r.kind) << ", \"variant\": " << jsonString(r.variant) << ", \"nu\": " << r.nu
+                 << ", \"n_iter\": " << r.n_iter << ", \"repeats\": " << r.repeats << ", \"best_s\": " << r.best
+                 << ", \"median_s\": " << r.median << ", \"steps_per_s\": " << r.stepsPerSecond() << ", \"peak_rss_kib\": "
+                 << r.peak_rss_kib << ", \"status\": " << jsonString(r.status) << "}" << (k + 1 < results.size() ? ",\n" : "\n");
+        }
+        json << "  ]\n}\n";
+        std::cout << "results written to " << json_path << '\n';
+    }
+
+    if(baseline_path.empty()) return 0;
+
+    std::ifstream baseline(baseline_path);
+    if(!baseline.is_open())
+    {
+        std::cerr << "ERROR opening " << baseline_path << '\n';
+        return 1;
+    }
+    std::map<std::string, double> baseline_rate; // kind,variant,nu,n_iter -> steps/s
+    std::string line;
+    std::getline(baseline, line);
+    while(std::getline(baseline, line))
+    {
+        std::vector<std::string> fields;
+        std::istringstream iss(line);
+        std::string field;
+        while(std::getline(iss, field, ',')) fields.push_back(field);
+        if(fields.size() == 10 && fields[9] == "ok")
+            baseline_rate[fields[0] + "," + fields[1] + "," + fields[2] + "," + fields[3]] = std::stod(fields[7]);
+    }
+
+    int n_compared = 0, n_regressions = 0;
+    std::cout << "comparison with " << baseline_path << " (steps/s now / baseline):\n";
+    for(const BenchResult& r : results)
+    {
+        auto found = baseline_rate.find(r.key());
+        if(r.status != "ok" || found == baseline_rate.end() || found->second <= 0) continue;
+        const double ratio = r.stepsPerSecond() / found->second;
+        const bool regression = ratio < 1.0 - tolerance;
+        n_compared++;
+        if(regression) n_regressions++;
+        std::cout << "  " << std::left << std::setw(7) << r.kind << std::setw(10) << r.variant << std::right << " nu "
+                  << std::setw(5) << exactDecimal(r.nu) << "  n_iter " << std::setw(8) << r.n_iter << "  "
+                  << std::fixed << std::setprecision(3) << ratio << std::defaultfloat << (regression ? "  REGRESSION" : "") << '\n';
+    }
+    std::cout << n_compared << " measurements compared, " << n_regressions << " regression(s) beyond " << tolerance*100 << "%\n";
+    return n_regressions > 0 ? 2 : 0;
+}
@@ -0,0 +1,348 @@
+/*
+    Bifurcation density renderer: turns the results of a whole sweep into bifurcation diagrams without plotting any
+    point in Python.
+
+    Usage: bifur_render <config_id_min> <config_id_max> [--tail=K] [--width=W] [--height=H] [--threads=N] [--output=PREFIX]
+
+    The configs are resolved like in sweep (parameters/configs/config_id_list.txt). For every config the last K steps
+    (default: N_ITER_LAST of the range's CONFIG file) are taken from, in this order,
+        - an aggregated bifurcation file data/bifur/<CONTROL_PARAM_NAME>/bifur_config-XXXXXXX-YYYYYYY.csv (sweep --bifur)
+          lying inside the requested range,
+        - the sweep archive data/time-evol/<CONTROL_PARAM_NAME>/archive_config-XXXXXXX-YYYYYYY.hfa (sweep --archive),
+        - time-evol_config-XXXXXXX.bin or .csv in data/time-evol/<CONTROL_PARAM_NAME>/,
+    reading only the tail of every file, on --threads threads (default: all hardware threads). The samples are binned
+    into one W x H histogram per neuron over (control parameter, state value); W defaults to one column per config, H
+    to 800. Written are
+        PREFIX_counts.bin     raw counts (see RasterHeader below, read with hopfield_io.load_bifur_raster)
+        PREFIX_{x,y,z}.pgm    one grayscale image per neuron (log-scaled density, dark = many samples)
+        PREFIX.ppm            the three panels stacked (x red, y green, z blue) like the plot_bifur.py figure
+    PREFIX defaults to $PROJECT/figures/bifurcation/<CONTROL_PARAM_NAME>/bifur_xyz_config-XXXXXXX-YYYYYYY. Axes are
+    added by plot_bifur_raster.py.
+
+    Build: g++ -std=c++17 -O2 bifur_render.cpp -o bifur_render -lgsl -lgslcblas -pthread
+*/
+
+#include "sweep_config.hpp"
+#include "thread_pool.hpp"
+
+#include <cstdlib>
+#include <limits>
+#include <map>
+
+// Fetching the environment variable $PROJECT which is a path to the whole project (same as gen_params)
+const char* PROJECT_ENV = std::getenv("PROJECT");
+
+// Header of PREFIX_counts.bin, followed by uint32 counts[3][height][width] (row 0 is the largest state value)
+struct RasterHeader
+{
+    char magic[8];              // "HFBIFR01"
+    std::uint32_t width, height;
+    std::int64_t n_configs, n_samples;
+    double param_min, param_max;
+    double value_min[3], value_max[3];
+    char control_param_name[16];
+    char reserved[16];
+};
+
+static_assert(sizeof(RasterHeader) == 128, "unexpected RasterHeader layout");
+
+// Tail samples of one config
+struct ConfigTail
+{
+    int config_id;
+    double param {std::nan("")};
+    std::vector<double> v[3];
+};
+
+// Reads an aggregated bifurcation file (config_id,<param>,n,x,y,z), keeping the last n_last rows of every config. The
+// configs may come in any order (sweep appends them as they finish), the rows of one config are in step order; an
+// unterminated last line (the sweep was killed while writing it) is skipped.
+bool readBifurFile(const fs::path& path, int n_last, std::map<int, ConfigTail>& tails)
+{
+    std::ifstream file(path);
+    std::string line;
+    if(!std::getline(file, line)) return false;
+
+    while(std::getline(file, line) && !file.eof())
+    {
+        char* p;
+        const int config_id = (int)std::strtol(line.c_str(), &p, 10);
+        ConfigTail& tail = tails[config_id];
+        tail.config_id = config_id;
+        tail.param = std::strtod(p + 1, &p);
+        std::strtol(p + 1, &p, 10);
+        for(int c=0; c<3; c++) tail.v[c].push_back(std::strtod(p + 1, &p));
+    }
+
+    for(auto& [config_id, tail] : tails)
+        for(int c=0; c<3; c++)
+            if((int)tail.v[c].size() > n_last) tail.v[c].erase(tail.v[c].begin(), tail.v[c].end() - n_last);
+    return true;
+}
+
+// Log-scaled density of one panel (counts of one neuron): 0 = no sample, 1 = the densest pixel of the panel
+std::vector<double> shading(const std::uint32_t* counts, size_t n_pixels)
+{
+    std::uint32_t count_max = 1;
+    for(size_t k=0; k<n_pixels; k++) count_max = std::max(count_max, counts[k]);
+
+    std::vector<double> density(n_pixels);
+    const double scale = 1.0 / std::log1p((double)count_max);
+    for(size_t k=0; k<n_pixels; k++) density[k] = std::log1p((double)counts[k]) * scale;
+    return density;
+}
+
+int main(int argc, char* argv[])
+{
+    if(argc < 3)
+    {
+        std::cerr << "usage: bifur_render <config_id_min> <config_id_max> [--tail=K] [--width=W] [--height=H] [--threads=N] [--output=PREFIX]\n";
+        return 1;
+    }
+    if(PROJECT_ENV == nullptr)
+    {
+        std::cerr << "ERROR environment variable PROJECT is not set\n";
+        return 1;
+    }
+    const fs::path PROJECT = PROJECT_ENV;
+    const fs::path PARAMS_DIR = PROJECT / "parameters";
+    const fs::path DATA_DIR = PROJECT / "data";
+
+    const int config_id_min = std::stoi(argv[1]);
+    const int config_id_max = std::stoi(argv[2]);
+
+    int n_last = 0, width = 0, height = 800;
+    int n_threads = (int)std::thread::hardware_concurrency();
+    std::string prefix;
+    for(int i=3; i<argc; i++)
+    {
+        std::string arg = argv[i];
+        if(arg.rfind("--tail=", 0) == 0) n_last = std::stoi(arg.substr(7));
+        else if(arg.rfind("--width=", 0) == 0) width = std::stoi(arg.substr(8));
+        else if(arg.rfind("--height=", 0) == 0) height = std::stoi(arg.substr(9));
+        else if(arg.rfind("--threads=", 0) == 0) n_threads = std::stoi(arg.substr(10));
+        else if(arg.rfind("--output=", 0) == 0) prefix = arg.substr(9);
+        else
+        {
+            std::cerr << "ERROR unknown argument " << arg << '\n';
+            return 1;
+        }
+    }
+
+    // Resolving the config ranges (all of them must share the control parameter, it is the horizontal axis)
+    ConfigRange range {-1, -2, "", "", ""};
+    std::string control_param_name;
+    std::vector<std::pair<int, fs::path>> archives; // (id_low, path) of the existing sweep archives
+    std::vector<SweepSpec> specs;                   // sweep specs of the ranges generated with gen_params --spec
+    for(int config_id=config_id_min; config_id<=config_id_max; config_id++)
+    {
+        if(config_id >= range.id_low && config_id <= range.id_high) continue;
+        if(!resolveConfigRange(PARAMS_DIR, config_id, range)) return 1;
+
+        if(control_param_name.empty()) control_param_name = range.control_param_name;
+        else if(control_param_name != range.control_param_name)
+        {
+            std::cerr << "ERROR configs " << config_id_min << "-" << config_id_max << " do not share the control parameter ("
+                      << control_param_name << ", " << range.control_param_name << ")\n";
+            return 1;
+        }
+        if(n_last == 0)
+        {
+            const std::string value = readConfigValue(range.config_file, "N_ITER_LAST");
+            n_last = value.empty() ? 500 : std::stoi(value);
+        }
+
+        if(!range.spec_file.empty())
+        {
+            specs.emplace_back();
+            if(!specs.back().read(range.spec_file)) return 1;
+        }
+
+        const fs::path archive = DATA_DIR / "time-evol" / control_param_name / sweepArchiveName(range.id_low, range.id_high);
+        if(fs::exists(archive)) archives.push_back({range.id_low, archive});
+    }
+
+    const fs::path TEVOL_DIR = DATA_DIR / "time-evol" / control_param_name;
+    const fs::path BIFUR_DIR = DATA_DIR / "bifur" / control_param_name;
+    if(prefix.empty())
+    {
+        fs::create_directories(PROJECT / "figures" / "bifurcation" / control_param_name);
+        prefix = (PROJECT / "figures" / "bifurcation" / control_param_name
+                  / (configFileName("bifur_xyz_config-", config_id_min, "") + configFileName("-", config_id_max, ""))).string();
+    }
+
+    // Aggregated bifurcation files inside the range are read first, the configs they cover are not looked up again
+    std::map<int, ConfigTail> aggregated;
+    if(fs::is_directory(BIFUR_DIR))
+    {
+        for(const fs::directory_entry& entry : fs::directory_iterator(BIFUR_DIR))
+        {
+            const std::string name = entry.path().filename().string();
+            int id_low, id_high;
+            if(std::sscanf(name.c_str(), "bifur_config-%7d-%7d.csv", &id_low, &id_high) != 2) continue;
+            if(id_low < config_id_min || id_high > config_id_max) continue;
+            if(!readBifurFile(entry.path(), n_last, aggregated)) std::cerr << "WARNING could not read " << entry.path() << '\n';
+        }
+    }
+
+    std::vector<ConfigTail> tails;
+    for(int config_id=config_id_min; config_id<=config_id_max; config_id++)
+    {
+        auto found = aggregated.find(config_id);
+        if(found != aggregated.end()) tails.push_back(std::move(found->second));
+        else tails.push_back({config_id, std::nan(""), {}});
+    }
+
+    // Reading the tails of all other configs in parallel (each thread opens its own archive handles)
+    std::vector<std::map<int, std::unique_ptr<SweepArchive>>> thread_archives(std::max(n_threads, 1));
+    WorkStealingPool pool;
+    pool.run((int)tails.size(), n_threads, [&](int task, int thread) {
+        ConfigTail& tail = tails[task];
+        if(!tail.v[0].empty()) return;
+
+        // Sweep archive holding the config
+        for(const auto& [id_low, path] : archives)
+        {
+            std::unique_ptr<SweepArchive>& archive = thread_archives[thread][id_low];
+            if(!archive)
+            {
+                archive = std::make_unique<SweepArchive>();
+                if(!archive->openExisting(path)) std::cerr << "WARNING " << path << " is not a sweep archive\n";
+            }
+            if(!archive->contains(tail.config_id)) continue;
+
+            if(archive->readTail(tail.config_id, n_last, tail.v[0], tail.v[1], tail.v[2]))
+            {
+                tail.param = controlParamValue(archivedInfo(archive->entry(tail.config_id)), control_param_name);
+                return;
+            }
+            break;
+        }
+
+        // Per-config files, parameters from the wparams file or the sweep spec of the range
+        const SweepSpec* spec = nullptr;
+        for(const SweepSpec& s : specs) if(s.contains(tail.config_id)) spec = &s;
+        const fs::path params_path = PARAMS_DIR / "wparams" / control_param_name / configFileName("wparams_config-", tail.config_id, ".txt");
+        for(const char* extension : {".bin", ".csv"})
+        {
+            const fs::path path = TEVOL_DIR / configFileName("time-evol_config-", tail.config_id, extension);
+            if(!fs::exists(path) || (spec == nullptr && !fs::exists(params_path))) continue;
+            if(readTrajectoryTail(path, n_last, tail.v[0], tail.v[1], tail.v[2]))
+                tail.param = (spec != nullptr) ? spec->controlValue(tail.config_id) : controlParamValue(trajectoryInfo(Params(params_path), 0), control_param_name);
+            return;
+        }
+    });
+
+    // Axis ranges
+    double param_min = std::numeric_limits<double>::infinity(), param_max = -param_min;
+    double value_min[3], value_max[3];
+    for(int c=0; c<3; c++)
+    {
+        value_min[c] = std::numeric_limits<double>::infinity();
+        value_max[c] = -value_min[c];
+    }
+    std::int64_t n_configs = 0, n_samples = 0;
+    for(const ConfigTail& tail : tails)
+    {
+        if(tail.v[0].empty() || !std::isfinite(tail.param)) continue;
+        n_configs++;
+        param_min = std::min(param_min, tail.param);
+        param_max = std::max(param_max, tail.param);
+        for(int c=0; c<3; c++)
+        {
+            for(double v : tail.v[c])
+            {
+                if(!std::isfinite(v)) continue;
+                value_min[c] = std::min(value_min[c], v);
+                value_max[c] = std::max(value_max[c], v);
+            }
+        }
+        n_samples += (std::int64_t)tail.v[0].size();
+    }
+    if(n_configs == 0)
+    {
+        std::cerr << "ERROR no results found for configs " << config_id_min << "-" << config_id_max << '\n';
+        return 1;
+    }
+    if(n_configs < (std::int64_t)tails.size())
+        std::cerr << "WARNING " << tails.size() - n_configs << " configs without results are left out\n";
+    if(width <= 0) width = (int)tails.size();
+
+    // Binning, one histogram per thread (configs of neighbouring parameter values may share a column)
+    const size_t panel = (size_t)width * height;
+    std::vector<std::vector<std::uint32_t>> thread_counts(std::max(n_threads, 1));
+    pool.run((int)tails.size(), n_threads, [&](int task, int thread) {
+        const ConfigTail& tail = tails[task];
+        if(tail.v[0].empty() || !std::isfinite(tail.param)) return;
+
+        std::vector<std::uint32_t>& counts = thread_counts[thread];
+        if(counts.empty()) counts.assign(3 * panel, 0);
+
+        const int column = (param_max > param_min) ? (int)std::lround((tail.param - param_min) / (param_max - param_min) * (width - 1)) : 0;
+        for(int c=0; c<3; c++)
+        {
+            const double scale = (value_max[c] > value_min[c]) ? height / (value_max[c] - value_min[c]) : 0.0;
+            for(double v : tail.v[c])
+            {
+                if(!std::isfinite(v)) continue;
+                const int bin = std::min((int)((v - value_min[c]) * scale), height - 1);
+                counts[c*panel + (size_t)(height - 1 - bin) * width + column]++;
+            }
+        }
+    });
+
+    std::vector<std::uint32_t> counts(3 * panel, 0);
+    for(const std::vector<std::uint32_t>& partial : thread_counts)
+        for(size_t k=0; k<partial.size(); k++) counts[k] += partial[k];
+
+    // Raw counts
+    RasterHeader header {};
+    std::memcpy(header.magic, "HFBIFR01", 8);
+    header.width = width;
+    header.height = height;
+    header.n_configs = n_configs;
+    header.n_samples = n_samples;
+    header.param_min = param_min;
+    header.param_max = param_max;
+    for(int c=0; c<3; c++)
+    {
+        header.value_min[c] = value_min[c];
+        header.value_max[c] = value_max[c];
+    }
+    std::strncpy(header.control_param_name, control_param_name.c_str(), sizeof(header.control_param_name) - 1);
+
+    std::ofstream counts_file(prefix + "_counts.bin", std::ios::binary);
+    counts_file.write((const char*)&header, sizeof(header));
+    counts_file.write((const char*)counts.data(), (std::streamsize)(counts.size() * sizeof(std::uint32_t)));
+    if(!counts_file)
+    {
+        std::cerr << "ERROR writing " << prefix << "_counts.bin\n";
+        return 1;
+    }
+
+    // Images: one PGM per neuron and the three panels stacked in one PPM
+    const unsigned char colors[3][3] = {{255, 0, 0}, {0, 128, 0}, {0, 0, 255}};
+    std::ofstream ppm(prefix + ".ppm", std::ios::binary);
+    ppm << "P6\n" << width << " " << 3*height << "\n255\n";
+    for(int c=0; c<3; c++)
+    {
+        const std::vector<double> density = shading(counts.data() + c*panel, panel);
+
+        std::vector<unsigned char> gray(panel), rgb(3 * panel);
+        for(size_t k=0; k<panel; k++)
+        {
+            gray[k] = (unsigned char)std::lround(255 * (1.0 - density[k]));
+            for(int channel=0; channel<3; channel++)
+                rgb[3*k + channel] = (unsigned char)std::lround(255 + (colors[c][channel] - 255) * density[k]);
+        }
+
+        std::ofstream pgm(prefix + "_" + "xyz"[c] + ".pgm", std::ios::binary);
+        pgm << "P5\n" << width << " " << height << "\n255\n";
+        pgm.write((const char*)gray.data(), (std::streamsize)gray.size());
+        ppm.write((const char*)rgb.data(), (std::streamsize)rgb.size());
+    }
+
+    std::cout << "bifur_render: " << n_configs << " configs, " << n_samples << " samples per neuron, "
+              << width << "x" << height << " pixels per panel -> " << prefix << ".ppm\n";
+    return 0;
+}
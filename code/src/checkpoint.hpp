@@ -0,0 +1,239 @@
+#pragma once
+
+#include <iostream>
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <memory>
+
+#include "trajectory_io.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+/*
+ * Checkpoint of a running time evolution (time-evol --checkpoint=SECONDS, continued with --resume), kept next to the
+ * output file as <output file>.ckpt (all little-endian):
+ *
+ *      offset   0  CheckpointHeader (192 bytes)
+ *             192  x, y, z (float64) of step 0, then of step 1, 2, ...
+ *
+ * The state of every engine is a function of the trajectory computed so far: *jsum_cache[j] is computed from x[j],
+ * y[j], z[j] alone, and the fft accumulators, the soe modes and the short-memory rings are sums over *jsum_cache. A
+ * checkpoint therefore only stores the trajectory, and it grows by appending the steps computed since the previous
+ * one (24 bytes per step) instead of rewriting the solver state. On --resume the engine rebuilds its state from the
+ * stored steps with the same operations in the same order as the uninterrupted run (O(n) for the full-history
+ * engines, O(n log n) for 'fft'), so the resumed output is byte-identical to an uninterrupted one.
+ *
+ * Commit: the new steps are written and synced first, then n_done in the header (one aligned 8-byte write) and synced
+ * again. A job killed at any point leaves the previous n_done, whose steps are complete; steps past n_done are
+ * overwritten by the resumed run. A checkpoint is taken every 'interval' seconds and when the process receives
+ * SIGUSR1 (e.g. sbatch --signal=USR1@120) or SIGTERM (sent by SLURM at the time limit; the process then terminates as
+ * it would have without the checkpoint). It is removed once the run has completed.
+ */
+struct CheckpointHeader
+{
+    char magic[8];              // "HFCKPT01"
+    std::uint32_t header_size;  // 192
+    std::uint32_t reserved0;
+    std::int64_t n_done;        // steps 0..n_done-1 are stored
+    std::int64_t n_iter;
+    char engine[16];            // engine that wrote the checkpoint
+    double nu;
+    double x0, y0, z0;
+    double w[9];
+    char reserved[40];
+};
+
+static_assert(sizeof(CheckpointHeader) == 192, "unexpected CheckpointHeader layout");
+
+constexpr char checkpoint_magic[8] = {'H', 'F', 'C', 'K', 'P', 'T', '0', '1'};
+
+// Signal that requested a checkpoint (SIGUSR1 or SIGTERM), 0 if none
+inline volatile std::sig_atomic_t checkpoint_signal = 0;
+
+inline void requestCheckpoint(int signum) {checkpoint_signal = signum;}
+
+/*
+ * Passes every step on to the output writer ('sink') and appends it to the checkpoint file. Steps are buffered and
+ * written in blocks of buffer_rows; the elapsed time and checkpoint_signal are looked at every check_rows steps.
+ */
+class CheckpointWriter : public TrajectoryWriter
+{
+    static constexpr int buffer_rows = 1 << 15;
+    static constexpr int check_rows = 1024;
+
+    std::unique_ptr<TrajectoryWriter> sink;
+    std::string path;
+    CheckpointHeader header {};
+    double interval;            // seconds between checkpoints
+    int fd {-1};
+
+    std::vector<double> buffer; // x, y, z of the steps n_stored..n_rows-1
+    std::int64_t n_stored {0};  // steps written to the file (committed or not)
+    std::int64_t n_rows {0};    // steps received
+    std::chrono::steady_clock::time_point next_checkpoint;
+    bool closed {false};
+
+    void scheduleNext()
+    {
+        next_checkpoint = std::chrono::steady_clock::now()
+                          + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(interval));
+    }
+
+    bool flush()
+    {
+        if(buffer.empty()) return true;
+        const bool ok = pwriteAll(fd, buffer.data(), buffer.size() * sizeof(double), header.header_size + n_stored * 3 * (std::int64_t)sizeof(double));
+        n_stored += (std::int64_t)buffer.size() / 3;
+        buffer.clear();
+        return ok;
+    }
+
+public:
+    CheckpointWriter(std::unique_ptr<TrajectoryWriter> sink_, const std::string& path_, const TrajectoryInfo& info,
+                     const std::string& engine, double interval_)
+        : sink(std::move(sink_)), path(path_), interval(interval_)
+    {
+        std::memcpy(header.magic, checkpoint_magic, sizeof(header.magic));
+        header.header_size = sizeof(CheckpointHeader);
+        header.n_iter = info.n_iter;
+        std::strncpy(header.engine, engine.c_str(), sizeof(header.engine) - 1);
+        header.nu = info.nu;
+        header.x0 = info.x0;
+        header.y0 = info.y0;
+        header.z0 = info.z0;
+        std::memcpy(header.w, info.w, sizeof(header.w));
+        buffer.reserve(3 * buffer_rows);
+    }
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+    ~CheckpointWriter() override
+    {
+        close();
+        if(fd >= 0) ::close(fd);
+    }
+
+    // Opens the checkpoint file. With 'resume' an existing checkpoint of the same run is continued (n_done steps are
+    // then restored by restore()), otherwise and if there is none a new one is started. Returns false (after
+    // printing the error) if the file cannot be opened or holds a checkpoint of a different run.
+    bool open(bool resume)
+    {
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | (resume ? 0 : O_TRUNC), 0644);
+        if(fd < 0)
+        {
+            std::cerr << "ERROR opening checkpoint " << path << '\n';
+            return false;
+        }
+
+        CheckpointHeader stored {};
+        const ssize_t size = pread(fd, &stored, sizeof(stored), 0);
+        if(size > 0)
+        {
+            // Everything but n_done (and the reserved bytes) has to match
+            if(size != (ssize_t)sizeof(stored) || std::memcmp(stored.magic, header.magic, sizeof(header.magic)) != 0
+               || stored.header_size != header.header_size || stored.n_iter != header.n_iter
+               || std::strncmp(stored.engine, header.engine, sizeof(header.engine)) != 0
+               || std::memcmp(&stored.nu, &header.nu, offsetof(CheckpointHeader, reserved) - offsetof(CheckpointHeader, nu)) != 0)
+            {
+                std::cerr << "ERROR " << path << " is not a checkpoint of this run (engine " << header.engine
+                          << ", n_iter " << header.n_iter << ", same parameters), remove it to start over\n";
+                return false;
+            }
+            header.n_done = stored.n_done;
+        }
+        else if(!pwriteAll(fd, &header, sizeof(header), 0))
+        {
+            std::cerr << "ERROR writing checkpoint " << path << '\n';
+            return false;
+        }
+
+        n_stored = n_rows = header.n_done;
+        scheduleNext();
+        std::signal(SIGUSR1, requestCheckpoint);
+        std::signal(SIGTERM, requestCheckpoint);
+        return true;
+    }
+
+    // Steps stored by the checkpoint that was opened (0 for a new one)
+    std::int64_t stepsDone() const {return header.n_done;}
+
+    // Writes the stored steps 0..n_done-1 to the output writer and hands each of them to f(n, x, y, z), so that the
+    // engine can rebuild its state. Returns false if the checkpoint cannot be read.
+    template<typename F>
+    bool restore(F&& f)
+    {
+        std::vector<double> rows;
+        for(std::int64_t first=0; first<header.n_done; first+=buffer_rows)
+        {
+            const std::int64_t count = std::min<std::int64_t>(buffer_rows, header.n_done - first);
+            rows.resize(3 * count);
+            const std::int64_t length = 3 * count * (std::int64_t)sizeof(double);
+            if(pread(fd, rows.data(), length, header.header_size + first * 3 * (std::int64_t)sizeof(double)) != length)
+            {
+                std::cerr << "ERROR reading checkpoint " << path << '\n';
+                return false;
+            }
+            for(std::int64_t k=0; k<count; k++)
+            {
+                const int n = (int)(first + k);
+                sink->write(n, rows[3*k], rows[3*k+1], rows[3*k+2]);
+                f(n, rows[3*k], rows[3*k+1], rows[3*k+2]);
+            }
+        }
+        return true;
+    }
+
+    // Makes all steps received so far the new checkpoint
+    bool commit()
+    {
+        bool ok = flush() && fdatasync(fd) == 0;
+        if(ok)
+        {
+            header.n_done = n_rows;
+            ok = pwriteAll(fd, &header.n_done, sizeof(header.n_done), offsetof(CheckpointHeader, n_done)) && fdatasync(fd) == 0;
+        }
+        if(!ok) std::cerr << "ERROR writing checkpoint " << path << '\n';
+        scheduleNext();
+        return ok;
+    }
+
+    void write(int n, double x, double y, double z) override
+    {
+        sink->write(n, x, y, z);
+
+        buffer.push_back(x);
+        buffer.push_back(y);
+        buffer.push_back(z);
+        n_rows++;
+        if((int)buffer.size() == 3 * buffer_rows && !flush()) std::cerr << "ERROR writing checkpoint " << path << '\n';
+
+        if(n_rows % check_rows != 0) return;
+        const int signum = checkpoint_signal;
+        if(signum == 0 && std::chrono::steady_clock::now() < next_checkpoint) return;
+
+        checkpoint_signal = 0;
+        commit();
+        if(signum == SIGTERM)
+        {
+            std::signal(SIGTERM, SIG_DFL);
+            std::raise(SIGTERM);
+        }
+    }
+
+    void close() override
+    {
+        if(closed) return;
+        closed = true;
+        sink->close();
+
+        // A completed run does not need its checkpoint any more
+        if(n_rows == header.n_iter) ::unlink(path.c_str());
+        else commit();
+    }
+};
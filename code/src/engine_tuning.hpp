@@ -0,0 +1,191 @@
+#pragma once
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <fstream>
+#include <filesystem>
+#include <sstream>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include <string>
+
+#include "result_cache.hpp"
+
+#include <sched.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+/*
+ * Tuning profile of --engine=auto. 'time-evol --calibrate' times the engines that compute the exact map (cached,
+ * tiled with several block sizes, threaded with several thread counts, fft; never the approximating soe/short) for a
+ * few n_iter on the current machine and stores the timings as
+ *
+ *      <tuning dir>/profile-<hardware hash>.txt
+ *
+ *      cpu Intel(R)_Xeon(R)_Platinum_8268_CPU_@_2.90GHz
+ *      cpus 48
+ *      l2 1048576
+ *      l3 36700160
+ *      run n_iter 20000 engine tiled block 2048 threads 1 seconds 0.0412
+ *      ...
+ *
+ * The hardware hash covers the CPU model, the number of CPUs and the L2/L3 sizes, so nodes of one type share a profile
+ * and every type of a mixed cluster gets its own. The tuning dir is $HOPFIELD_TUNING, or $PROJECT/data/tuning if that
+ * is not set ($HOPFIELD_TUNING=off disables the profile).
+ *
+ * For a run of n_iter steps with at most max_threads threads, every timed setting is interpolated linearly in
+ * log(n_iter)-log(seconds) between the calibrated n_iter (extrapolated from the two nearest ones outside of them) and
+ * the fastest one is taken.
+ */
+struct TunedEngine
+{
+    std::string engine;
+    int block_size {0};
+    int threads {1};
+};
+
+// CPUs this process may run on (the cpuset of a SLURM job, not the whole node)
+inline int availableCpus()
+{
+    cpu_set_t set;
+    if(sched_getaffinity(0, sizeof(set), &set) == 0) return std::max(1, CPU_COUNT(&set));
+    return std::max(1, (int)std::thread::hardware_concurrency());
+}
+
+// Hardware description the profile belongs to ("name value" lines, the first part of the profile file)
+inline std::string hardwareSignature()
+{
+    std::string cpu = "unknown";
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while(std::getline(cpuinfo, line))
+    {
+        if(line.rfind("model name", 0) != 0) continue;
+        cpu = line.substr(line.find(':') + 2);
+        for(char& c : cpu) if(c == ' ' || c == '\t') c = '_';
+        break;
+    }
+
+    std::ostringstream oss;
+    oss << "cpu " << cpu << '\n' << "cpus " << std::thread::hardware_concurrency() << '\n'
+        << "l2 " << sysconf(_SC_LEVEL2_CACHE_SIZE) << '\n' << "l3 " << sysconf(_SC_LEVEL3_CACHE_SIZE) << '\n';
+    return oss.str();
+}
+
+// Profile file of this machine, "" if profiles are switched off or there is no place for them
+inline fs::path tuningProfilePath()
+{
+    fs::path dir;
+    const char* env = std::getenv("HOPFIELD_TUNING");
+    const char* project = std::getenv("PROJECT");
+    if(env != nullptr) dir = (std::string(env) == "off") ? fs::path() : fs::path(env);
+    else if(project != nullptr && *project != '\0') dir = fs::path(project) / "data" / "tuning";
+    if(dir.empty()) return {};
+
+    return dir / ("profile-" + fnv1aHex(hardwareSignature()) + ".txt");
+}
+
+class TuningProfile
+{
+    // (engine, block, threads) -> n_iter -> seconds
+    std::map<std::tuple<std::string, int, int>, std::map<int, double>> timings;
+
+public:
+    bool empty() const {return timings.empty();}
+
+    void add(int n_iter, const TunedEngine& e, double seconds) {timings[{e.engine, e.block_size, e.threads}][n_iter] = seconds;}
+
+    bool write(const fs::path& path) const
+    {
+        std::error_code ec;
+        fs::create_directories(path.parent_path(), ec);
+        std::ofstream file(path);
+        if(!file.is_open())
+        {
+            std::cerr << "ERROR opening " << path << '\n';
+            return false;
+        }
+        file << hardwareSignature();
+        for(const auto& [setting, runs] : timings)
+            for(const auto& [n_iter, seconds] : runs)
+                file << "run n_iter " << n_iter << " engine " << std::get<0>(setting) << " block " << std::get<1>(setting)
+                     << " threads " << std::get<2>(setting) << " seconds " << seconds << '\n';
+        return file.good();
+    }
+
+    // Reads the timings of a profile written by write(), false if there is no such file
+    bool read(const fs::path& path)
+    {
+        std::ifstream file(path);
+        if(!file.is_open()) return false;
+        timings.clear();
+        std::string line;
+        while(std::getline(file, line))
+        {
+            std::istringstream iss(line);
+            std::string tag, k1, k2, k3, k4, k5;
+            int n_iter;
+            TunedEngine e;
+            double seconds;
+            if(iss >> tag && tag == "run" && iss >> k1 >> n_iter >> k2 >> e.engine >> k3 >> e.block_size >> k4 >> e.threads >> k5 >> seconds
+               && seconds > 0)
+                add(n_iter, e, seconds);
+        }
+        return !timings.empty();
+    }
+
+    // Fastest setting for n_iter steps using at most max_threads threads, false if the profile has none
+    bool choose(int n_iter, int max_threads, TunedEngine& best, double& best_seconds) const
+    {
+        best_seconds = std::numeric_limits<double>::infinity();
+        for(const auto& [setting, runs] : timings)
+        {
+            if(std::get<2>(setting) > max_threads) continue;
+
+            // Segment of the calibrated n_iter around n_iter (the outermost one when n_iter is outside of them)
+            auto hi = runs.lower_bound(n_iter);
+            if(hi == runs.end()) hi = std::prev(runs.end());
+            if(hi == runs.begin() && runs.size() > 1) hi = std::next(hi);
+            const auto lo = (hi == runs.begin()) ? hi : std::prev(hi);
+
+            double seconds;
+            if(lo == hi) seconds = hi->second * std::pow((double)n_iter / hi->first, 2.0); // one point: O(n_iter^2)
+            else
+            {
+                const double slope = std::log(hi->second / lo->second) / std::log((double)hi->first / lo->first);
+                seconds = lo->second * std::pow((double)n_iter / lo->first, slope);
+            }
+
+            if(seconds < best_seconds)
+            {
+                best_seconds = seconds;
+                best = {std::get<0>(setting), std::get<1>(setting), std::get<2>(setting)};
+            }
+        }
+        return std::isfinite(best_seconds);
+    }
+
+    // Profile of this machine, read once per process (empty if there is none)
+    static const TuningProfile& current()
+    {
+        static std::once_flag once;
+        static TuningProfile profile;
+        std::call_once(once, [] {
+            const fs::path path = tuningProfilePath();
+            if(path.empty() || !profile.read(path))
+                std::cerr << "WARNING no tuning profile for this machine" << (path.empty() ? "" : " (" + path.string() + ")")
+                          << ", --engine=auto uses the 'cached' engine; run 'time-evol --calibrate' to create one\n";
+        });
+        return profile;
+    }
+};
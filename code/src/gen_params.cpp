@@ -9,6 +9,26 @@
     5th row: w31, w32, w33
     ^-- these three rows hold the weights of a given Hopfield network 
     6th row: n_iter (the number of time-evol iterations)
+
+    The values are written with as many digits as they need to read back exactly, and the control parameter of config
+    k is CONTROL_PARAM_MIN + k*CONTROL_PARAM_STEP computed on the decimal grid of the two arguments (see SweepSpec in
+    sweep_spec.hpp), so steps below 0.001 are kept.
+
+    Optional arguments after the 20th:
+    --archive           no wparams files are written: the parameters of all configurations go to the index of a single
+                        sweep archive $PROJECT/data/time-evol/<CONTROL_PARAM_NAME>/archive_config-XXXXXXX-YYYYYYY.hfa
+                        (see sweep_archive.hpp), which 'sweep --archive' then reads and fills with the results
+    --spec              no wparams files are written: the range is stored once as a sweep spec (base parameters, control
+                        parameter, min, step) next to the saved CONFIG file, parameters/configs/<CONTROL_PARAM_NAME>/
+                        config-XXXXXXX-YYYYYYY.spec, and the solvers materialise each config from it by ID (sweep,
+                        bifur_render, and time-evol with "<spec file>#<config ID>" as the params path)
+    --grid=NAME2:MIN2:STEP2:COUNT2
+                        two-dimensional sweep (implies --spec): every one of the N_CONFIG_SETS values of the control
+                        parameter is combined with COUNT2 values MIN2 + j*STEP2 of the control parameter NAME2, so the
+                        range has N_CONFIG_SETS*COUNT2 config IDs (row by row, see sweep_spec.hpp); solved with
+                        'sweep --grid', which writes one grid summary file per range
+    --on-exists=POLICY  what to do with wparams files (archive entries, spec file) of the new IDs that already exist:
+                        'keep' them (default), 'overwrite' them or 'fail' before anything is written
 */
 
 #include <iostream>
@@ -21,90 +41,41 @@
 #include <cctype>
 #include <cstdlib>
 
-namespace fs = std::filesystem;
+#include "sweep_archive.hpp"
+#include "sweep_spec.hpp"
 
-// v``` !!! ALWAYS keep it at 'false' state here for safety !!!
-bool FULL_OVERWRITE = false; // Parameter which determines whether to overwrite all wparams_config-XXXXXXX.txt files at once
-bool FULL_KEEP = false; // Parameter which determines whether to KEEP all pre-existing wparams_config-XXXXXXX.txt files (non-existing files still get created)
+namespace fs = std::filesystem;
 
 // Fetching the environment variable $PROJECT which is a path to the whole project
 // Is represented as char* i.e. C-style string, but I instantly pass it as an argument to 
 // save it as a fs::path type variable
 fs::path PROJECT = fs::path( std::getenv("PROJECT") ); 
 
-enum class StringCode
+enum class OnExists
 {
-    yes,
-    no,
-    ALL,
-    KEEP,
+    keep,
+    overwrite,
+    fail,
     unknown
 };
 
-StringCode hashString(const std::string& str)
-{
-    if(str == "yes") return StringCode::yes;
-    else if(str == "no") return StringCode::no;
-    else if(str == "ALL") return StringCode::ALL;
-    else if (str == "KEEP") return StringCode::KEEP;
-    return StringCode::unknown;
-}
-
-enum class ControlParamNameCode
+OnExists hashOnExists(const std::string& str)
 {
-    nu,
-    x0_, y0_, z0_,
-    w11, w12, w13,
-    w21, w22, w23,
-    w31, w32, w33,
-    unknown
-};
-
-ControlParamNameCode hashControlParamName(const std::string& str)
-{
-    if(str == "nu") return ControlParamNameCode::nu;
-
-    else if(str == "x0") return ControlParamNameCode::x0_;
-    else if(str == "y0") return ControlParamNameCode::y0_;
-    else if(str == "z0") return ControlParamNameCode::z0_;
-
-    else if(str == "w11") return ControlParamNameCode::w11;
-    else if(str == "w12") return ControlParamNameCode::w12;
-    else if(str == "w13") return ControlParamNameCode::w13;
-
-    else if(str == "w21") return ControlParamNameCode::w21;
-    else if(str == "w22") return ControlParamNameCode::w22;
-    else if(str == "w23") return ControlParamNameCode::w23;
-
-    else if(str == "w31") return ControlParamNameCode::w31;
-    else if(str == "w32") return ControlParamNameCode::w32;
-    else if(str == "w33") return ControlParamNameCode::w33;
-
-    return ControlParamNameCode::unknown;
+    if(str == "keep") return OnExists::keep;
+    else if(str == "overwrite") return OnExists::overwrite;
+    else if(str == "fail") return OnExists::fail;
+    return OnExists::unknown;
 }
 
-struct Params 
+void createFile(const std::string& filename, const TrajectoryInfo& wp)
 {
-    double nu;
-    double x0_; double y0_; double z0_;
-    double w11; double w12; double w13;
-    double w21; double w22; double w23;
-    double w31; double w32; double w33;
-
-    int n_iter; // Does not count as a control parameter
-};
-
-void createFile(const std::string& filename, Params& wp, double* CONTROL_PARAM_PTR, const double p)
-{
-    *CONTROL_PARAM_PTR = p;
-
     std::ofstream file(filename);
     
-    file << std::fixed << std::setprecision(3) << wp.nu << '\n';
-    file << std::fixed << std::setprecision(3) << wp.x0_ << " " << wp.y0_ << " " << wp.z0_ << '\n';
-    file << std::fixed << std::setprecision(3) << wp.w11 << " " << wp.w12 << " " << wp.w13 << '\n';
-    file << std::fixed << std::setprecision(3) << wp.w21 << " " << wp.w22 << " " << wp.w23 << '\n';
-    file << std::fixed << std::setprecision(3) << wp.w31 << " " << wp.w32 << " " << wp.w33 << '\n';
+    file << exactDecimal(wp.nu) << '\n';
+    file << exactDecimal(wp.x0) << " " << exactDecimal(wp.y0) << " " << exactDecimal(wp.z0) << '\n';
+    file << exactDecimal(wp.w[0]) << " " << exactDecimal(wp.w[1]) << " " << exactDecimal(wp.w[2]) << '\n';
+    file << exactDecimal(wp.w[3]) << " " << exactDecimal(wp.w[4]) << " " << exactDecimal(wp.w[5]) << '\n';
+    file << exactDecimal(wp.w[6]) << " " << exactDecimal(wp.w[7]) << " " << exactDecimal(wp.w[8]) << '\n';
     file << wp.n_iter;
 
     file.close();
@@ -120,7 +91,7 @@ void createFile(const std::string& filename, Params& wp, double* CONTROL_PARAM_P
 //     return result;
 // }
 
-// Checks if any wparams_config-XXXXXXX.txt files exist. If not, it sets last_config_id to "-1" (i.e. "no files detected")
+// Checks if any wparams_config-XXXXXXX.txt files (or sweep specs) exist. If not, it sets last_config_id to "-1" (i.e. "no files detected")
 void checkLastConfigID(const fs::path& PARAMS_DIR)
 {
     fs::path wparams_dir = PARAMS_DIR / "wparams";
@@ -144,6 +115,13 @@ void checkLastConfigID(const fs::path& PARAMS_DIR)
         }
     }
 
+    // Ranges generated with --spec have no wparams files, only config-XXXXXXX-YYYYYYY.spec
+    for(const fs::directory_entry& entry : fs::recursive_directory_iterator(PARAMS_DIR / "configs"))
+    {
+        if(do_files_exist) break;
+        if(entry.path().extension() == ".spec") do_files_exist = true;
+    }
+
     if(do_files_exist == false)
     {
         fs::path last_config_id_path = PARAMS_DIR / "configs" / "last_config_id.txt"; // file holding IDs (from-to) of latest checked configurations
@@ -159,13 +137,19 @@ void checkLastConfigID(const fs::path& PARAMS_DIR)
     }
 }
 
-void saveConfigFile(const fs::path& PARAMS_DIR, const int last_config_id, const int N_CONFIG_SETS, const std::string& CONTROL_PARAM_NAME)
+// Path of the CONFIG.sh copy of the range last_config_id+1..last_config_id+N_CONFIG_SETS
+fs::path configFilePath(const fs::path& PARAMS_DIR, const int last_config_id, const int N_CONFIG_SETS, const std::string& CONTROL_PARAM_NAME)
 {
     std::ostringstream oss;
     oss << "configs/" << CONTROL_PARAM_NAME << "/config-" << std::setw(7) << std::setfill('0') << (last_config_id + 1)
         << "-" << std::setw(7) << std::setfill('0') << (last_config_id + N_CONFIG_SETS) << ".sh";
+    return PARAMS_DIR / oss.str();
+}
+
+void saveConfigFile(const fs::path& PARAMS_DIR, const int last_config_id, const int N_CONFIG_SETS, const std::string& CONTROL_PARAM_NAME)
+{
     fs::path source = PROJECT / "CONFIG.sh";
-    fs::path destination = PARAMS_DIR / oss.str();
+    fs::path destination = configFilePath(PARAMS_DIR, last_config_id, N_CONFIG_SETS, CONTROL_PARAM_NAME);
 
     try {
         fs::copy_file(source, destination);
@@ -177,87 +161,77 @@ void saveConfigFile(const fs::path& PARAMS_DIR, const int last_config_id, const
 
 int main(int argc, char* argv[])
 {
-    const int scaling_factor = 1000; // Scaling factor by which control parameter is multiplied to safely cast it to an int
+    if(argc < 21)
+    {
+        std::cerr << "usage: gen_params <PARAMS_DIR> <N_CONFIG_SETS> <CONTROL_PARAM_NAME> <MIN> <MAX> <STEP> <NU> <X0> <Y0> <Z0> "
+                     "<W11> ... <W33> <N_ITER> [--archive|--spec] [--grid=NAME2:MIN2:STEP2:COUNT2] [--on-exists=keep|overwrite|fail]\n";
+        return 1;
+    }
+
     fs::path PARAMS_DIR = argv[1]; // The directory where folders with parameters are stored
     checkLastConfigID(PARAMS_DIR); // Ensures that last_config_id is set to -1 if no wparams_config-XXXXXXX.txt files exist
 
-    const int N_CONFIG_SETS = std::stoi(argv[2]);
-    // Casting control parameter to an int to avoid double type arithmetic errors while iterating
-    std::string CONTROL_PARAM_NAME = argv[3];
-    int CONTROL_PARAM_MIN = static_cast<int>( std::round( std::stod(argv[4])*scaling_factor ) );
-    int CONTROL_PARAM_MAX = static_cast<int>( std::round( std::stod(argv[5])*scaling_factor ) );
-    int CONTROL_PARAM_STEP = static_cast<int>( std::round( std::stod(argv[6])*scaling_factor ) );
-
-    Params wp; // Creating a struct object holding all parameters
-
+    int N_CONFIG_SETS = std::stoi(argv[2]); // number of config IDs of the range (multiplied by COUNT2 with --grid)
+    const std::string CONTROL_PARAM_NAME = argv[3];
+    // CONTROL_PARAM_MAX (argv[5]) does not matter, the range follows from N_CONFIG_SETS and CONTROL_PARAM_STEP.
+    // The control parameter is set to CONTROL_PARAM_MIN + k*CONTROL_PARAM_STEP (regardless of its value in CONFIG.sh),
+    // computed on the decimal grid of the two strings to avoid double type arithmetic errors while iterating
+    SweepSpec spec;
+    spec.control_param_name = CONTROL_PARAM_NAME;
+    spec.param_min = argv[4];
+    spec.param_step = argv[6];
+
+    TrajectoryInfo& wp = spec.base; // Base parameters, the same for all configs but the control parameter
     wp.nu = std::stod(argv[7]);
-
-    wp.x0_ = std::stod(argv[8]); wp.y0_ = std::stod(argv[9]); wp.z0_ = std::stod(argv[10]);
-
-    wp.w11 = std::stod(argv[11]); wp.w12 = std::stod(argv[12]); wp.w13 = std::stod(argv[13]);
-    wp.w21 = std::stod(argv[14]); wp.w22 = std::stod(argv[15]); wp.w23 = std::stod(argv[16]);
-    wp.w31 = std::stod(argv[17]); wp.w32 = std::stod(argv[18]); wp.w33 = std::stod(argv[19]);
-
+    wp.x0 = std::stod(argv[8]); wp.y0 = std::stod(argv[9]); wp.z0 = std::stod(argv[10]);
+    for(int k=0; k<9; k++) wp.w[k] = std::stod(argv[11+k]);
     wp.n_iter = std::stoi(argv[20]);
 
-    double* CONTROL_PARAM_PTR; // Pointer to a control parameter. It makes it possible to change the value of the parameter specified in CONFIG.sh file
-
-    switch(hashControlParamName(CONTROL_PARAM_NAME))
+    bool TO_ARCHIVE = false, TO_SPEC = false;
+    OnExists ON_EXISTS = OnExists::keep;
+    for(int i=21; i<argc; i++)
     {
-        case ControlParamNameCode::nu:
-            CONTROL_PARAM_PTR = &wp.nu;
-            break;
-
-        case ControlParamNameCode::x0_:
-            CONTROL_PARAM_PTR = &wp.x0_;
-            break;
-        case ControlParamNameCode::y0_:
-            CONTROL_PARAM_PTR = &wp.y0_;
-            break;
-        case ControlParamNameCode::z0_:
-            CONTROL_PARAM_PTR = &wp.z0_;
-            break;
-
-        case ControlParamNameCode::w11:
-            CONTROL_PARAM_PTR = &wp.w11;
-            break;
-        case ControlParamNameCode::w12:
-            CONTROL_PARAM_PTR = &wp.w12;
-            break;
-        case ControlParamNameCode::w13:
-            CONTROL_PARAM_PTR = &wp.w13;
-            break;
-        case ControlParamNameCode::w21:
-            CONTROL_PARAM_PTR = &wp.w21;
-            break;
-        case ControlParamNameCode::w22:
-            CONTROL_PARAM_PTR = &wp.w22;
-            break;
-        case ControlParamNameCode::w23:
-            CONTROL_PARAM_PTR = &wp.w23;
-            break;
-        case ControlParamNameCode::w31:
-            CONTROL_PARAM_PTR = &wp.w31;
-            break;
-        case ControlParamNameCode::w32:
-            CONTROL_PARAM_PTR = &wp.w32;
-            break;
-        case ControlParamNameCode::w33:
-            CONTROL_PARAM_PTR = &wp.w33;
-            break;
-        
-        case ControlParamNameCode::unknown:
-            std::cerr << "\033[31mWRONG 'CONTROL_PARAM_NAME': \033[0" << CONTROL_PARAM_NAME << std::endl;
-            std::cerr << "\033[31mFAILED TO CREATE PARAMETER FILES\033[0" << std::endl;
+        std::string arg = argv[i];
+        if(arg == "--archive") TO_ARCHIVE = true;
+        else if(arg == "--spec") TO_SPEC = true;
+        else if(arg.rfind("--grid=", 0) == 0)
+        {
+            // NAME2:MIN2:STEP2:COUNT2
+            std::istringstream iss(arg.substr(7));
+            std::string count2;
+            std::getline(iss, spec.control_param_name2, ':');
+            std::getline(iss, spec.param_min2, ':');
+            std::getline(iss, spec.param_step2, ':');
+            std::getline(iss, count2);
+            spec.n_values2 = count2.empty() ? 0 : std::stoi(count2);
+            if(trajectoryParam(wp, spec.control_param_name2) == nullptr || spec.control_param_name2 == CONTROL_PARAM_NAME
+               || spec.param_min2.empty() || spec.param_step2.empty() || spec.n_values2 < 1)
+            {
+                std::cerr << "ERROR invalid " << arg << " (expected --grid=NAME2:MIN2:STEP2:COUNT2 with a second control parameter)\n";
+                return 1;
+            }
+            TO_SPEC = true;
+        }
+        else if(arg.rfind("--on-exists=", 0) == 0 && hashOnExists(arg.substr(12)) != OnExists::unknown)
+            ON_EXISTS = hashOnExists(arg.substr(12));
+        else
+        {
+            std::cerr << "ERROR unknown argument " << arg << '\n';
             return 1;
+        }
     }
+    if(TO_ARCHIVE && TO_SPEC)
+    {
+        std::cerr << "ERROR --archive cannot be combined with --spec or --grid\n";
+        return 1;
+    }
+    N_CONFIG_SETS *= spec.n_values2;
 
-    if(FULL_OVERWRITE == true)
+    if(trajectoryParam(wp, CONTROL_PARAM_NAME) == nullptr)
     {
-        FULL_OVERWRITE = false;
-        std::cout << "FULL_OVERWRITE was set 'true' manually. This might cause accidental deletion of all already existing wparams_config-XXXXXXX.txt files.\n";
-        std::cout << "Please consider changing it back to 'false'.\n";
-        std::cout << "NO FILE WAS OVERWRITTEN YET.\n\n";
+        std::cerr << "\033[31mWRONG 'CONTROL_PARAM_NAME': \033[0" << CONTROL_PARAM_NAME << std::endl;
+        std::cerr << "\033[31mFAILED TO CREATE PARAMETER FILES\033[0" << std::endl;
+        return 1;
     }
 
     // Looking up the last config ID (second line in the .txt file) to create proper wparams_config-XXXXXXX.txt names
@@ -284,6 +258,32 @@ int main(int argc, char* argv[])
         return 1;
     }
 
+    spec.id_low = last_config_id + 1;
+    spec.id_high = last_config_id + N_CONFIG_SETS;
+
+    const fs::path wparams_dir = PARAMS_DIR / "wparams" / CONTROL_PARAM_NAME;
+    const fs::path archive_path = PROJECT / "data" / "time-evol" / CONTROL_PARAM_NAME / sweepArchiveName(spec.id_low, spec.id_high);
+    const fs::path spec_path = sweepSpecPath(configFilePath(PARAMS_DIR, last_config_id, N_CONFIG_SETS, CONTROL_PARAM_NAME).string());
+
+    // --on-exists=fail: refusing before anything (last_config_id.txt included) is written
+    if(ON_EXISTS == OnExists::fail)
+    {
+        bool exists = false;
+        if(TO_SPEC) exists = fs::exists(spec_path);
+        else if(TO_ARCHIVE) exists = fs::exists(archive_path);
+        for(int id=spec.id_low; id<=spec.id_high && !TO_SPEC && !TO_ARCHIVE && !exists; id++)
+        {
+            std::ostringstream oss;
+            oss << "wparams_config-" << std::setw(7) << std::setfill('0') << id << ".txt";
+            exists = fs::exists(wparams_dir / oss.str());
+        }
+        if(exists)
+        {
+            std::cerr << "ERROR parameters of configs " << spec.id_low << "-" << spec.id_high << " already exist (--on-exists=fail)\n";
+            return 1;
+        }
+    }
+
     // Saving the CONFIG.sh file with which the wparams_config-XXXXXXX.txt files are generated
     saveConfigFile(PARAMS_DIR, last_config_id, N_CONFIG_SETS, CONTROL_PARAM_NAME);
 
@@ -304,79 +304,55 @@ int main(int argc, char* argv[])
         config_id_list_file.close();
     }
 
-    for(int k=0; k<N_CONFIG_SETS; ++k)
+    if(TO_SPEC == true)
     {
-        last_config_id++;
+        if(fs::exists(spec_path) && ON_EXISTS == OnExists::keep)
+        {
+            std::cout << "Sweep spec " << spec_path << " already exists, kept\n";
+            return 0;
+        }
+        if(!spec.write(spec_path)) return 1;
 
-        double p = (double)(CONTROL_PARAM_MIN + k*CONTROL_PARAM_STEP) / scaling_factor; // This does not care about the chosen control parameter's value set manually in CONFIG.sh, it sets the control parameter to CONTROL_PARAM_MIN and increment it based on CONTROL_PARAM_STEP
+        std::cout << "Sweep spec of configs " << spec.id_low << "-" << spec.id_high;
+        if(spec.isGrid()) std::cout << " (" << spec.rows() << " x " << spec.n_values2 << " grid)";
+        std::cout << " saved to " << spec_path << '\n';
+        return 0;
+    }
 
-        std::ostringstream oss;
-        oss << "wparams_config-" << std::setw(7) << std::setfill('0') << last_config_id << ".txt"; // Path to a file holding parameters
-        fs::path filePath = PARAMS_DIR / "wparams" / CONTROL_PARAM_NAME / oss.str();
+    if(TO_ARCHIVE == true)
+    {
+        fs::create_directories(archive_path.parent_path());
+
+        SweepArchive archive;
+        if(!archive.open(archive_path, spec.id_low, spec.id_high)) return 1;
 
-        if(fs::exists(filePath) && FULL_OVERWRITE == false)
+        for(int id=spec.id_low; id<=spec.id_high; ++id)
         {
-            if(FULL_KEEP == true) continue; // This line ensures that all pre-existing files would not get overwritten if the user specified it
+            // Entries that already hold parameters or results are kept unless --on-exists=overwrite (which drops the
+            // result of the entry)
+            if(archive.entry(id).status != archive_empty && ON_EXISTS == OnExists::keep) continue;
 
-            std::cout << "File " << filePath << " already exists.\n";
-            std::cout << "Do you want to OVERWRITE it? Type 'yes/no' (type 'ALL/KEEP' to OVERWRITE/KEEP all already existing wparams_config-XXXXXXX.txt files).\n";
-            
-            while(true)
+            if(!archive.setEntry(sweepArchiveEntry(id, spec.config(id))))
             {
-                std::string to_overwrite;
-                std::cin >> to_overwrite;
-
-                switch(hashString(to_overwrite))
-                {
-                    case StringCode::yes:
-                        createFile(filePath, wp, CONTROL_PARAM_PTR, p);
-                        break;
-                    case StringCode::no:
-                        break;
-                    case StringCode::ALL:
-                        std::cout << "ARE YOU SURE YOU WANT TO OVERWRITE ALL EXISTING wparams_config-XXXXXXX.txt FILES?\n";
-                        std::cout << "Type 'yes/no' to confirm:\n";
-
-                        while(true)
-                        {
-                            std::string confirm;
-                            std::cin >> confirm;
-
-                            switch(hashString(confirm))
-                            {
-                                case StringCode::yes:
-                                    FULL_OVERWRITE = true;
-                                    createFile(filePath, wp, CONTROL_PARAM_PTR, p);
-                                    std::cout << "ALL pre-existing files will be overwritten\n";
-                                    break;
-                                case StringCode::no:
-                                    std::cout << "Overwriting of ALL files was canceled. Your files are safe.\n";
-                                    break;
-                                case StringCode::ALL:
-                                    std::cout << "Invalid input. Please type 'yes/no' to continue.\n";
-                                    continue;
-                                case StringCode::KEEP:
-                                    std::cout << "Invalid input. Please type 'yes/no' to continue.\n";
-                                    continue;
-                                case StringCode::unknown:
-                                    std::cout << "Invalid input. Please type 'yes/no' to continue.\n";
-                                    continue;
-                            }
-                            break;
-                        }
-                        break;
-                    case StringCode::KEEP:
-                        FULL_KEEP = true;
-                        break;
-                    case StringCode::unknown:
-                        std::cout << "Invalid input. Please type 'yes/no' or 'ALL' to continue.\n";
-                        continue;
-                }
-                break;
+                std::cerr << "ERROR writing the parameters of config " << id << " to " << archive_path << '\n';
+                return 1;
             }
         }
-        else if(fs::exists(filePath) == false || FULL_OVERWRITE == true)
-            createFile(filePath, wp, CONTROL_PARAM_PTR, p);
+
+        std::cout << "Parameters saved to " << archive_path << '\n';
+        return 0;
+    }
+
+    for(int id=spec.id_low; id<=spec.id_high; ++id)
+    {
+        std::ostringstream oss;
+        oss << "wparams_config-" << std::setw(7) << std::setfill('0') << id << ".txt"; // Path to a file holding parameters
+        fs::path filePath = wparams_dir / oss.str();
+
+        // Pre-existing files are only rewritten with --on-exists=overwrite (--on-exists=fail has stopped above)
+        if(fs::exists(filePath) && ON_EXISTS == OnExists::keep) continue;
+
+        createFile(filePath, spec.config(id));
     }
     
     return 0;
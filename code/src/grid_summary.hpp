@@ -0,0 +1,169 @@
+#pragma once
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include <string>
+
+#include "trajectory_io.hpp"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Grid summary file of a parameter-plane sweep (sweep --grid): one fixed-size record per point of a gen_params range,
+ * so that a whole 2D phase diagram is one file instead of rows*cols trajectories (all little-endian):
+ *
+ *      offset   0  GridHeader (128 bytes)
+ *             128  one record per config ID id_low..id_high, in ID order (row by row, see sweep_spec.hpp):
+ *                  GridPoint (104 bytes), then the last n_samples steps of the tail as x, y, z (float64) per step
+ *
+ * The file is allocated in full when it is created, points that have not been solved yet have status grid_empty.
+ * Every record is written with a single pwrite at its fixed position, so the threads of a sweep and the shards of
+ * one range (several processes) fill the same file without further locking; creating the file is done under flock.
+ */
+enum GridPointStatus : std::int32_t
+{
+    grid_empty = 0,  // not solved yet
+    grid_done = 1,
+    grid_failed = 2
+};
+
+struct GridHeader
+{
+    char magic[8];              // "HFGRID01"
+    std::uint32_t header_size;  // 128
+    std::uint32_t record_size;  // sizeof(GridPoint) + 24*n_samples
+    std::int64_t id_low, id_high;
+    std::int32_t rows, cols;    // values of the first and of the second control parameter
+    std::int32_t tail;          // steps summarised per point (the last 'tail' steps)
+    std::int32_t n_samples;     // tail steps stored per point
+    std::int64_t n_iter;
+    char param_name[16];        // first control parameter (rows)
+    char param_name2[16];       // second control parameter (columns), "" for a 1D range
+    char reserved[40];
+};
+
+struct GridPoint
+{
+    std::int64_t config_id;
+    std::int32_t status;        // GridPointStatus
+    std::int32_t n_tail;        // steps summarised
+    double param, param2;       // values of the two control parameters (param2 NaN for a 1D range)
+    double min[3], max[3], mean[3]; // of x, y, z over the tail
+};
+
+static_assert(sizeof(GridHeader) == 128, "unexpected GridHeader layout");
+static_assert(sizeof(GridPoint) == 104, "unexpected GridPoint layout");
+
+constexpr char grid_magic[8] = {'H', 'F', 'G', 'R', 'I', 'D', '0', '1'};
+
+inline std::string gridFileName(int id_low, int id_high)
+{
+    std::ostringstream oss;
+    oss << "grid_config-" << std::setw(7) << std::setfill('0') << id_low << "-" << std::setw(7) << std::setfill('0') << id_high << ".bin";
+    return oss.str();
+}
+
+// Summary of the tail x[k], y[k], z[k] (k < n) of one point
+inline GridPoint gridPoint(std::int64_t config_id, double param, double param2, const double* x, const double* y, const double* z, int n)
+{
+    GridPoint p {};
+    p.config_id = config_id;
+    p.status = grid_done;
+    p.n_tail = n;
+    p.param = param;
+    p.param2 = param2;
+    const double* v[3] = {x, y, z};
+    for(int c=0; c<3; c++)
+    {
+        p.min[c] = std::numeric_limits<double>::infinity();
+        p.max[c] = -p.min[c];
+        double sum = 0.0;
+        for(int k=0; k<n; k++)
+        {
+            p.min[c] = std::min(p.min[c], v[c][k]);
+            p.max[c] = std::max(p.max[c], v[c][k]);
+            sum += v[c][k];
+        }
+        p.mean[c] = (n > 0) ? sum / n : std::numeric_limits<double>::quiet_NaN();
+    }
+    return p;
+}
+
+class GridFile
+{
+    int fd {-1};
+    GridHeader header {};
+    std::string path;
+
+public:
+    GridFile() = default;
+    GridFile(const GridFile&) = delete;
+    GridFile& operator=(const GridFile&) = delete;
+    ~GridFile() {if(fd >= 0) close(fd);}
+
+    // Opens the grid file of the range described by 'expected' (magic and sizes are filled in), creating it if needed.
+    // Returns false (after printing the error) if it cannot be opened or belongs to a different grid.
+    bool open(const std::string& path_, GridHeader expected)
+    {
+        path = path_;
+        std::memcpy(expected.magic, grid_magic, sizeof(expected.magic));
+        expected.header_size = sizeof(GridHeader);
+        expected.record_size = sizeof(GridPoint) + 3 * sizeof(double) * expected.n_samples;
+
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if(fd < 0)
+        {
+            std::cerr << "ERROR opening " << path << '\n';
+            return false;
+        }
+
+        flock(fd, LOCK_EX);
+        struct stat st;
+        bool ok = fstat(fd, &st) == 0;
+        if(ok && st.st_size == 0)
+        {
+            const off_t length = expected.header_size + (off_t)expected.record_size * (expected.id_high - expected.id_low + 1);
+            ok = pwriteAll(fd, &expected, sizeof(expected), 0) && ftruncate(fd, length) == 0;
+            header = expected;
+            if(!ok) std::cerr << "ERROR creating grid file " << path << '\n';
+        }
+        else if(ok)
+        {
+            ok = pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header)
+                 && std::memcmp(&header, &expected, offsetof(GridHeader, reserved)) == 0;
+            if(!ok) std::cerr << "ERROR " << path << " is a grid file of a different sweep (range, tail, --grid-samples)\n";
+        }
+        flock(fd, LOCK_UN);
+        return ok;
+    }
+
+    const GridHeader& info() const {return header;}
+
+    // Stores point p and its last n_samples tail steps (x, y, z of each step; fewer are padded with NaN)
+    bool write(const GridPoint& p, const std::vector<double>& samples)
+    {
+        std::vector<char> record(header.record_size, 0);
+        std::memcpy(record.data(), &p, sizeof(p));
+        double* s = (double*)(record.data() + sizeof(GridPoint));
+        const size_t n_values = 3 * (size_t)header.n_samples;
+        for(size_t k=0; k<n_values; k++) s[k] = (k < samples.size()) ? samples[k] : std::numeric_limits<double>::quiet_NaN();
+
+        const std::int64_t offset = header.header_size + (std::int64_t)header.record_size * (p.config_id - header.id_low);
+        if(!pwriteAll(fd, record.data(), record.size(), offset))
+        {
+            std::cerr << "ERROR writing config " << p.config_id << " to " << path << '\n';
+            return false;
+        }
+        return true;
+    }
+};
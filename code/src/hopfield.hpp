@@ -0,0 +1,1819 @@
+#pragma once
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <filesystem>
+#include <sstream>
+#include <cmath>
+#include <complex>
+#include <vector>
+#include <algorithm>
+#include <tuple>
+#include <string>
+#include <memory>
+#include <functional>
+#include <cstring>
+#include <gsl/gsl_errno.h>
+#include <gsl/gsl_odeiv2.h>
+#include <gsl/gsl_sf_gamma.h>
+
+#include "thread_pool.hpp"
+#include "kernel_cache.hpp"
+#include "simd_dot.hpp"
+#include "trajectory_io.hpp"
+#include "checkpoint.hpp"
+#include "telemetry.hpp"
+#include "sweep_spec.hpp"
+#include "engine_tuning.hpp"
+
+namespace fs = std::filesystem;
+
+/*
+ * ##################################################################################################
+ *      [w11 w12 w13]                                                                               |
+ *  W = [w21 w22 w23] , where wij is the weight between i-th and j-th neurons                       |
+ *      [w31 w32 w33]                                                                               |
+ *                                                                                                  |
+ *  The following convention was adopted: (1 -> x), (2 -> y), (3 -> z) as this model operates with  |
+ *  only three neurons.                                                                             |
+ *                                                                                                  |
+ * ##################################################################################################
+ */ 
+struct Params
+{
+    double nu;
+
+    double x0, y0, z0;
+
+    double w11, w12, w13;
+    double w21, w22, w23;
+    double w31, w32, w33;
+
+    int n_iter {-1};                   // stays -1 if the parameters could not be read
+
+    Params(std::string filename_wparams_) {setParams(filename_wparams_);} // wparams file or "<sweep spec>#<config ID>"
+    Params(const TrajectoryInfo& info) {setParams(info);}
+
+private:
+    void setParams(const TrajectoryInfo& info)
+    {
+        nu = info.nu;
+        x0 = info.x0; y0 = info.y0; z0 = info.z0;
+        w11 = info.w[0]; w12 = info.w[1]; w13 = info.w[2];
+        w21 = info.w[3]; w22 = info.w[4]; w23 = info.w[5];
+        w31 = info.w[6]; w32 = info.w[7]; w33 = info.w[8];
+        n_iter = (int)info.n_iter;
+    }
+
+    void setParams(const std::string& filename)
+    {
+        // Config of a sweep spec (gen_params --spec), materialised without a wparams file
+        std::string spec_path;
+        int config_id;
+        if(splitSpecPath(filename, spec_path, config_id))
+        {
+            SweepSpec spec;
+            if(!spec.read(spec_path)) return;
+            if(!spec.contains(config_id))
+            {
+                std::cerr << "ERROR config " << config_id << " is not in " << spec_path << '\n';
+                return;
+            }
+            setParams(spec.config(config_id));
+            return;
+        }
+
+        std::ifstream file(filename);
+        
+        if(!file.is_open())
+        {
+            std::cerr << "ERROR opening " << filename << std::endl;
+            return;
+        }
+
+        std::string line;
+
+        // getting nu parameter
+        std::getline(file, line);
+        nu = std::stod(line);
+
+        // getting initial state of the system: x0, y0, z0
+        std::getline(file, line);
+        std::istringstream iss_xyz0(line);
+
+        std::vector<double> XYZ0;
+        double xyz0;
+        while(iss_xyz0 >> xyz0)
+        {
+            XYZ0.push_back(xyz0);
+        }
+
+        x0 = XYZ0[0]; y0 = XYZ0[1]; z0 = XYZ0[2];
+
+        // getting the weights w11, w12, ..., w32, w33
+        std::vector<double> W;
+        while(std::getline(file, line))
+        {
+            std::istringstream iss_w(line);
+
+            double wvalue;
+            while(iss_w >> wvalue)
+            {
+                W.push_back(wvalue);
+            }
+        }
+
+        w11 = W[0]; w12 = W[1]; w13 = W[2];
+        w21 = W[3]; w22 = W[4]; w23 = W[5];
+        w31 = W[6]; w32 = W[7]; w33 = W[8];
+
+        std::getline(file, line);
+        n_iter = std::stoi(line);
+
+        return;
+    }
+};
+
+#if defined(__AVX512F__)
+constexpr int SIMD_DOUBLES = 8;
+#elif defined(__AVX__)
+constexpr int SIMD_DOUBLES = 4;
+#else
+constexpr int SIMD_DOUBLES = 2;
+#endif
+
+// W doubles processed as one SIMD register (GCC/Clang vector extension, unaligned loads allowed)
+template<int W>
+struct LaneVector
+{
+    typedef double type __attribute__((vector_size(W*sizeof(double)), aligned(sizeof(double))));
+};
+
+/*
+ * Cache-blocked, register-tiled history kernel shared by the 'tiled' and 'threaded' engines (HopfieldNetwork::solveTiled).
+ *
+ *      hx[n-n0] += sum_{i=i0}^{i1-1} g[n-1-i] * jsum[3*i],      n0 <= n < n1
+ *
+ * (hy, hz likewise with jsum[3*i+1], jsum[3*i+2]). jsum holds the x/y/z sums interleaved (AoSoA with 3 lanes), so the
+ * three values of one past step come in one cache line. The past steps [i0, i1) are walked in tiles of history_tile
+ * steps (12 KB of jsum + 4 KB of the kernel, both stay in L1) and each tile is applied to the future steps in register
+ * tiles of 3*SIMD_DOUBLES consecutive steps: their kernel values g[n-1-i .. n+3*SIMD_DOUBLES-2-i] are contiguous, so
+ * a SIMD register holds one step per lane and every loaded jsum value feeds 3*SIMD_DOUBLES multiply-adds. Three
+ * registers per neuron give 9 independent accumulator chains, enough to hide the latency of the adds.
+ * Every lane still runs over i in ascending order starting from h[n-n0], i.e. calling this for consecutive ranges
+ * [0, i1) gives bit for bit the sums of HopfieldNetwork::solve() with the scalar kernel (--simd=scalar; same
+ * -ffp-contract caveat as for HopfieldBatch).
+ */
+constexpr int history_tile = 512;
+
+inline void accumulateHistory(const double* g, const double* jsum, int i0, int i1, int n0, int n1,
+                              double* hx, double* hy, double* hz)
+{
+    constexpr int W = SIMD_DOUBLES;
+    typedef typename LaneVector<W>::type V;
+
+    for(int p0=i0; p0<i1; p0+=history_tile)
+    {
+        const int p1 = std::min(p0 + history_tile, i1);
+
+        int n = n0;
+        for(; n+3*W<=n1; n+=3*W)
+        {
+            double* hxn = hx + (n-n0);
+            double* hyn = hy + (n-n0);
+            double* hzn = hz + (n-n0);
+            V x0, x1, x2, y0, y1, y2, z0, z1, z2;
+            std::memcpy(&x0, hxn, sizeof(V)); std::memcpy(&x1, hxn + W, sizeof(V)); std::memcpy(&x2, hxn + 2*W, sizeof(V));
+            std::memcpy(&y0, hyn, sizeof(V)); std::memcpy(&y1, hyn + W, sizeof(V)); std::memcpy(&y2, hyn + 2*W, sizeof(V));
+            std::memcpy(&z0, hzn, sizeof(V)); std::memcpy(&z1, hzn + W, sizeof(V)); std::memcpy(&z2, hzn + 2*W, sizeof(V));
+
+            const double* gn = g + (n-1);
+            for(int i=p0; i<p1; i++)
+            {
+                const V g0 = *(const V*)(gn - i);
+                const V g1 = *(const V*)(gn - i + W);
+                const V g2 = *(const V*)(gn - i + 2*W);
+                const double fx = jsum[3*i], fy = jsum[3*i+1], fz = jsum[3*i+2];
+
+                x0 += g0 * fx; x1 += g1 * fx; x2 += g2 * fx;
+                y0 += g0 * fy; y1 += g1 * fy; y2 += g2 * fy;
+                z0 += g0 * fz; z1 += g1 * fz; z2 += g2 * fz;
+            }
+
+            std::memcpy(hxn, &x0, sizeof(V)); std::memcpy(hxn + W, &x1, sizeof(V)); std::memcpy(hxn + 2*W, &x2, sizeof(V));
+            std::memcpy(hyn, &y0, sizeof(V)); std::memcpy(hyn + W, &y1, sizeof(V)); std::memcpy(hyn + 2*W, &y2, sizeof(V));
+            std::memcpy(hzn, &z0, sizeof(V)); std::memcpy(hzn + W, &z1, sizeof(V)); std::memcpy(hzn + 2*W, &z2, sizeof(V));
+        }
+        for(; n<n1; n++)
+        {
+            double xs = hx[n-n0], ys = hy[n-n0], zs = hz[n-n0];
+
+            const double* gn = g + (n-1);
+            for(int i=p0; i<p1; i++)
+            {
+                xs += gn[-i] * jsum[3*i];
+                ys += gn[-i] * jsum[3*i+1];
+                zs += gn[-i] * jsum[3*i+2];
+            }
+
+            hx[n-n0] = xs; hy[n-n0] = ys; hz[n-n0] = zs;
+        }
+    }
+}
+
+/*
+ * Minimal in-place iterative radix-2 FFT used by the 'fft' engine (see HopfieldNetwork::solveFFT).
+ * The twiddle factors are computed once for the largest transform (n_max) and reused with a stride by all smaller
+ * transforms. The inverse transform is NOT normalised (the caller divides by n).
+ * Complex products are written out by hand on purpose: std::complex operator* calls __muldc3 without -ffast-math.
+ */
+struct FFT
+{
+    int n_max;
+    std::vector<double> wre, wim; // twiddle factors exp(-2*pi*i*k/n_max), k = 0, ..., n_max/2 - 1
+
+    FFT(int n_max_) : n_max(n_max_), wre(n_max_/2), wim(n_max_/2)
+    {
+        for(int k=0; k<n_max/2; k++)
+        {
+            wre[k] = std::cos(2.0*M_PI*k/n_max);
+            wim[k] = -std::sin(2.0*M_PI*k/n_max);
+        }
+    }
+
+    // n must be a power of two not greater than n_max
+    void transform(std::complex<double>* a, int n, bool inverse) const
+    {
+        // bit-reversal permutation
+        for(int i=1, j=0; i<n; i++)
+        {
+            int bit = n >> 1;
+            for(; j & bit; bit >>= 1) j ^= bit;
+            j ^= bit;
+            if(i < j) std::swap(a[i], a[j]);
+        }
+
+        const double sign = inverse ? -1.0 : 1.0;
+        for(int len=2; len<=n; len<<=1)
+        {
+            const int half = len/2;
+            const int stride = n_max/len;
+            for(int i=0; i<n; i+=len)
+            {
+                for(int k=0; k<half; k++)
+                {
+                    const double cr = wre[k*stride];
+                    const double ci = sign*wim[k*stride];
+                    const double ur = a[i+k].real(), ui = a[i+k].imag();
+                    const double vr0 = a[i+k+half].real(), vi0 = a[i+k+half].imag();
+                    const double vr = vr0*cr - vi0*ci;
+                    const double vi = vr0*ci + vi0*cr;
+                    a[i+k] = {ur + vr, ui + vi};
+                    a[i+k+half] = {ur - vr, ui - vi};
+                }
+            }
+        }
+    }
+};
+
+/*
+ * Sum-of-exponentials (SOE) approximation of the memory kernel used by the 'soe' engine (see HopfieldNetwork::solveSOE)
+ *
+ *      gammafrac(k) = gamma(k+nu) / gamma(k+1) ~= sum_l weight[l] * exp(-rate[l]*k),      window <= k < n_iter
+ *
+ * For 0 < nu < 1 the kernel is exactly a continuous mixture of decaying exponentials (Beta integral, t = exp(-s)):
+ *
+ *      gammafrac(k) = 1/gamma(1-nu) * int_0^inf exp(-s*(k+nu)) * (1-exp(-s))^(-nu) ds
+ *
+ * After substituting s = exp(u) the integrand decays (double-)exponentially on both ends, so the trapezoidal rule with
+ * a uniform step h in u converges geometrically and every node becomes one exponential mode. The nodes with
+ * rate*n_iter << 1 behave like (almost) constants over the whole run and are lumped into a single mode matching their
+ * first two moments, otherwise nu -> 1 would need thousands of modes. h and the range of u follow from the tolerance, the
+ * achieved deviation from the exact kernel is estimated afterwards on a sample of lags (measureDeviation).
+ */
+struct SumOfExponentials
+{
+    std::vector<double> rate, weight;
+
+    // Deviation of the approximate kernel from gammafrac(k) over window <= k < n_iter, estimated by measureDeviation()
+    double max_abs_dev {0.0}; // max_k |sum_l weight[l]*exp(-rate[l]*k) - gammafrac(k)|
+    double max_rel_dev {0.0}; // same, relative to gammafrac(k)
+    double sum_abs_dev {0.0}; // sum_k |...| i.e. the worst-case error of the memory sum per unit of |xjsum|
+
+    SumOfExponentials(double nu, int window, int n_iter, double tol)
+    {
+        const double gamma1mnu = gsl_sf_gamma(1.0-nu);
+
+        // Integrand in u for the rate s = exp(u), without the exp(-s*k) factor
+        auto density = [&](double u) {
+            const double s = std::exp(u);
+            return s * std::exp(-s*nu) * std::pow(-std::expm1(-s), -nu) / gamma1mnu;
+        };
+
+        const double log_inv_tol = std::log(1.0/tol);
+
+        // Upper end: exp(-s*(window+nu)) < tol for larger s
+        const double u_max = std::log( (log_inv_tol + 1.0) / (window + nu) );
+
+        // Lower end: either simply truncate (tail mass below tol) or lump the nodes with s*n_iter < delta into one mode
+        const double u_trunc = std::log( tol * (1.0-nu) * gamma1mnu ) / (1.0-nu);
+        const double delta = 0.25 * std::sqrt( 2.0 * tol * (1.0-nu) * gamma1mnu ); // safety factor 4 on the 2nd moment bound
+        const double u_lump = std::log( delta / n_iter );
+        const double u_min = std::max(u_trunc, u_lump);
+
+        // Trapezoidal step: the integrand is analytic in the strip |Im u| < pi/2, use half of it
+        const double h = (M_PI*M_PI/2.0) / (log_inv_tol + 2.0);
+
+        double u = u_max;
+        for(; u>=u_min; u-=h)
+        {
+            rate.push_back(std::exp(u));
+            weight.push_back(h * density(u));
+        }
+
+        if(u_lump > u_trunc)
+        {
+            // The remaining trapezoidal nodes (all with rate*n_iter < delta) are replaced by one mode with the same
+            // zeroth and first moment. Summing the nodes (and not the integral) keeps the quadrature exponentially accurate.
+            // Below s = 1e-8 the density is s^(1-nu)/gamma(1-nu) to double precision and the rest of the sum is geometric.
+            double w0 {0.0}, w1 {0.0};
+            for(; u>std::log(1e-8); u-=h)
+            {
+                w0 += h * density(u);
+                w1 += h * density(u) * std::exp(u);
+            }
+            w0 += h * std::exp((1.0-nu)*u) / gamma1mnu / ( 1.0 - std::exp(-(1.0-nu)*h) );
+            w1 += h * std::exp((2.0-nu)*u) / gamma1mnu / ( 1.0 - std::exp(-(2.0-nu)*h) );
+            rate.push_back(w1 / w0);
+            weight.push_back(w0);
+        }
+    }
+
+    int size() const {return (int)rate.size();}
+
+    // Compares the approximation with the exact kernel on a log-spaced sample of lags (every lag up to window+64, then
+    // 0.5% apart) and charges every lag of a gap with the larger deviation at its two ends for the sum. This is an
+    // estimate (the maximum can be missed by a small factor, the sum rather errs on the high side), but it costs
+    // O(size() * log(n_iter)) instead of two lngamma calls and O(size()) work for every lag below n_iter.
+    void measureDeviation(double nu, int window, int n_iter)
+    {
+        const int K = size();
+
+        max_abs_dev = max_rel_dev = sum_abs_dev = 0.0;
+        double dev_prev {0.0};
+        for(long long k=window, k_prev=window; k<n_iter; )
+        {
+            double approx {0.0};
+            for(int l=0; l<K; l++) approx += weight[l] * std::exp(-rate[l]*k);
+
+            const double exact = std::exp( gsl_sf_lngamma(k+nu) - gsl_sf_lngamma(k+1) );
+            const double dev = std::fabs(approx - exact);
+            max_abs_dev = std::max(max_abs_dev, dev);
+            max_rel_dev = std::max(max_rel_dev, dev/exact);
+            sum_abs_dev += (k == window) ? dev : dev + (k - k_prev - 1) * std::max(dev, dev_prev);
+
+            dev_prev = dev;
+            k_prev = k;
+            // next lag, the last one (n_iter-1) is always included
+            const long long k_next = (k < window + 64) ? k+1 : std::max(k+1, (long long)(k * 1.005));
+            k = (k < n_iter-1 && k_next > n_iter-1) ? n_iter-1 : k_next;
+        }
+    }
+};
+
+// Engine selection and engine-specific settings shared by time-evol and sweep (see HopfieldNetwork::run)
+struct SolverOptions
+{
+    std::string engine {"cached"}; // 'cached', 'tiled', 'threaded', 'fft', 'soe', 'short', 'naive' (HopfieldNetwork::engines)
+                                   // or 'auto' (chosen from the tuning profile, see tuned())
+    double soe_tol {1e-10};        // target accuracy of the 'soe' kernel approximation
+    int memory_length {10000};     // number of lags kept by the 'short' engine
+    int block_size {2048};         // steps per history/local block of the 'tiled' and 'threaded' engines
+    int engine_threads {0};        // threads used by the 'threaded' engine for one trajectory (0 = all hardware threads),
+                                   // with 'auto' the most the chosen engine may use (0 = the CPUs of this process)
+    std::string simd {"auto"};     // memory sum kernel of the 'cached' engine: 'auto', 'scalar', 'sse2', 'avx2' or 'avx512'
+    std::string kernel {"recurrence"}; // how gammafrac_cache is built: 'recurrence' or 'lngamma' (see kernel_cache.hpp)
+    std::string format {"csv"};    // output file format: 'csv', 'bin' (float64 columns) or 'bin32' (see trajectory_io.hpp)
+    bool async_output {true};      // output written by a separate thread (AsyncTrajectoryWriter), off with --sync-output
+    int tail {0};                  // only the last 'tail' steps are written (0 = all)
+    int transient {0};             // only the steps n >= transient are written
+    bool lod {false};              // level-of-detail sidecar <output file>.lod for plotting (LodPyramidWriter)
+    double checkpoint {0};         // seconds between checkpoints to <output file>.ckpt (0 = none, see checkpoint.hpp)
+    bool resume {false};           // continue from <output file>.ckpt if there is one
+    bool continue_run {false};     // extend an existing trajectory instead of starting at step 1
+    std::string continue_from;     // trajectory to extend ("" = the output file itself)
+    int n_iter {0};                // overrides n_iter of the params file (0 = keep it)
+
+    // Consumes one --engine=..., --soe-tol=..., --memory-length=..., --block-size=..., --engine-threads=..., --simd=...,
+    // --kernel=..., --format=..., --sync-output, --tail=..., --transient=..., --lod, --checkpoint=..., --resume, --continue[=...] or
+    // --n-iter=... argument, returns false for anything else
+    bool parse(const std::string& arg)
+    {
+        if(arg.rfind("--engine=", 0) == 0) engine = arg.substr(9);
+        else if(arg.rfind("--soe-tol=", 0) == 0) soe_tol = std::stod(arg.substr(10));
+        else if(arg.rfind("--memory-length=", 0) == 0) memory_length = std::stoi(arg.substr(16));
+        else if(arg.rfind("--block-size=", 0) == 0) block_size = std::stoi(arg.substr(13));
+        else if(arg.rfind("--engine-threads=", 0) == 0) engine_threads = std::stoi(arg.substr(17));
+        else if(arg.rfind("--simd=", 0) == 0) simd = arg.substr(7);
+        else if(arg.rfind("--kernel=", 0) == 0) kernel = arg.substr(9);
+        else if(arg.rfind("--format=", 0) == 0) format = arg.substr(9);
+        else if(arg == "--sync-output") async_output = false;
+        else if(arg.rfind("--tail=", 0) == 0) tail = std::stoi(arg.substr(7));
+        else if(arg.rfind("--transient=", 0) == 0) transient = std::stoi(arg.substr(12));
+        else if(arg == "--lod") lod = true;
+        else if(arg.rfind("--checkpoint=", 0) == 0) checkpoint = std::stod(arg.substr(13));
+        else if(arg == "--resume") resume = true;
+        else if(arg == "--continue") continue_run = true;
+        else if(arg.rfind("--continue=", 0) == 0)
+        {
+            continue_run = true;
+            continue_from = arg.substr(11);
+        }
+        else if(arg.rfind("--n-iter=", 0) == 0) n_iter = std::stoi(arg.substr(9));
+        else return false;
+        return true;
+    }
+
+    // Identity of the numbers the selected engine produces (result cache key): 'tiled', 'threaded' and 'cached' with the
+    // scalar kernel write byte-identical files and share one identity, the other engines include the settings their
+    // results depend on; a kernel method other than the default is appended to all of them
+    std::string engineKey() const
+    {
+        std::ostringstream oss;
+        oss << std::hexfloat;
+        if(engine == "tiled" || engine == "threaded") oss << "exact";
+        else if(engine == "cached")
+        {
+            const std::string isa = selectTripleDot(simd).name;
+            oss << (isa == "scalar" ? "exact" : "cached-" + isa);
+        }
+        else if(engine == "soe") oss << "soe:tol=" << soe_tol;
+        else if(engine == "short") oss << "short:L=" << memory_length;
+        else oss << engine;
+        if(kernel != "recurrence") oss << ":kernel=" << kernel;
+        return oss.str();
+    }
+
+    // These settings with --engine=auto replaced by the fastest exact engine, block size and thread count the tuning
+    // profile of this machine has for n_iter steps (see engine_tuning.hpp); 'cached' if there is no profile
+    SolverOptions tuned(int n_iter) const
+    {
+        if(engine != "auto") return *this;
+
+        SolverOptions options = *this;
+        TunedEngine choice;
+        double seconds;
+        const int max_threads = (engine_threads > 0) ? engine_threads : availableCpus();
+        if(TuningProfile::current().choose(n_iter, max_threads, choice, seconds))
+        {
+            options.engine = choice.engine;
+            if(choice.block_size > 0) options.block_size = choice.block_size;
+            options.engine_threads = choice.threads;
+        }
+        else options.engine = "cached";
+        return options;
+    }
+
+    // First step written to the output file of an n_iter-step run (tail mode), 0 if the whole trajectory is written
+    int firstStep(int n_iter) const
+    {
+        int n_first = std::max(transient, 0);
+        if(tail > 0) n_first = std::max(n_first, n_iter - tail);
+        return std::min(n_first, std::max(n_iter - 1, 0));
+    }
+};
+
+class HopfieldNetwork
+{
+    double x0, y0, z0;
+    Params* wp; // wp - weight parameters including nu which is the order of fractional difference equation (wparams)
+    int n_iter;
+
+public:
+    std::vector<double> x, y, z;
+
+    bool verbose {true}; // progress/diagnostic messages on std::cout (switched off when many networks run in one process)
+    std::string output_format {"csv"}; // 'csv', 'bin' or 'bin32' (see trajectory_io.hpp)
+    bool async_output {true};          // output file written by a separate thread (see AsyncTrajectoryWriter)
+    int first_step {0};                // steps before first_step are not written (tail mode, SolverOptions::firstStep)
+    bool lod {false};                  // level-of-detail sidecar next to the output file (see LodPyramidWriter)
+    double checkpoint_interval {0};    // seconds between checkpoints to <output file>.ckpt, 0 = none (see checkpoint.hpp)
+    bool resume {false};               // continue from <output file>.ckpt if there is one
+    std::string continue_path;         // existing trajectory that is extended (--continue), "" = none
+    bool started {false};              // the engine got past startTrajectory() (and then runs to the last step)
+    const GammafracKernel* shared_kernel {nullptr}; // kernel loaded once for many networks with this nu (SharedKernels)
+    int kernel_anchors {kernel_anchor_interval};    // anchor interval of the kernel, 1 = all from lngamma (--kernel)
+    RunTelemetry* telemetry {nullptr};  // phase timers, heartbeat and summary of the run (time-evol, see telemetry.hpp)
+
+    // Replaces the output file of the engines if set ('filename' is then ignored), e.g. to collect the tails of many
+    // runs in one aggregated file (sweep --bifur)
+    std::function<std::unique_ptr<TrajectoryWriter>()> output_writer;
+
+    // Constructor enabling user to specify initial state of the system
+    HopfieldNetwork(double x0_, double y0_, double z0_, void* wparams_, int n_iter_=-1) : x0(x0_), y0(y0_), z0(z0_)
+    {
+        wp = static_cast<Params*>(wparams_);
+
+        // Number of time-evol iterations
+        if(n_iter_ == -1) n_iter = wp->n_iter;
+        else n_iter = n_iter_;
+
+        // Vectors holding the neurons' state (only the initial state here, engines that keep the whole trajectory
+        // extend them with allocateTrajectory())
+        x = std::vector<double>(1, x0);
+        y = std::vector<double>(1, y0);
+        z = std::vector<double>(1, z0);
+    }
+
+    // Constructor that uses the initial state of the system specified in the file
+    HopfieldNetwork(void* wparams_)
+    {
+        wp = static_cast<Params*>(wparams_);
+
+        n_iter = wp->n_iter;
+
+        x0 = wp->x0;
+        y0 = wp->y0;
+        z0 = wp->z0;
+
+        // Vectors holding the neurons' state (only the initial state here, engines that keep the whole trajectory
+        // extend them with allocateTrajectory())
+        x = std::vector<double>(1, x0);
+        y = std::vector<double>(1, y0);
+        z = std::vector<double>(1, z0);
+    }
+
+private:
+    // Output file of the engines in output_format, nullptr if it cannot be opened
+    std::unique_ptr<TrajectoryWriter> openTrajectory(const std::string& filename) const
+    {
+        if(output_writer) return output_writer();
+        return openTrajectoryWriter(filename, output_format, trajectoryInfo(*wp, n_iter, first_step), async_output, lod);
+    }
+
+    // Reads the trajectory extended by --continue (continue_path) into xc, yc, zc and checks that it belongs to this
+    // run; returns false (after printing the error) otherwise
+    bool loadContinued(std::vector<double>& xc, std::vector<double>& yc, std::vector<double>& zc) const
+    {
+        TrajectoryInfo prior;
+        std::uint32_t value_size;
+        if(!readTrajectory(continue_path, xc, yc, zc, prior, value_size)) return false;
+
+        const TrajectoryInfo own = trajectoryInfo(*wp, n_iter);
+        if(prior.n_first != 0)
+        {
+            std::cerr << "ERROR " << continue_path << " holds only the steps from " << prior.n_first
+                      << " on (tail mode), --continue needs the whole trajectory\n";
+            return false;
+        }
+        if(xc.empty() || (std::int64_t)xc.size() > n_iter)
+        {
+            std::cerr << "ERROR " << continue_path << " has " << xc.size() << " steps, n_iter is " << n_iter << '\n';
+            return false;
+        }
+        if((value_size != 0 && (prior.nu != own.nu || prior.x0 != own.x0 || prior.y0 != own.y0 || prior.z0 != own.z0
+                                || std::memcmp(prior.w, own.w, sizeof(own.w)) != 0))
+           || std::fabs(xc[0] - x0) > 1e-8 || std::fabs(yc[0] - y0) > 1e-8 || std::fabs(zc[0] - z0) > 1e-8)
+        {
+            std::cerr << "ERROR " << continue_path << " was computed with other parameters\n";
+            return false;
+        }
+        if(value_size != 8)
+            std::cerr << "WARNING " << continue_path << " holds rounded values (" << (value_size == 4 ? "float32" : "CSV")
+                      << "), the new steps are not identical to those of an uninterrupted run\n";
+        return true;
+    }
+
+    /*
+     * Opens the output file ('file') and, with checkpointing on, the checkpoint <filename>.ckpt, and writes the steps
+     * that are already known: the initial state, all steps of the checkpoint when resuming, or all steps of the
+     * trajectory that is extended (--continue). Every restored step n >= 1 is also handed to restore(n, xn, yn, zn),
+     * which has to rebuild the engine state exactly as the step loop would have. Returns the first step left to
+     * compute, -1 if a file cannot be opened.
+     */
+    template<typename Restore>
+    int startTrajectory(std::unique_ptr<TrajectoryWriter>& file, const std::string& filename, const std::string& engine,
+                        Restore&& restore)
+    {
+        // The extended trajectory is read before the output file (possibly the same one) is opened
+        std::vector<double> xc, yc, zc;
+        if(telemetry) telemetry->phase("output");
+        if(!continue_path.empty() && !loadContinued(xc, yc, zc)) return -1;
+
+        file = openTrajectory(filename);
+        if(!file) return -1;
+
+        int n_done = 0;
+        if(checkpoint_interval > 0 || resume)
+        {
+            if(output_writer || filename.empty())
+            {
+                std::cerr << "ERROR checkpoints need a plain output file\n";
+                return -1;
+            }
+
+            const double interval = (checkpoint_interval > 0) ? checkpoint_interval : 600.0;
+            auto checkpoint = std::make_unique<CheckpointWriter>(std::move(file), filename + ".ckpt", trajectoryInfo(*wp, n_iter),
+                                                                 engine, interval);
+            if(!checkpoint->open(resume)) return -1;
+
+            n_done = (int)checkpoint->stepsDone();
+            if(n_done > 0 && verbose) std::cout << "resuming from checkpoint " << filename << ".ckpt at step " << n_done << '\n';
+            if(!checkpoint->restore([&](int n, double xn, double yn, double zn) {if(n > 0) restore(n, xn, yn, zn);})) return -1;
+            file = std::move(checkpoint);
+        }
+        if(telemetry) file = std::make_unique<TelemetryWriter>(std::move(file), *telemetry);
+
+        if(n_done == 0 && !xc.empty())
+        {
+            n_done = (int)xc.size();
+            if(verbose) std::cout << "continuing " << continue_path << " from step " << n_done << " to " << n_iter << '\n';
+            for(int n=0; n<n_done; n++)
+            {
+                file->write(n, xc[n], yc[n], zc[n]);
+                if(n > 0) restore(n, xc[n], yc[n], zc[n]);
+            }
+        }
+
+        if(n_done == 0)
+        {
+            file->write(0, x[0], y[0], z[0]);
+            n_done = 1;
+        }
+        started = true;
+        if(telemetry) telemetry->phase("stepping");
+        return n_done;
+    }
+
+    // gammafrac_cache for this network (its first n entries, all of it by default), mapped from the on-disk kernel cache
+    // when possible (see kernel_cache.hpp)
+    GammafracKernel loadGammafracCache(int n=-1) const
+    {
+        if(n < 0) n = n_iter;
+        if(shared_kernel != nullptr && shared_kernel->size() >= (size_t)n)
+            return GammafracKernel(nullptr, 0, shared_kernel->data(), (size_t)n); // view, not a copy
+        return loadGammafracKernel(wp->nu, n, kernel_anchors, verbose);
+    }
+
+    // Right-hand side of the fractional map evaluated at state (xn, yn, zn), i.e. -xn + wp->w11*tanh(xn) + ... (see the
+    // comment above xjsum_cache in solve()); the order of operations is kept identical in every engine
+    void computeJsum(double xn, double yn, double zn, double& xjsum, double& yjsum, double& zjsum) const
+    {
+        xjsum = -xn +
+                wp->w11*std::tanh(xn) +
+                wp->w12*std::tanh(yn) +
+                wp->w13*std::tanh(zn);
+
+        yjsum = -yn +
+                wp->w21*std::tanh(xn) +
+                wp->w22*std::tanh(yn) +
+                wp->w23*std::tanh(zn);
+
+        zjsum = -zn +
+                wp->w31*std::tanh(xn) +
+                wp->w32*std::tanh(yn) +
+                wp->w33*std::tanh(zn);
+    }
+
+    void computeJsum(int n, double& xjsum, double& yjsum, double& zjsum) const
+    {
+        computeJsum(x[n], y[n], z[n], xjsum, yjsum, zjsum);
+    }
+
+    // Extends x, y, z to the full n_iter steps (the constructors store the initial state only)
+    void allocateTrajectory()
+    {
+        x.resize(n_iter, 0.0);
+        y.resize(n_iter, 0.0);
+        z.resize(n_iter, 0.0);
+    }
+
+public:
+    void displayParams()
+    {
+        std::cout << wp->w11 << " " << wp->w12 << " " << wp->w13 << '\n';
+        std::cout << wp->w21 << " " << wp->w22 << " " << wp->w23 << '\n';
+        std::cout << wp->w31 << " " << wp->w32 << " " << wp->w33 << '\n';
+        std::cout << wp->nu << '\n';
+        std::cout << wp->n_iter << '\n';
+    }
+
+    /*
+     * Reference engine: the defining sum of the map, evaluated term by term with the kernel computed from
+     * gsl_sf_lngamma inside the double loop (the original time-evol/perf_time-evol code), O(n_iter^2) gamma function
+     * evaluations. Kept only to validate the other engines against, it is never selected unless asked for by name.
+     */
+    bool solveNaive(const std::string& filename="")
+    {
+        allocateTrajectory();
+
+        double gammanu = gsl_sf_gamma(wp->nu);
+
+        std::unique_ptr<TrajectoryWriter> file;
+        const int n_start = startTrajectory(file, filename, "naive", [&](int n, double xn, double yn, double zn) {
+            x[n] = xn; y[n] = yn; z[n] = zn;
+        });
+        if(n_start < 0) return false;
+
+        for(int n=n_start; n<n_iter; n++)
+        {
+            double xnsum {0};
+            double ynsum {0};
+            double znsum {0};
+
+            for(int j=1; j<=n; j++)
+            {
+                // gamma(n-j+nu)/gamma(n-j+1) through the logarithms, the gamma functions alone overflow for large n
+                double gammafrac = std::exp( gsl_sf_lngamma(n-j+wp->nu) - gsl_sf_lngamma(n-j+1) );
+
+                double xjsum, yjsum, zjsum;
+                computeJsum(j-1, xjsum, yjsum, zjsum);
+                xnsum += gammafrac * xjsum;
+                ynsum += gammafrac * yjsum;
+                znsum += gammafrac * zjsum;
+            }
+
+            x[n] = x[0] + xnsum / gammanu;
+            y[n] = y[0] + ynsum / gammanu;
+            z[n] = z[0] + znsum / gammanu;
+            file->write(n, x[n], y[n], z[n]);
+        }
+        file->close();
+
+        return true;
+    }
+
+    // Method that computes the states of all three neurons in n_iter steps and saves them to the output file, returns false
+    // if it stopped early (the same holds for every solve*() engine method below)
+    // 'simd' selects the variant of the memory sum kernel (see simd_dot.hpp), 'scalar' reproduces the original summation order
+    // (bit-compatible with older results together with the original kernel, --kernel=lngamma)
+    bool solve(const std::string& filename="", const std::string& simd="auto")
+    {
+        const TripleDot dot = selectTripleDot(simd);
+        if(dot.kernel == nullptr)
+        {
+            std::cerr << "ERROR SIMD kernel '" << simd << "' is unknown or not supported by this CPU\n";
+            return false;
+        }
+
+        allocateTrajectory();
+
+        // calculating value of gamma function for given 'nu'
+        double gammanu = gsl_sf_gamma(wp->nu);
+
+        // Creating variables/objects used for caching repetetive values to avoid ------------------------------------------------------
+        // unnecessary computations
+        
+        const GammafracKernel gammafrac_cache = loadGammafracCache();
+        if(verbose) std::cout << "gammafrac_cache vector created...\n";
+
+        // Reversed copy of the kernel, gammafrac_rev[n_iter-n+j-1] = gammafrac_cache[n-j], so that the memory sum of step n
+        // reads all of its streams in ascending order
+        std::vector<double> gammafrac_rev(gammafrac_cache.size());
+        std::reverse_copy(gammafrac_cache.begin(), gammafrac_cache.end(), gammafrac_rev.begin());
+        if(verbose) std::cout << "memory sum kernel: " << dot.name << '\n';
+
+        /* Vectors initialized right below are used to store results of repetitive calculations of this kind:
+            for(int n=1; n<n_iter; n++)    
+                for(int j=1; j<n; j++) {
+                    xnsum += gammafrac * (
+                        -x[j-1] +                       |
+                        wp->w11*std::tanh(x[j-1]) +     |~~~> this is what's getting stored in xjsum_cache[j-1]
+                        wp->w12*std::tanh(y[j-1]) +     |
+                        wp->w13*std::tanh(z[j-1])       |
+                    );
+                }
+        */
+        std::vector<double> xjsum_cache(n_iter, 0.0);
+        std::vector<double> yjsum_cache(n_iter, 0.0);
+        std::vector<double> zjsum_cache(n_iter, 0.0);
+
+        computeJsum(0, xjsum_cache[0], yjsum_cache[0], zjsum_cache[0]);
+
+        // Creating file for results and writing initial state of the system (n=0), or the checkpointed steps
+        std::unique_ptr<TrajectoryWriter> file;
+        const int n_start = startTrajectory(file, filename, "cached", [&](int n, double xn, double yn, double zn) {
+            x[n] = xn; y[n] = yn; z[n] = zn;
+            computeJsum(n, xjsum_cache[n], yjsum_cache[n], zjsum_cache[n]);
+        });
+        if(n_start < 0) return false;
+
+        for(int n=n_start; n<n_iter; n++)
+        {
+            double xnsum {0};
+            double ynsum {0};
+            double znsum {0};
+
+            // xnsum = sum_{j=1}^{n} gammafrac_cache[n-j] * xjsum_cache[j-1] (ynsum, znsum likewise)
+            dot.kernel(gammafrac_rev.data() + (n_iter-n), xjsum_cache.data(), yjsum_cache.data(), zjsum_cache.data(), n,
+                       xnsum, ynsum, znsum);
+
+            // Caclulating the next step and writing it to the file
+            x[n] = x[0] + xnsum / gammanu;
+            y[n] = y[0] + ynsum / gammanu;
+            z[n] = z[0] + znsum / gammanu;
+            file->write(n, x[n], y[n], z[n]);
+
+            computeJsum(n, xjsum_cache[n], yjsum_cache[n], zjsum_cache[n]);
+        }
+        file->close();
+        
+        return true;
+    }
+
+    /*
+     * Same map as solve() (and the same CSV output), but the memory sum
+     *
+     *      c(m) = sum_{i=0}^{m} gammafrac_cache[m-i] * xjsum_cache[i],     x[m+1] = x[0] + c(m) / gamma(nu)
+     *
+     * is evaluated with a blocked online ("relaxed") convolution instead of the O(n_iter^2) double loop:
+     *
+     *  - lags k < n_direct (the near-diagonal part) are summed directly at every step,
+     *  - every lag k >= n_direct belongs to exactly one band [L, 2L), L = n_direct*2^p. As soon as an aligned block
+     *    xjsum_cache[s..s+L-1] (s a multiple of L) is complete, its product with gammafrac_cache[L..2L-1] is added to
+     *    the accumulators xfar[s+L..s+3L-2]. These entries are needed at the earliest when computing x[s+L+1], so the
+     *    whole product can be evaluated in one go with an FFT of size 2L (small bands are multiplied directly).
+     *
+     * The total cost is O(n_iter log^2 n_iter). x and y share one complex transform (x + i*y, the kernel is real).
+     *
+     * Tolerance: the result differs from solve() only by the rounding of the reordered sum, i.e. |c_fft - c| is of
+     * the order of 1e-15 * log2(n_iter) * sum_k |gammafrac_cache[k] * xjsum_cache[m-k]|, which is far below the 1e-9
+     * resolution of the CSV. For non-chaotic configurations (fixed points, periodic orbits) both engines therefore
+     * write the same file up to +-1 in the last printed digit. On chaotic orbits any change in the summation order
+     * (this one included) is amplified at the rate of the largest Lyapunov exponent, so the trajectories agree only
+     * up to the step where that amplification reaches 1e-9; the attractor itself (e.g. the bifurcation tail) is the same.
+     */
+    bool solveFFT(const std::string& filename="")
+    {
+        allocateTrajectory();
+
+        double gammanu = gsl_sf_gamma(wp->nu);
+
+        const GammafracKernel gammafrac_cache = loadGammafracCache();
+        if(verbose) std::cout << "gammafrac_cache vector created...\n";
+
+        std::vector<double> xjsum_cache(n_iter, 0.0);
+        std::vector<double> yjsum_cache(n_iter, 0.0);
+        std::vector<double> zjsum_cache(n_iter, 0.0);
+
+        computeJsum(0, xjsum_cache[0], yjsum_cache[0], zjsum_cache[0]);
+
+        // Contributions of lags >= n_direct, accumulated ahead of time: xfar[m] is added to c(m)
+        std::vector<double> xfar(n_iter, 0.0);
+        std::vector<double> yfar(n_iter, 0.0);
+        std::vector<double> zfar(n_iter, 0.0);
+
+        const int n_direct = 32;        // lags k < n_direct are summed directly at every step
+        const int fft_min_block = 128;  // bands with L < fft_min_block are multiplied directly (O(L^2) is cheaper there)
+        const int m_max = n_iter - 2;   // largest index of c(m) that is ever needed
+
+        int block_max = n_direct;
+        while(2*block_max <= m_max) block_max *= 2;
+
+        FFT fft(2*block_max);
+        std::vector<std::vector<std::complex<double>>> kernel_spectra; // FFT of gammafrac_cache[L..2L-1] for every band L
+        std::vector<std::complex<double>> buf_xy(2*block_max), buf_z(2*block_max);
+
+        // Spectrum of the kernel band [L, 2L) zero-padded to 2L (computed once per band and reused by every block); lags
+        // above m_max never reach a needed c(m) and are left out
+        auto kernelSpectrum = [&](int L, int level) -> const std::vector<std::complex<double>>& {
+            if(level >= (int)kernel_spectra.size()) kernel_spectra.resize(level+1);
+            std::vector<std::complex<double>>& spectrum = kernel_spectra[level];
+            if(spectrum.empty())
+            {
+                spectrum.assign(2*L, {0.0, 0.0});
+                for(int u=0; u<L && L+u<=m_max; u++) spectrum[u] = {gammafrac_cache[L+u], 0.0};
+                fft.transform(spectrum.data(), 2*L, false);
+            }
+            return spectrum;
+        };
+
+        // Adds the product of xjsum_cache[s..s+L-1] and gammafrac_cache[L..2L-1] to xfar[s+L..s+3L-2] (same for y, z)
+        auto addBlock = [&](int s, int L, int level) {
+            const int t_end = std::min(2*L-1, m_max - (s+L) + 1); // number of target entries that are still needed
+
+            if(L < fft_min_block)
+            {
+                for(int i=s; i<s+L; i++)
+                {
+                    for(int k=L; k<2*L && i+k<=m_max; k++)
+                    {
+                        xfar[i+k] += gammafrac_cache[k] * xjsum_cache[i];
+                        yfar[i+k] += gammafrac_cache[k] * yjsum_cache[i];
+                        zfar[i+k] += gammafrac_cache[k] * zjsum_cache[i];
+                    }
+                }
+                return;
+            }
+
+            const std::vector<std::complex<double>>& spectrum = kernelSpectrum(L, level);
+            const int n_fft = 2*L;
+
+            for(int t=0; t<L; t++)
+            {
+                buf_xy[t] = {xjsum_cache[s+t], yjsum_cache[s+t]};
+                buf_z[t] = {zjsum_cache[s+t], 0.0};
+            }
+            std::fill(buf_xy.begin()+L, buf_xy.begin()+n_fft, std::complex<double>(0.0, 0.0));
+            std::fill(buf_z.begin()+L, buf_z.begin()+n_fft, std::complex<double>(0.0, 0.0));
+
+            fft.transform(buf_xy.data(), n_fft, false);
+            fft.transform(buf_z.data(), n_fft, false);
+            for(int t=0; t<n_fft; t++)
+            {
+                const double gr = spectrum[t].real(), gi = spectrum[t].imag();
+                buf_xy[t] = {buf_xy[t].real()*gr - buf_xy[t].imag()*gi, buf_xy[t].real()*gi + buf_xy[t].imag()*gr};
+                buf_z[t] = {buf_z[t].real()*gr - buf_z[t].imag()*gi, buf_z[t].real()*gi + buf_z[t].imag()*gr};
+            }
+            fft.transform(buf_xy.data(), n_fft, true);
+            fft.transform(buf_z.data(), n_fft, true);
+
+            const double scale = 1.0 / n_fft;
+            for(int t=0; t<t_end; t++)
+            {
+                xfar[s+L+t] += buf_xy[t].real() * scale;
+                yfar[s+L+t] += buf_xy[t].imag() * scale;
+                zfar[s+L+t] += buf_z[t].real() * scale;
+            }
+        };
+
+        // Every aligned block that has just been completed by xjsum_cache[n] is pushed to the accumulators
+        auto pushBlocks = [&](int n) {
+            int level = 0;
+            for(int L=n_direct; (n+1) % L == 0 && n+1 <= m_max; L*=2, level++)
+                addBlock(n+1-L, L, level);
+        };
+
+        // Creating file for results and writing initial state of the system (n=0), or the checkpointed steps (the
+        // accumulators are rebuilt by pushing the same blocks in the same order)
+        std::unique_ptr<TrajectoryWriter> file;
+        const int n_start = startTrajectory(file, filename, "fft", [&](int n, double xn, double yn, double zn) {
+            x[n] = xn; y[n] = yn; z[n] = zn;
+            computeJsum(n, xjsum_cache[n], yjsum_cache[n], zjsum_cache[n]);
+            pushBlocks(n);
+        });
+        if(n_start < 0) return false;
+
+        for(int n=n_start; n<n_iter; n++)
+        {
+            const int m = n-1; // xjsum_cache[0..m] is known at this point
+
+            double xnsum = xfar[m];
+            double ynsum = yfar[m];
+            double znsum = zfar[m];
+
+            for(int k=0; k<n_direct && k<=m; k++)
+            {
+                xnsum += gammafrac_cache[k] * xjsum_cache[m-k];
+                ynsum += gammafrac_cache[k] * yjsum_cache[m-k];
+                znsum += gammafrac_cache[k] * zjsum_cache[m-k];
+            }
+
+            // Caclulating the next step and writing it to the file
+            x[n] = x[0] + xnsum / gammanu;
+            y[n] = y[0] + ynsum / gammanu;
+            z[n] = z[0] + znsum / gammanu;
+            file->write(n, x[n], y[n], z[n]);
+
+            computeJsum(n, xjsum_cache[n], yjsum_cache[n], zjsum_cache[n]);
+            pushBlocks(n);
+        }
+        file->close();
+
+        return true;
+    }
+
+    /*
+     * Same map as solve(), but the memory kernel is split into an exact window (lags k < window) and a sum of K
+     * exponentials for the rest (see SumOfExponentials). Every exponential mode obeys the recursion
+     *
+     *      G_l(m) = q_l * G_l(m-1) + weight[l] * q_l^window * xjsum_cache[m-window],      q_l = exp(-rate[l])
+     *
+     * so the whole history is carried in 3*K numbers and every step costs O(window + K) instead of O(n). Only the last
+     * 'window' values of *jsum_cache are kept (ring buffer). Works for 0 < nu < 1 (for nu >= 1 the kernel does not decay).
+     *
+     * With verbose output the deviation of the approximate kernel from the exact one is estimated (see measureDeviation)
+     * and printed before stepping; sum_abs_dev * max|xjsum| / gamma(nu) then bounds the error of the memory sum committed
+     * in a single step (printed at the end, once max|xjsum| is known). Neither is the deviation of the trajectory from
+     * an exact engine: the per-step errors are amplified by the dynamics, just like rounding errors (see solveFFT).
+     */
+    bool solveSOE(const std::string& filename="", double tol=1e-10)
+    {
+        if(!(wp->nu > 0.0 && wp->nu < 1.0))
+        {
+            std::cerr << "ERROR engine 'soe' requires 0 < nu < 1 (nu = " << wp->nu << ")\n";
+            return false;
+        }
+
+        allocateTrajectory();
+
+        double gammanu = gsl_sf_gamma(wp->nu);
+
+        const int window = 32;           // lags k < window use the exact kernel
+        const int ring_size = 64;        // power of two > window
+        const int ring_mask = ring_size - 1;
+
+        // Same kernel values as the exact engines (the last entry of a kernel of n entries is left 0, hence window+1)
+        std::vector<double> gammafrac_window(window, 0.0);
+        {
+            const GammafracKernel kernel = loadGammafracCache(std::min(window+1, n_iter));
+            for(int k=0; k<window && k<(int)kernel.size(); k++) gammafrac_window[k] = kernel[k];
+        }
+
+        SumOfExponentials soe(wp->nu, window, n_iter, tol);
+        if(verbose) soe.measureDeviation(wp->nu, window, n_iter);
+        const int K = soe.size();
+        if(verbose)
+        {
+            std::cout << "SOE kernel created: " << K << " exponentials past a window of " << window << " exact lags\n";
+            std::cout << std::scientific << std::setprecision(3)
+                      << "SOE kernel deviation from exact kernel (estimated): max abs " << soe.max_abs_dev
+                      << ", rel " << soe.max_rel_dev << ", sum " << soe.sum_abs_dev << " (tol " << tol << ")\n" << std::defaultfloat;
+        }
+
+        std::vector<double> q(K), inject(K);
+        for(int l=0; l<K; l++)
+        {
+            q[l] = std::exp(-soe.rate[l]);
+            inject[l] = soe.weight[l] * std::exp(-soe.rate[l]*window);
+        }
+
+        std::vector<double> xmode(K, 0.0), ymode(K, 0.0), zmode(K, 0.0);
+        std::vector<double> xjsum_ring(ring_size, 0.0), yjsum_ring(ring_size, 0.0), zjsum_ring(ring_size, 0.0);
+
+        computeJsum(0, xjsum_ring[0], yjsum_ring[0], zjsum_ring[0]);
+        double fmax = std::max({std::fabs(xjsum_ring[0]), std::fabs(yjsum_ring[0]), std::fabs(zjsum_ring[0])});
+
+        // Creating file for results and writing initial state of the system (n=0), or the checkpointed steps (the modes
+        // are advanced over them like in the step loop, the window sums are not needed)
+        std::unique_ptr<TrajectoryWriter> file;
+        const int n_start = startTrajectory(file, filename, "soe", [&](int n, double xn, double yn, double zn) {
+            const int m = n-1;
+            if(m >= window)
+            {
+                const double xo = xjsum_ring[(m-window) & ring_mask];
+                const double yo = yjsum_ring[(m-window) & ring_mask];
+                const double zo = zjsum_ring[(m-window) & ring_mask];
+                for(int l=0; l<K; l++)
+                {
+                    xmode[l] = q[l]*xmode[l] + inject[l]*xo;
+                    ymode[l] = q[l]*ymode[l] + inject[l]*yo;
+                    zmode[l] = q[l]*zmode[l] + inject[l]*zo;
+                }
+            }
+            x[n] = xn; y[n] = yn; z[n] = zn;
+            computeJsum(n, xjsum_ring[n & ring_mask], yjsum_ring[n & ring_mask], zjsum_ring[n & ring_mask]);
+            fmax = std::max({fmax, std::fabs(xjsum_ring[n & ring_mask]), std::fabs(yjsum_ring[n & ring_mask]), std::fabs(zjsum_ring[n & ring_mask])});
+        });
+        if(n_start < 0) return false;
+
+        for(int n=n_start; n<n_iter; n++)
+        {
+            const int m = n-1; // xjsum[0..m] is known at this point
+
+            double xnsum {0};
+            double ynsum {0};
+            double znsum {0};
+
+            // exponential modes: G_l(m) from G_l(m-1) and the value leaving the exact window
+            if(m >= window)
+            {
+                const double xo = xjsum_ring[(m-window) & ring_mask];
+                const double yo = yjsum_ring[(m-window) & ring_mask];
+                const double zo = zjsum_ring[(m-window) & ring_mask];
+                for(int l=0; l<K; l++)
+                {
+                    xmode[l] = q[l]*xmode[l] + inject[l]*xo;
+                    ymode[l] = q[l]*ymode[l] + inject[l]*yo;
+                    zmode[l] = q[l]*zmode[l] + inject[l]*zo;
+                    xnsum += xmode[l];
+                    ynsum += ymode[l];
+                    znsum += zmode[l];
+                }
+            }
+
+            for(int k=0; k<window && k<=m; k++)
+            {
+                xnsum += gammafrac_window[k] * xjsum_ring[(m-k) & ring_mask];
+                ynsum += gammafrac_window[k] * yjsum_ring[(m-k) & ring_mask];
+                znsum += gammafrac_window[k] * zjsum_ring[(m-k) & ring_mask];
+            }
+
+            // Caclulating the next step and writing it to the file
+            x[n] = x[0] + xnsum / gammanu;
+            y[n] = y[0] + ynsum / gammanu;
+            z[n] = z[0] + znsum / gammanu;
+            file->write(n, x[n], y[n], z[n]);
+
+            computeJsum(n, xjsum_ring[n & ring_mask], yjsum_ring[n & ring_mask], zjsum_ring[n & ring_mask]);
+            fmax = std::max({fmax, std::fabs(xjsum_ring[n & ring_mask]), std::fabs(yjsum_ring[n & ring_mask]), std::fabs(zjsum_ring[n & ring_mask])});
+        }
+        file->close();
+
+        if(verbose)
+            std::cout << std::scientific << std::setprecision(3)
+                      << "SOE per-step memory sum error bound (estimated): " << soe.sum_abs_dev * fmax / gammanu
+                      << " (max |xjsum| = " << fmax << ")\n"
+                      << std::defaultfloat;
+
+        return true;
+    }
+
+    /*
+     * Short-memory principle: the memory kernel is truncated to the last L lags,
+     *
+     *      x[n] = x[0] + 1/gamma(nu) * sum_{k=0}^{min(n-1, L-1)} gammafrac_cache[k] * xjsum_cache[n-1-k]
+     *
+     * The last L values of *jsum_cache live in ring buffers and the state is streamed straight to the file, so memory is
+     * O(L) and every step costs O(L) no matter how large n_iter is (x, y, z keep only the initial state).
+     * Each ring buffer is stored twice in a row (2L entries) so that the window is always one contiguous slice, which
+     * keeps the inner loop free of index wrapping; the kernel is stored reversed to match it.
+     *
+     * Truncation error estimate: the dropped lags carry the kernel tail mass
+     *
+     *      T = sum_{k=L}^{n_iter-2} gammafrac(k) = ( gamma(n_iter-1+nu)/gamma(n_iter-1) - gamma(L+nu)/gamma(L) ) / nu
+     *
+     * (closed form of the partial sums of gamma(k+nu)/gamma(k+1)), so a single step is off by at most
+     * T * max|xjsum| / gamma(nu). Both T (absolute and as a fraction of the full kernel mass) and the bound are printed.
+     */
+    bool solveShortMemory(const std::string& filename="", int L=10000)
+    {
+        if(L < 1) L = 1;
+        if(L > n_iter) L = n_iter;
+
+        double gammanu = gsl_sf_gamma(wp->nu);
+
+        // gammafrac_reversed[L-1-k] = gamma(k+nu)/gamma(k+1), the first L entries of the exact engines' kernel (the last
+        // entry of a kernel of n entries is left 0, hence L+1; with L == n_iter lag n_iter-1 is never reached anyway), so
+        // --memory-length=n_iter reproduces the 'cached' engine with --simd=scalar (and 'tiled'/'threaded')
+        std::vector<double> gammafrac_reversed(L);
+        {
+            const GammafracKernel kernel = loadGammafracCache(std::min(L+1, n_iter));
+            for(int k=0; k<L; k++) gammafrac_reversed[L-1-k] = kernel[k];
+        }
+
+        // partial sums of the kernel: sum_{k=0}^{M} gammafrac(k) = gamma(M+1+nu) / (nu * gamma(M+1))
+        auto kernelMass = [&](int M) { return std::exp( gsl_sf_lngamma(M+1+wp->nu) - gsl_sf_lngamma(M+1) ) / wp->nu; };
+        const double mass_total = kernelMass(n_iter-2);
+        const double mass_tail = (L <= n_iter-2) ? mass_total - kernelMass(L-1) : 0.0;
+
+        // xjsum_ring[p] == xjsum_ring[p+L] == xjsum_cache[m] with p = m % L; the window of step m is xjsum_ring[p+1..p+L]
+        std::vector<double> xjsum_ring(2*L, 0.0);
+        std::vector<double> yjsum_ring(2*L, 0.0);
+        std::vector<double> zjsum_ring(2*L, 0.0);
+
+        double xn = x[0], yn = y[0], zn = z[0];
+        double xjsum, yjsum, zjsum;
+        computeJsum(xn, yn, zn, xjsum, yjsum, zjsum);
+        xjsum_ring[0] = xjsum_ring[L] = xjsum;
+        yjsum_ring[0] = yjsum_ring[L] = yjsum;
+        zjsum_ring[0] = zjsum_ring[L] = zjsum;
+        double fmax = std::max({std::fabs(xjsum), std::fabs(yjsum), std::fabs(zjsum)});
+
+        int p = 0; // ring position of the newest xjsum
+
+        // Appends the sums of step (xn, yn, zn) to the ring buffers
+        auto push = [&]() {
+            computeJsum(xn, yn, zn, xjsum, yjsum, zjsum);
+            p = (p+1 == L) ? 0 : p+1;
+            xjsum_ring[p] = xjsum_ring[p+L] = xjsum;
+            yjsum_ring[p] = yjsum_ring[p+L] = yjsum;
+            zjsum_ring[p] = zjsum_ring[p+L] = zjsum;
+            fmax = std::max({fmax, std::fabs(xjsum), std::fabs(yjsum), std::fabs(zjsum)});
+        };
+
+        // Creating file for results and writing initial state of the system (n=0), or the checkpointed steps
+        std::unique_ptr<TrajectoryWriter> file;
+        const int n_start = startTrajectory(file, filename, "short", [&](int, double xr, double yr, double zr) {
+            xn = xr; yn = yr; zn = zr;
+            push();
+        });
+        if(n_start < 0) return false;
+
+        for(int n=n_start; n<n_iter; n++)
+        {
+            double xnsum {0};
+            double ynsum {0};
+            double znsum {0};
+
+            const double* xw = &xjsum_ring[p+1];
+            const double* yw = &yjsum_ring[p+1];
+            const double* zw = &zjsum_ring[p+1];
+            for(int j=0; j<L; j++)
+            {
+                xnsum += gammafrac_reversed[j] * xw[j];
+                ynsum += gammafrac_reversed[j] * yw[j];
+                znsum += gammafrac_reversed[j] * zw[j];
+            }
+
+            // Caclulating the next step and writing it to the file
+            xn = x[0] + xnsum / gammanu;
+            yn = y[0] + ynsum / gammanu;
+            zn = z[0] + znsum / gammanu;
+            file->write(n, xn, yn, zn);
+            push();
+        }
+        file->close();
+
+        if(verbose)
+            std::cout << std::scientific << std::setprecision(3)
+                      << "short memory L = " << L << ": kernel tail mass " << mass_tail
+                      << " (" << mass_tail / mass_total << " of the full kernel), truncation error estimate per step <= "
+                      << mass_tail * fmax / gammanu << " (max |xjsum| = " << fmax << ")\n" << std::defaultfloat;
+
+        return true;
+    }
+
+    /*
+     * Same map, summation order and CSV output as solve(--simd=scalar), restructured for large n_iter and optionally
+     * spread over n_threads cores ('tiled' engine: n_threads = 1, 'threaded' engine: n_threads > 1).
+     *
+     * The steps are processed in blocks [b, e) of 'block' steps. For every n in the block the memory sum splits into
+     *
+     *      history:  sum_{i=0}^{b-1}   gammafrac_cache[n-1-i] * xjsum[i]    (xjsum[0..b-1] already known)
+     *      local:    sum_{i=b}^{n-1}   gammafrac_cache[n-1-i] * xjsum[i]    (depends on the steps of the block)
+     *
+     * At each block boundary the history sums of all steps of the block are computed with accumulateHistory(), which
+     * streams the known part of the (interleaved) x/y/z sums and of the kernel once per block instead of once per step.
+     * With several threads the steps of the block are dealt out in contiguous chunks and every thread does this for its
+     * chunk. Then one thread walks through the block sequentially adding the local part. The local sum continues the
+     * history accumulator in the same order (i ascending) as the scalar kernel of solve(), so the engines write
+     * byte-identical files.
+     *
+     * Memory traffic: solve() reads 4 arrays of n doubles for step n, ~16 n_iter^2 bytes in total, which at
+     * n_iter ~ 1e6 is far past L2 and makes it bandwidth bound. Here the history reads ~32 b bytes per block, i.e.
+     * ~16 n_iter^2 / block bytes in total (per thread), and the local part stays in cache.
+     * Work: the history part is ~ n_iter^2/2 (parallel), the local part ~ n_iter*block/2 (serial, not tiled), so 'block'
+     * should be small against n_iter but large enough that the per-block synchronisation (two condition variable
+     * hand-offs) stays negligible, e.g. block = 2048 for n_iter ~ 1e5-1e7.
+     */
+    bool solveTiled(const std::string& filename="", int block=2048, int n_threads=1)
+    {
+        if(block < 1) block = 1;
+        if(n_threads < 1) n_threads = std::max(1, (int)std::thread::hardware_concurrency());
+
+        allocateTrajectory();
+
+        double gammanu = gsl_sf_gamma(wp->nu);
+
+        const GammafracKernel gammafrac_cache = loadGammafracCache();
+        if(verbose) std::cout << "gammafrac_cache vector created...\n";
+        const double* g = gammafrac_cache.data();
+
+        // x/y/z sums interleaved: jsum[3*i] = xjsum_cache[i], jsum[3*i+1] = yjsum_cache[i], jsum[3*i+2] = zjsum_cache[i]
+        std::vector<double> jsum(3*(size_t)n_iter, 0.0);
+        computeJsum(0, jsum[0], jsum[1], jsum[2]);
+
+        // History sums of the current block, indexed by n-b
+        std::vector<double> xhist(block), yhist(block), zhist(block);
+
+        ThreadTeam team(n_threads);
+        if(verbose) std::cout << "tiled engine: block " << block << ", " << team.size() << " thread(s)\n";
+
+        // Creating file for results and writing initial state of the system (n=0), or the checkpointed steps. The sums
+        // run over i ascending whatever the block boundaries are, so the blocks may start at any step.
+        std::unique_ptr<TrajectoryWriter> file;
+        const int n_start = startTrajectory(file, filename, (n_threads > 1) ? "threaded" : "tiled",
+                                            [&](int n, double xn, double yn, double zn) {
+            x[n] = xn; y[n] = yn; z[n] = zn;
+            computeJsum(n, jsum[3*n], jsum[3*n+1], jsum[3*n+2]);
+        });
+        if(n_start < 0) return false;
+
+        for(int b=n_start; b<n_iter; b+=block)
+        {
+            const int e = std::min(b + block, n_iter);
+
+            // History part (jsum[0..b-1]), parallel over the steps of the block
+            team.run([&](int t) {
+                const int n_begin = b + (int)((long)(e-b) * t / team.size());
+                const int n_end = b + (int)((long)(e-b) * (t+1) / team.size());
+                std::fill(xhist.begin() + (n_begin-b), xhist.begin() + (n_end-b), 0.0);
+                std::fill(yhist.begin() + (n_begin-b), yhist.begin() + (n_end-b), 0.0);
+                std::fill(zhist.begin() + (n_begin-b), zhist.begin() + (n_end-b), 0.0);
+                accumulateHistory(g, jsum.data(), 0, b, n_begin, n_end,
+                                  xhist.data() + (n_begin-b), yhist.data() + (n_begin-b), zhist.data() + (n_begin-b));
+            });
+
+            // Local part (jsum[b..n-1]), sequential
+            for(int n=b; n<e; n++)
+            {
+                double xnsum = xhist[n-b];
+                double ynsum = yhist[n-b];
+                double znsum = zhist[n-b];
+
+                for(int i=b; i<n; i++)
+                {
+                    xnsum += g[n-1-i] * jsum[3*i];
+                    ynsum += g[n-1-i] * jsum[3*i+1];
+                    znsum += g[n-1-i] * jsum[3*i+2];
+                }
+
+                x[n] = x[0] + xnsum / gammanu;
+                y[n] = y[0] + ynsum / gammanu;
+                z[n] = z[0] + znsum / gammanu;
+                file->write(n, x[n], y[n], z[n]);
+
+                computeJsum(n, jsum[3*n], jsum[3*n+1], jsum[3*n+2]);
+            }
+        }
+        file->close();
+
+        return true;
+    }
+
+    /*
+     * Convolution engines selectable with --engine=<name> (time-evol, sweep). All of them compute the same map and share
+     * the output, checkpoint and --continue handling (startTrajectory, openTrajectory); they differ only in how the
+     * memory sum is evaluated. A new engine is a solveX(filename, ...) method plus one entry here, whose 'solve' checks
+     * its settings in 'options' (false after printing the error) and runs it.
+     */
+    struct Engine
+    {
+        const char* name;
+        const char* description;
+        int work_exponent; // run time ~ n_iter^work_exponent (ETA of the heartbeat, see telemetry.hpp)
+        bool (*solve)(HopfieldNetwork& H, const SolverOptions& options, const std::string& filename); // false unless complete
+    };
+
+    static const std::vector<Engine>& engines()
+    {
+        static const std::vector<Engine> table {
+            {"cached", "exact, kernel computed once, SIMD memory sum (default)",
+             2,
+             [](HopfieldNetwork& H, const SolverOptions& options, const std::string& filename) {
+                 if(selectTripleDot(options.simd).kernel == nullptr)
+                 {
+                     std::cerr << "ERROR SIMD kernel '" << options.simd << "' is unknown or not supported by this CPU\n";
+                     return false;
+                 }
+                 return H.solve(filename, options.simd);
+             }},
+            {"tiled", "exact (same file as cached --simd=scalar), cache-blocked for large n_iter",
+             2,
+             [](HopfieldNetwork& H, const SolverOptions& options, const std::string& filename) {
+                 return H.solveTiled(filename, options.block_size, 1);
+             }},
+            {"threaded", "tiled with one trajectory spread over --engine-threads cores",
+             2,
+             [](HopfieldNetwork& H, const SolverOptions& options, const std::string& filename) {
+                 return H.solveTiled(filename, options.block_size, options.engine_threads);
+             }},
+            {"fft", "online FFT convolution, O(n_iter log^2 n_iter)",
+             1,
+             [](HopfieldNetwork& H, const SolverOptions&, const std::string& filename) {
+                 return H.solveFFT(filename);
+             }},
+            {"soe", "sum-of-exponentials kernel to --soe-tol, O(n_iter), 0 < nu < 1",
+             1,
+             [](HopfieldNetwork& H, const SolverOptions& options, const std::string& filename) {
+                 return H.solveSOE(filename, options.soe_tol);
+             }},
+            {"short", "kernel truncated to the last --memory-length lags",
+             1,
+             [](HopfieldNetwork& H, const SolverOptions& options, const std::string& filename) {
+                 return H.solveShortMemory(filename, options.memory_length);
+             }},
+            {"naive", "reference only: lngamma evaluated inside the O(n_iter^2) loop",
+             2,
+             [](HopfieldNetwork& H, const SolverOptions&, const std::string& filename) {
+                 return H.solveNaive(filename);
+             }},
+        };
+        return table;
+    }
+
+    // Engine called 'name', nullptr (after printing the error and the list of engines) if there is none
+    static const Engine* findEngine(const std::string& name)
+    {
+        for(const Engine& engine : engines()) if(name == engine.name) return &engine;
+
+        std::cerr << "ERROR unknown engine " << name << ", available engines:\n";
+        for(const Engine& engine : engines()) std::cerr << "  " << std::left << std::setw(10) << engine.name << engine.description << '\n';
+        return nullptr;
+    }
+
+    // Runs the engine selected in 'requested' (resolving --engine=auto), returns true only if the trajectory was started
+    // and computed to the last step (false for an unknown engine or option, a file that cannot be opened, a checkpoint
+    // or --continue mismatch, or an engine that refuses the parameters, e.g. 'soe' with nu >= 1)
+    bool run(const SolverOptions& requested, const std::string& filename)
+    {
+        const SolverOptions options = requested.tuned(requested.n_iter > 0 ? requested.n_iter : n_iter);
+        if(verbose && requested.engine == "auto")
+        {
+            std::cout << "engine auto: " << options.engine;
+            if(options.engine == "tiled" || options.engine == "threaded")
+                std::cout << ", block " << options.block_size << ", " << options.engine_threads << " thread(s)";
+            std::cout << '\n';
+        }
+        const Engine* engine = findEngine(options.engine);
+        if(engine == nullptr) return false;
+
+        if(!validTrajectoryFormat(options.format))
+        {
+            std::cerr << "ERROR unknown output format " << options.format << '\n';
+            return false;
+        }
+        kernel_anchors = kernelAnchorInterval(options.kernel);
+        if(kernel_anchors == 0)
+        {
+            std::cerr << "ERROR unknown kernel method " << options.kernel << " (use 'recurrence' or 'lngamma')\n";
+            return false;
+        }
+        output_format = options.format;
+        async_output = options.async_output;
+        if(options.n_iter > 0) n_iter = options.n_iter;
+        first_step = options.firstStep(n_iter);
+        lod = options.lod;
+        checkpoint_interval = options.checkpoint;
+        resume = options.resume;
+        if(telemetry)
+        {
+            telemetry->setRun(options.engine, n_iter, engine->work_exponent);
+            telemetry->phase("kernel");
+        }
+
+        // --continue without a file extends the output file in place: the old file is kept as <output file>.prev
+        // until the extended one is complete (and is picked up again if this run does not get that far)
+        continue_path = options.continue_from;
+        started = false;
+        std::string previous;
+        if(options.continue_run && continue_path.empty() && !output_writer)
+        {
+            previous = filename + ".prev";
+            std::error_code ec;
+            if(!fs::exists(previous) && fs::exists(filename)) fs::rename(filename, previous, ec);
+            if(fs::exists(previous)) continue_path = previous;
+            else
+            {
+                if(verbose) std::cout << "nothing to continue in " << filename << ", starting from step 1\n";
+                previous.clear();
+            }
+        }
+
+        if(!engine->solve(*this, options, filename) || !started) return false;
+
+        std::error_code ec;
+        if(!previous.empty()) fs::remove(previous, ec);
+        return true;
+    }
+
+/*
+    void bifurcation(std::ofstream& filex, std::ofstream& filey, std::ofstream& filez)
+    {
+        int nstepsLast {100}; // number of steps to save (counted from the end of neuron's evolution vector)
+        std::vector<double> xb(nstepsLast, 0), yb(nstepsLast, 0), zb(nstepsLast, 0); // vectors holding last nstepsLast steps of neurons' evolution
+
+        auto [x, y, z] = solve(n_iter);
+
+        for(int i=0; i<nstepsLast; ++i)
+        {
+            int indx = n_iter-1-i;
+
+            xb[i] = x[indx];
+            yb[i] = y[indx];
+            zb[i] = z[indx];
+
+            filex << "," << xb[i];
+            filey << "," << yb[i];
+            filez << "," << zb[i];
+        }
+        filex << '\n';
+        filey << '\n';
+        filez << '\n';
+    }
+*/
+    // THIS FEATURE IS NOT USED CURRENTLY!!!!
+    // Overloading operator: H1->H2 means that H1 (transmitter) sends synchronisation signal to H2 (receiver) which results in
+    // synchronisation of these two Hopfield networks
+    // void operator*(HopfieldNetwork& other) // here other is the receiver that is to be synchronised with the transmitter
+    // {
+    //     int nstepsChaos {50}; // number of steps to take in two networks befor synchronisation begins
+    //     int nstepsSynchro {2000}; // number of steps that will be used for synchronisation
+
+    //     auto [xtemp, ytemp, ztemp] = solve(nstepsChaos);
+    //     auto [xslavetemp, yslavetemp, zslavetemp] = other.solve(nstepsChaos);
+
+    //     std::ofstream fileTransmitter("transmitter.csv");
+    //     std::ofstream fileReceiver("receiver.csv");
+    //     std::ofstream fileSynchroError("synchroError.csv");
+
+    //     fileTransmitter << "n,x,y,z\n";
+    //     fileReceiver << "n,x,y,z\n";
+    //     fileSynchroError << "n,ex,ey,ez\n";
+
+    //     x[0] = x[nstepsChaos-1];
+    //     y[0] = y[nstepsChaos-1];
+    //     z[0] = z[nstepsChaos-1];
+
+    //     double gammanu = gsl_sf_gamma(wp->nu);
+
+    //     for(int n=1; n<nstepsSynchro; n++)
+    //     {
+    //         double xnsum {0};
+    //         double ynsum {0};
+    //         double znsum {0};
+
+    //         // other.x, other.y and other.z are equivalent to xslave, yslave, zslave
+    //         double xslavensum {0};
+    //         double yslavensum {0};
+    //         double zslavensum {0};
+
+    //         // Synchronisation errors
+    //         double ex {};
+    //         double ey {};
+    //         double ez {};
+
+    //         double k_safety = 1; // k_safety is to ensure that -1 < max{k_i} < 2^{nu} - 1
+
+    //         // k1 = kx, k2 = ky, k3 = kz
+    //         double k1 = 0.6311; // {std::pow(2, wp->nu) - 1 - k_safety}; 
+    //         double k2 = 0.6311; // {std::pow(2, wp->nu) - 1 - k_safety}; 
+    //         double k3 = 0.6311; // {std::pow(2, wp->nu) - 1 - k_safety}; 
+
+    //         for(int j=1; j<=n; j++)
+    //         {
+    //             /* Computing gammafrac in the same way as in solve() method */
+    //             double alpha = gsl_sf_lngamma(n-j+wp->nu) - gsl_sf_lngamma(n-j+1);
+    //             double gammafrac = std::exp(alpha);
+
+    //             // Computing x and xslave state - synchronising -----------------------------------
+    //             xnsum += gammafrac * (
+    //                 -x[j-1] +
+    //                 wp->w11*std::tanh(x[j-1]) +
+    //                 wp->w12*std::tanh(y[j-1]) +
+    //                 wp->w13*std::tanh(z[j-1])
+    //             );
+
+    //             // IF x state is NOT being sent
+    //             // xslavensum += gammafrac * (
+    //             //     -other.x[j-1] +
+    //             //     wp->w11*std::tanh(other.x[j-1]) +
+    //             //     wp->w12*std::tanh(other.y[j-1]) +
+    //             //     wp->w13*std::tanh(other.z[j-1])
+    //             // );
+
+    //             // IF x state is being sent:
+    //             xslavensum += gammafrac * (
+    //                 -other.x[j-1] +
+    //                 wp->w11*std::tanh(other.x[j-1]) +
+    //                 wp->w12*std::tanh(other.y[j-1]) +
+    //                 wp->w13*std::tanh(other.z[j-1]) -
+    //                 wp->w11*( std::tanh(other.x[j-1]) - std::tanh(x[j-1]) ) -
+    //                 wp->w12*( std::tanh(other.y[j-1]) - std::tanh(y[j-1]) ) -
+    //                 wp->w13*( std::tanh(other.z[j-1]) - std::tanh(z[j-1]) ) -
+    //                 k1*( other.x[j-1] - x[j-1] )
+    //             );
+
+    //             // Computing y and yslave state - synchronising -----------------------------------
+    //             ynsum += gammafrac * (
+    //                 -y[j-1] +
+    //                 wp->w21*std::tanh(x[j-1]) +
+    //                 wp->w22*std::tanh(y[j-1]) +
+    //                 wp->w23*std::tanh(z[j-1])
+    //             );
+
+    //             // IF y state is NOT being sent:
+    //             yslavensum += gammafrac * (
+    //                 -other.y[j-1] +
+    //                 wp->w21*std::tanh(other.x[j-1]) +
+    //                 wp->w22*std::tanh(other.y[j-1]) +
+    //                 wp->w23*std::tanh(other.z[j-1])
+    //             );
+
+    //             // IF y state is being sent:
+    //             // yslavensum += gammafrac * (
+    //             //     -other.y[j-1] +
+    //             //     wp->w21*std::tanh(other.x[j-1]) +
+    //             //     wp->w22*std::tanh(other.y[j-1]) +
+    //             //     wp->w23*std::tanh(other.z[j-1]) -
+    //             //     wp->w21*( std::tanh(other.x[j-1]) - std::tanh(x[j-1]) ) -
+    //             //     wp->w22*( std::tanh(other.y[j-1]) - std::tanh(y[j-1]) ) -
+    //             //     wp->w23*( std::tanh(other.z[j-1]) - std::tanh(z[j-1]) ) -
+    //             //     k2*( other.y[j-1] - y[j-1] )
+    //             // );
+
+    //             // Computing z and zslave state - synchronising -----------------------------------
+    //             znsum += gammafrac * (
+    //                 -z[j-1] +
+    //                 wp->w31*std::tanh(x[j-1]) +
+    //                 wp->w32*std::tanh(y[j-1]) +
+    //                 wp->w33*std::tanh(z[j-1])
+    //             );
+
+    //             // IF z state is NOT being sent:
+    //             zslavensum += gammafrac * (
+    //                 -other.z[j-1] +
+    //                 wp->w31*std::tanh(other.x[j-1]) +
+    //                 wp->w32*std::tanh(other.y[j-1]) +
+    //                 wp->w33*std::tanh(other.z[j-1])
+    //             );
+
+    //             // IF z state is being sent:
+    //             // zslavensum += gammafrac * (
+    //             //     -other.z[j-1] +
+    //             //     wp->w31*std::tanh(other.x[j-1]) +
+    //             //     wp->w32*std::tanh(other.y[j-1]) +
+    //             //     wp->w33*std::tanh(other.z[j-1]) -
+    //             //     wp->w31*( std::tanh(other.x[j-1]) - std::tanh(x[j-1]) ) -
+    //             //     wp->w32*( std::tanh(other.y[j-1]) - std::tanh(y[j-1]) ) -
+    //             //     wp->w33*( std::tanh(other.z[j-1]) - std::tanh(z[j-1]) ) -
+    //             //     k3*( other.z[j-1] - z[j-1] )
+    //             // );
+    //         }
+
+    //         x[n] = x[0] + xnsum / gammanu;
+    //         y[n] = y[0] + ynsum / gammanu;
+    //         z[n] = z[0] + znsum / gammanu;
+
+    //         other.x[n] = other.x[0] + xslavensum / gammanu;
+    //         other.y[n] = other.y[0] + yslavensum / gammanu;
+    //         other.z[n] = other.z[0] + zslavensum / gammanu;
+
+    //         ex = other.x[n] - x[n];
+    //         ey = other.y[n] - y[n];
+    //         ez = other.z[n] - z[n];
+
+    //         fileTransmitter << n << ',' << x[n] << ',' << y[n] << ',' << z[n] << '\n';
+    //         fileReceiver << n << ',' << other.x[n] << ',' << other.y[n] << ',' << other.z[n] << '\n';
+    //         fileSynchroError << n << ',' << ex << ',' << ey << ',' << ez << '\n';
+    //     }
+
+    //     fileTransmitter.close();
+    //     fileReceiver.close();
+    //     fileSynchroError.close();
+    // }
+
+};
+
+/*
+ * Batched solver: LANES parameter configurations (e.g. consecutive config IDs of one sweep) are advanced in lockstep.
+ * All per-step data is stored structure-of-arrays across configurations (xjsum_cache[j*LANES + lane]), so the inner
+ * loop of the memory sum is one SIMD lane per configuration and every kernel value loaded from memory feeds LANES
+ * (times three neurons) multiply-adds. When all configurations share 'nu' (the control parameter is a weight or an
+ * initial state) they share a single gammafrac_cache, otherwise the kernel is interleaved the same way as the states.
+ *
+ * Every lane performs exactly the same operations in the same order as HopfieldNetwork::solve() with --simd=scalar, so
+ * the per-config CSV files are identical to the single-config ones (as long as both are compiled with the same flags, -ffp-contract
+ * included: with -march flags that enable FMA add -ffp-contract=off to keep the files bit-identical).
+ */
+template<int LANES>
+class HopfieldBatch
+{
+    std::vector<Params*> wps; // LANES entries, unused lanes repeat the last configuration and are not written out
+    int n_active;
+    int n_iter;
+
+public:
+    std::string output_format {"csv"}; // 'csv', 'bin' or 'bin32' (see trajectory_io.hpp)
+    bool async_output {true};          // one writer thread per lane (see AsyncTrajectoryWriter)
+    int first_step {0};                // steps before first_step are not written (tail mode, SolverOptions::firstStep)
+    bool lod {false};                  // level-of-detail sidecar next to every output file (see LodPyramidWriter)
+    int kernel_anchors {kernel_anchor_interval}; // anchor interval of the kernel, 1 = all from lngamma (--kernel)
+
+    HopfieldBatch(const std::vector<Params*>& wps_) : wps(wps_), n_active((int)wps_.size())
+    {
+        n_iter = wps[0]->n_iter;
+        while((int)wps.size() < LANES) wps.push_back(wps.back());
+    }
+
+    // Solves all lanes and writes filenames[l] for every active lane, returns false if the batch cannot be run or an
+    // output file cannot be opened
+    bool solve(const std::vector<std::string>& filenames)
+    {
+        for(int l=0; l<n_active; l++)
+        {
+            if(wps[l]->n_iter != n_iter || n_iter < 1)
+            {
+                std::cerr << "ERROR batched configurations must share n_iter >= 1 (" << filenames[l] << ")\n";
+                return false;
+            }
+        }
+
+        std::vector<std::unique_ptr<TrajectoryWriter>> files(n_active);
+        for(int l=0; l<n_active; l++)
+        {
+            files[l] = openTrajectoryWriter(filenames[l], output_format, trajectoryInfo(*wps[l], n_iter, first_step), async_output, lod);
+            if(!files[l]) return false;
+            files[l]->write(0, wps[l]->x0, wps[l]->y0, wps[l]->z0);
+        }
+
+        // Per-lane constants
+        double x0[LANES], y0[LANES], z0[LANES], gammanu[LANES];
+        double w11[LANES], w12[LANES], w13[LANES];
+        double w21[LANES], w22[LANES], w23[LANES];
+        double w31[LANES], w32[LANES], w33[LANES];
+        bool shared_kernel = true;
+        for(int l=0; l<LANES; l++)
+        {
+            const Params* wp = wps[l];
+            x0[l] = wp->x0; y0[l] = wp->y0; z0[l] = wp->z0;
+            gammanu[l] = gsl_sf_gamma(wp->nu);
+            w11[l] = wp->w11; w12[l] = wp->w12; w13[l] = wp->w13;
+            w21[l] = wp->w21; w22[l] = wp->w22; w23[l] = wp->w23;
+            w31[l] = wp->w31; w32[l] = wp->w32; w33[l] = wp->w33;
+            if(wp->nu != wps[0]->nu) shared_kernel = false;
+        }
+
+        // Shared kernel: gammafrac_cache[k]; otherwise interleaved: gammafrac_cache[k*LANES + lane]
+        std::vector<double> gammafrac_cache;
+        if(shared_kernel)
+        {
+            const GammafracKernel kernel = loadGammafracKernel(wps[0]->nu, n_iter, kernel_anchors);
+            gammafrac_cache.assign(kernel.begin(), kernel.end());
+        }
+        else
+        {
+            gammafrac_cache.assign((size_t)n_iter*LANES, 0.0);
+            for(int l=0; l<LANES; l++)
+            {
+                const GammafracKernel lane_cache = loadGammafracKernel(wps[l]->nu, n_iter, kernel_anchors);
+                for(int k=0; k<n_iter; k++) gammafrac_cache[(size_t)k*LANES + l] = lane_cache[k];
+            }
+        }
+        std::cout << "gammafrac_cache vector created" << (shared_kernel ? " (shared by all lanes)...\n" : " (one per lane)...\n");
+
+        std::vector<double> xjsum_cache((size_t)n_iter*LANES, 0.0);
+        std::vector<double> yjsum_cache((size_t)n_iter*LANES, 0.0);
+        std::vector<double> zjsum_cache((size_t)n_iter*LANES, 0.0);
+
+        double xn[LANES], yn[LANES], zn[LANES];
+        for(int l=0; l<LANES; l++)
+        {
+            xn[l] = x0[l]; yn[l] = y0[l]; zn[l] = z0[l];
+        }
+
+        // Same expression (and order of operations) as HopfieldNetwork::computeJsum
+        auto computeJsum = [&](int n) {
+            double* xj = &xjsum_cache[(size_t)n*LANES];
+            double* yj = &yjsum_cache[(size_t)n*LANES];
+            double* zj = &zjsum_cache[(size_t)n*LANES];
+            for(int l=0; l<LANES; l++)
+            {
+                const double tx = std::tanh(xn[l]), ty = std::tanh(yn[l]), tz = std::tanh(zn[l]);
+                xj[l] = -xn[l] + w11[l]*tx + w12[l]*ty + w13[l]*tz;
+                yj[l] = -yn[l] + w21[l]*tx + w22[l]*ty + w23[l]*tz;
+                zj[l] = -zn[l] + w31[l]*tx + w32[l]*ty + w33[l]*tz;
+            }
+        };
+        computeJsum(0);
+
+        // The lanes are processed in native SIMD registers of W doubles (LANES/W registers per neuron)
+        constexpr int W = (SIMD_DOUBLES < LANES) ? SIMD_DOUBLES : LANES;
+        constexpr int NV = LANES / W;
+        typedef typename LaneVector<W>::type Vec;
+
+        for(int n=1; n<n_iter; n++)
+        {
+            Vec xnsum[NV] = {}, ynsum[NV] = {}, znsum[NV] = {};
+
+            if(shared_kernel)
+            {
+                for(int j=1; j<=n; j++)
+                {
+                    const double g = gammafrac_cache[n-j];
+                    const Vec* xj = reinterpret_cast<const Vec*>(&xjsum_cache[(size_t)(j-1)*LANES]);
+                    const Vec* yj = reinterpret_cast<const Vec*>(&yjsum_cache[(size_t)(j-1)*LANES]);
+                    const Vec* zj = reinterpret_cast<const Vec*>(&zjsum_cache[(size_t)(j-1)*LANES]);
+                    for(int v=0; v<NV; v++)
+                    {
+                        xnsum[v] += g * xj[v];
+                        ynsum[v] += g * yj[v];
+                        znsum[v] += g * zj[v];
+                    }
+                }
+            }
+            else
+            {
+                for(int j=1; j<=n; j++)
+                {
+                    const Vec* g = reinterpret_cast<const Vec*>(&gammafrac_cache[(size_t)(n-j)*LANES]);
+                    const Vec* xj = reinterpret_cast<const Vec*>(&xjsum_cache[(size_t)(j-1)*LANES]);
+                    const Vec* yj = reinterpret_cast<const Vec*>(&yjsum_cache[(size_t)(j-1)*LANES]);
+                    const Vec* zj = reinterpret_cast<const Vec*>(&zjsum_cache[(size_t)(j-1)*LANES]);
+                    for(int v=0; v<NV; v++)
+                    {
+                        xnsum[v] += g[v] * xj[v];
+                        ynsum[v] += g[v] * yj[v];
+                        znsum[v] += g[v] * zj[v];
+                    }
+                }
+            }
+
+            for(int l=0; l<LANES; l++)
+            {
+                xn[l] = x0[l] + xnsum[l/W][l%W] / gammanu[l];
+                yn[l] = y0[l] + ynsum[l/W][l%W] / gammanu[l];
+                zn[l] = z0[l] + znsum[l/W][l%W] / gammanu[l];
+            }
+            for(int l=0; l<n_active; l++)
+                files[l]->write(n, xn[l], yn[l], zn[l]);
+
+            computeJsum(n);
+        }
+
+        for(int l=0; l<n_active; l++) files[l]->close();
+        return true;
+    }
+};
@@ -0,0 +1,401 @@
+"""
+Readers for the time-evol output files.
+
+Two formats are written by time-evol / sweep (--format=...):
+  - CSV ('csv'): header "n,x,y,z" and one line per step
+  - binary columnar ('bin' float64, 'bin32' float32), see BinaryTrajectoryWriter in trajectory_io.hpp:
+        128-byte little-endian header (magic "HFTRAJ01", header size, bytes per value, n_iter, nu, x0, y0, z0, w11..w33)
+        followed by the x, y and z columns; files written with --tail/--transient have a 136-byte header ending with
+        the step of the first row (n_first)
+The format is recognised from the first bytes of the file, so the plotting scripts accept both.
+sweep --bifur writes one aggregated bifurcation file per config range instead (see load_bifurcation).
+The binary columns are returned as np.memmap views, i.e. nothing is read until the values are used and slicing the
+last N steps only touches those pages.
+
+sweep --archive writes one sweep archive per config range (archive_config-XXXXXXX-YYYYYYY.hfa, see sweep_archive.hpp):
+a fixed index of 160-byte entries (config ID, status, offset/length of the data block, parameters) followed by the data
+blocks, which hold x, y and z columns like a binary trajectory file. A trajectory inside an archive is addressed as
+"<archive path>#<config ID>"; resolve_path() returns such paths for time-evol_config-XXXXXXX.csv files that only exist
+in an archive.
+
+time-evol --lod also writes a level-of-detail sidecar <output file>.lod (see LodPyramidWriter in trajectory_io.hpp):
+min/max/mean of x, y and z per bucket of steps on several levels of bucket size. load_lod() reads only the buckets of
+the requested range on the coarsest level that still resolves it, i.e. O(pixels) values instead of the whole trajectory.
+
+bifur_render writes the bifurcation diagram of a whole range as density rasters (<prefix>_counts.bin, see
+RasterHeader in bifur_render.cpp): per neuron a height x width histogram of the tail samples over (control parameter,
+state value), read with load_bifur_raster().
+
+sweep --grid summarises every point of a parameter plane into one grid file (data/grid/<name>[-<name2>]/
+grid_config-XXXXXXX-YYYYYYY.bin, see grid_summary.hpp): min/max/mean of x, y, z over the tail and optionally the last
+tail steps, read with load_grid() as (rows, cols) arrays.
+
+sweep --cache keeps the results in a content-addressed cache and records them in data/cache/manifest.txt (see
+result_cache.hpp); cached_configs() reads which configs are done from it.
+
+Run as a script, 'python3 hopfield_io.py missing <time-evol dir> <config_id_min> <config_id_max>' lists the config IDs
+without output (used by scripts/bash/find_missing_data.sh).
+"""
+
+import glob
+import io
+import os
+import re
+import sys
+from collections import deque
+
+import numpy as np
+
+BINARY_MAGIC = b"HFTRAJ01"
+HEADER_SIZE = 128
+
+_HEADER_DTYPE = np.dtype([
+    ("magic", "S8"),
+    ("header_size", "<u4"),
+    ("value_size", "<u4"),
+    ("n_iter", "<i8"),
+    ("nu", "<f8"),
+    ("x0", "<f8"), ("y0", "<f8"), ("z0", "<f8"),
+    ("w", "<f8", (9,)),
+])
+
+
+ARCHIVE_MAGIC = b"HFSWEEP1"
+ARCHIVE_STATUS = {0: "empty", 1: "params", 2: "done", 3: "failed"}
+
+_ARCHIVE_HEADER_DTYPE = np.dtype([
+    ("magic", "S8"),
+    ("header_size", "<u4"),
+    ("entry_size", "<u4"),
+    ("id_low", "<i8"), ("id_high", "<i8"),
+    ("data_offset", "<i8"),
+    ("reserved", "S24"),
+])
+
+ARCHIVE_ENTRY_DTYPE = np.dtype([
+    ("config_id", "<i8"),
+    ("status", "<i4"),
+    ("value_size", "<u4"),
+    ("offset", "<i8"), ("length", "<i8"),
+    ("n_rows", "<i8"), ("n_first", "<i8"),
+    ("nu", "<f8"),
+    ("x0", "<f8"), ("y0", "<f8"), ("z0", "<f8"),
+    ("w", "<f8", (9,)),
+    ("n_iter", "<i8"),
+])
+
+RASTER_MAGIC = b"HFBIFR01"
+
+_RASTER_HEADER_DTYPE = np.dtype([
+    ("magic", "S8"),
+    ("width", "<u4"), ("height", "<u4"),
+    ("n_configs", "<i8"), ("n_samples", "<i8"),
+    ("param_min", "<f8"), ("param_max", "<f8"),
+    ("value_min", "<f8", (3,)), ("value_max", "<f8", (3,)),
+    ("control_param_name", "S16"),
+    ("reserved", "S16"),
+])
+
+GRID_MAGIC = b"HFGRID01"
+_GRID_HEADER_DTYPE = np.dtype([
+    ("magic", "S8"),
+    ("header_size", "<u4"), ("record_size", "<u4"),
+    ("id_low", "<i8"), ("id_high", "<i8"),
+    ("rows", "<i4"), ("cols", "<i4"),
+    ("tail", "<i4"), ("n_samples", "<i4"),
+    ("n_iter", "<i8"),
+    ("param_name", "S16"), ("param_name2", "S16"),
+    ("reserved", "S40"),
+])
+_GRID_POINT_FIELDS = [
+    ("config_id", "<i8"), ("status", "<i4"), ("n_tail", "<i4"),
+    ("param", "<f8"), ("param2", "<f8"),
+    ("min", "<f8", (3,)), ("max", "<f8", (3,)), ("mean", "<f8", (3,)),
+]
+
+_ARCHIVE_NAME = re.compile(r"archive_config-(\d{7})-(\d{7})\.hfa$")
+_CONFIG_ID = re.compile(r"_config-(\d{7})\.\w+$")
+
+
+def _split_archive_path(path):
+    """("archive.hfa", config_id) for "archive.hfa#<config_id>", (path, None) otherwise."""
+    archive, sep, config_id = path.rpartition("#")
+    if sep and archive.endswith(".hfa"):
+        return archive, int(config_id)
+    return path, None
+
+
+def is_binary(path):
+    with open(path, "rb") as f:
+        return f.read(len(BINARY_MAGIC)) == BINARY_MAGIC
+
+
+def read_header(path):
+    """Parameters stored in a binary trajectory file as a dict (nu, x0, y0, z0, w (3x3), n_iter (number of rows),
+    n_first (step of the first row), dtype)."""
+    header = np.fromfile(path, dtype=_HEADER_DTYPE, count=1)[0]
+    if header["magic"] != BINARY_MAGIC:
+        raise ValueError(f"{path} is not a binary trajectory file")
+    n_first = 0
+    if header["header_size"] >= HEADER_SIZE + 8:
+        n_first = int(np.fromfile(path, dtype="<i8", count=1, offset=HEADER_SIZE)[0])
+    return {
+        "nu": float(header["nu"]),
+        "x0": float(header["x0"]), "y0": float(header["y0"]), "z0": float(header["z0"]),
+        "w": header["w"].reshape(3, 3).copy(),
+        "n_iter": int(header["n_iter"]),
+        "n_first": n_first,
+        "dtype": np.dtype("<f8") if header["value_size"] == 8 else np.dtype("<f4"),
+        "header_size": int(header["header_size"]),
+    }
+
+
+def read_archive_index(path):
+    """Header (dict with id_low, id_high, data_offset) and index (structured array, ARCHIVE_ENTRY_DTYPE) of a sweep
+    archive."""
+    header = np.fromfile(path, dtype=_ARCHIVE_HEADER_DTYPE, count=1)[0]
+    if header["magic"] != ARCHIVE_MAGIC:
+        raise ValueError(f"{path} is not a sweep archive")
+    n_entries = int(header["id_high"] - header["id_low"] + 1)
+    index = np.fromfile(path, dtype=ARCHIVE_ENTRY_DTYPE, count=n_entries, offset=int(header["header_size"]))
+    return {"id_low": int(header["id_low"]), "id_high": int(header["id_high"]),
+            "data_offset": int(header["data_offset"])}, index
+
+
+def read_archive_entry(path, config_id):
+    """Index entry of config_id in a sweep archive (one seek, the rest of the index is not read)."""
+    header = np.fromfile(path, dtype=_ARCHIVE_HEADER_DTYPE, count=1)[0]
+    if header["magic"] != ARCHIVE_MAGIC or not header["id_low"] <= config_id <= header["id_high"]:
+        raise ValueError(f"config {config_id} is not in the sweep archive {path}")
+    offset = int(header["header_size"]) + (config_id - int(header["id_low"])) * ARCHIVE_ENTRY_DTYPE.itemsize
+    return np.fromfile(path, dtype=ARCHIVE_ENTRY_DTYPE, count=1, offset=offset)[0]
+
+
+def load_trajectory(path):
+    """Returns (n, x, y, z) as numpy arrays for a CSV or binary trajectory file or a trajectory in a sweep archive
+    ("<archive>#<config ID>"), memmaps for everything but CSV."""
+    archive, config_id = _split_archive_path(path)
+    if config_id is not None:
+        entry = read_archive_entry(archive, config_id)
+        if entry["status"] != 2:
+            raise ValueError(f"config {config_id} in {archive} has no trajectory "
+                             f"(status {ARCHIVE_STATUS[int(entry['status'])]})")
+        n_rows, n_first = int(entry["n_rows"]), int(entry["n_first"])
+        dtype = np.dtype("<f8") if entry["value_size"] == 8 else np.dtype("<f4")
+        columns = np.memmap(archive, dtype=dtype, mode="r", offset=int(entry["offset"]), shape=(3, n_rows))
+        return np.arange(n_first, n_first + n_rows), columns[0], columns[1], columns[2]
+
+    if is_binary(path):
+        header = read_header(path)
+        n_iter = header["n_iter"]
+        columns = np.memmap(path, dtype=header["dtype"], mode="r", offset=header["header_size"], shape=(3, n_iter))
+        return np.arange(header["n_first"], header["n_first"] + n_iter), columns[0], columns[1], columns[2]
+
+    data = np.loadtxt(path, delimiter=",", skiprows=1, ndmin=2)
+    return data[:, 0].astype(int), data[:, 1], data[:, 2], data[:, 3]
+
+
+def load_range(path, step_min, step_max):
+    """Returns (n, x, y, z) of the steps step_min..step_max only (binary files and archives are sliced without reading
+    the rest, for CSV only these lines are parsed)."""
+    archive, config_id = _split_archive_path(path)
+    if config_id is not None or is_binary(path):
+        n, x, y, z = load_trajectory(path)
+        if len(n) == 0:
+            return n, x, y, z
+        first = max(step_min - int(n[0]), 0)
+        last = max(step_max - int(n[0]) + 1, first)
+        return n[first:last], np.asarray(x[first:last]), np.asarray(y[first:last]), np.asarray(z[first:last])
+
+    with open(path, "r") as f:
+        f.readline()
+        first_line = f.readline()
+    if not first_line:
+        return np.array([], dtype=int), np.array([]), np.array([]), np.array([])
+    n_first = int(first_line.split(",")[0])
+    skip = max(step_min - n_first, 0)
+    data = np.loadtxt(path, delimiter=",", skiprows=1 + skip, max_rows=max(step_max - n_first - skip + 1, 0), ndmin=2)
+    return data[:, 0].astype(int), data[:, 1], data[:, 2], data[:, 3]
+
+
+LOD_MAGIC = b"HFLOD001"
+
+
+def lod_path(path):
+    """Level-of-detail sidecar of a trajectory file (time-evol --lod), None if it was not written."""
+    if _split_archive_path(path)[1] is not None:
+        return None
+    sidecar = path + ".lod"
+    return sidecar if os.path.isfile(sidecar) else None
+
+
+def load_lod(path, step_min, step_max, max_buckets=2000):
+    """Min/max/mean envelope of the steps step_min..step_max from the .lod sidecar 'path', on the finest level with at
+    most max_buckets buckets in that range. Returns (n, x, y, z): n holds the first step of every bucket and x, y, z
+    are (min, max, mean) tuples of arrays. Only the records of the selected buckets are read."""
+    header = np.fromfile(path, dtype=np.dtype([
+        ("magic", "S8"), ("header_size", "<u4"), ("n_levels", "<u4"), ("n_first", "<i8"), ("n_rows", "<i8"),
+        ("base_bucket", "<i8"), ("factor", "<i8")]), count=1)[0]
+    if header["magic"] != LOD_MAGIC:
+        raise ValueError(f"{path} is not a level-of-detail file")
+    n_first, n_rows = int(header["n_first"]), int(header["n_rows"])
+    levels = np.fromfile(path, dtype="<i8", count=3 * int(header["n_levels"]),
+                         offset=int(header["header_size"])).reshape(-1, 3)
+
+    row_min = min(max(step_min - n_first, 0), n_rows - 1)
+    row_max = min(max(step_max - n_first, row_min), n_rows - 1)
+    for bucket_size, n_buckets, offset in levels:
+        first, last = row_min // bucket_size, min(row_max // bucket_size, n_buckets - 1)
+        if last - first + 1 <= max_buckets or bucket_size == levels[-1][0]:
+            break
+
+    records = np.memmap(path, dtype="<f8", mode="r", offset=int(offset), shape=(int(n_buckets), 9))[first:last + 1]
+    records = np.asarray(records)
+    n = n_first + np.arange(first, last + 1) * int(bucket_size)
+    x, y, z = [(records[:, 3*c], records[:, 3*c + 1], records[:, 3*c + 2]) for c in range(3)]
+    return n, x, y, z
+
+
+def load_tail(path, n_last):
+    """Returns (x, y, z) of the last n_last steps without reading the rest of the file."""
+    if _split_archive_path(path)[1] is not None or is_binary(path):
+        _, x, y, z = load_trajectory(path)
+        return np.asarray(x[-n_last:]), np.asarray(y[-n_last:]), np.asarray(z[-n_last:])
+
+    # CSV: only the last n_last lines are kept in memory (emulating 'tail' bash command)
+    with open(path, "r") as f:
+        last_lines = deque(f, n_last)
+    rows = [line.strip().split(",") for line in last_lines if line[0].isdigit()]  # skips the "n,x,y,z" header
+    data = np.array([[float(v) for v in row[1:]] for row in rows]).reshape(-1, 3)
+    return data[:, 0], data[:, 1], data[:, 2]
+
+
+def is_bifurcation(path):
+    """True for an aggregated bifurcation file written by sweep --bifur (header "config_id,<param>,n,x,y,z")."""
+    with open(path, "rb") as f:
+        return f.read(len(b"config_id,")) == b"config_id,"
+
+
+def load_bifurcation(path):
+    """Returns (control_param_name, config_id, control_param, n, x, y, z) of an aggregated bifurcation file, one array
+    entry per stored step (the tail samples of all configs of the range, in config ID order). sweep appends the configs
+    in the order they finish, so the rows are sorted here; an unterminated last line (a job killed while writing it)
+    is left out."""
+    with open(path, "r") as f:
+        control_param_name = f.readline().strip().split(",")[1]
+        text = f.read()
+    text = text[:text.rfind("\n") + 1]
+    data = np.loadtxt(io.StringIO(text), delimiter=",", ndmin=2).reshape(-1, 6)
+    data = data[np.lexsort((data[:, 2], data[:, 0]))]
+    return control_param_name, data[:, 0].astype(int), data[:, 1], data[:, 2].astype(int), data[:, 3], data[:, 4], data[:, 5]
+
+
+def load_bifur_raster(path):
+    """Returns (header, counts) of a bifur_render counts file: counts has shape (3, height, width) (neuron, value bin
+    from the largest value down, control parameter column); the axis ranges are in header["param_min"],
+    header["param_max"], header["value_min"][c] and header["value_max"][c]."""
+    header = np.fromfile(path, dtype=_RASTER_HEADER_DTYPE, count=1)[0]
+    if header["magic"] != RASTER_MAGIC:
+        raise ValueError(f"{path} is not a bifurcation raster")
+    width, height = int(header["width"]), int(header["height"])
+    counts = np.fromfile(path, dtype="<u4", count=3 * height * width, offset=_RASTER_HEADER_DTYPE.itemsize)
+    return header, counts.reshape(3, height, width)
+
+
+def load_grid(path):
+    """Returns (header, points, samples) of a sweep --grid file: points is a structured array of shape (rows, cols)
+    with the fields config_id, status (0 not solved, 1 done, 2 failed), n_tail, param, param2 and min/max/mean (3
+    values each, x/y/z over the tail); samples has shape (rows, cols, n_samples, 3) and holds the last tail steps
+    (NaN where the tail was shorter). Row i is the i-th value of header["param_name"], column j the j-th value of
+    header["param_name2"]."""
+    header = np.fromfile(path, dtype=_GRID_HEADER_DTYPE, count=1)[0]
+    if header["magic"] != GRID_MAGIC:
+        raise ValueError(f"{path} is not a grid file")
+    rows, cols, n_samples = int(header["rows"]), int(header["cols"]), int(header["n_samples"])
+    fields = list(_GRID_POINT_FIELDS)
+    if n_samples > 0:
+        fields.append(("samples", "<f8", (n_samples, 3)))
+    record = np.dtype(fields)
+    assert record.itemsize == header["record_size"]
+    data = np.memmap(path, dtype=record, mode="r", offset=int(header["header_size"]), shape=(rows, cols))
+    samples = data["samples"] if n_samples > 0 else np.empty((rows, cols, 0, 3))
+    return header, data[[name for name, *_ in _GRID_POINT_FIELDS]], samples
+
+
+def find_archive(directory, config_id):
+    """Sweep archive in 'directory' whose range holds config_id, None if there is none."""
+    for archive in glob.glob(os.path.join(directory, "archive_config-*.hfa")):
+        match = _ARCHIVE_NAME.search(archive)
+        if match and int(match.group(1)) <= config_id <= int(match.group(2)):
+            return archive
+    return None
+
+
+def resolve_path(path):
+    """'path' itself if it exists, otherwise the same file with the other extension (.csv <-> .bin), so that scripts
+    building time-evol_config-XXXXXXX.csv paths also find runs written with --format=bin, otherwise
+    "<archive>#<config ID>" if a sweep archive next to it holds the trajectory. None if none of them exists."""
+    if os.path.isfile(path):
+        return path
+    stem, extension = os.path.splitext(path)
+    other = stem + (".bin" if extension == ".csv" else ".csv")
+    if os.path.isfile(other):
+        return other
+
+    match = _CONFIG_ID.search(path)
+    if match:
+        config_id = int(match.group(1))
+        archive = find_archive(os.path.dirname(path), config_id)
+        if archive is not None and read_archive_entry(archive, config_id)["status"] == 2:
+            return f"{archive}#{config_id}"
+    return None
+
+
+def cached_configs(directory):
+    """Config IDs of the time-evol directory 'directory' (data/time-evol/<control param>) that the result cache manifest
+    records as linked to a complete result (sweep --cache), empty if there is no manifest. The manifest is trusted:
+    a link removed by hand still counts as done until the config is solved again."""
+    manifest = os.path.join(directory, os.pardir, os.pardir, "cache", "manifest.txt")
+    if not os.path.isfile(manifest):
+        return set()
+
+    control_param_name = os.path.basename(os.path.normpath(directory))
+    results, links = set(), []
+    with open(manifest) as file:
+        for line in file:
+            fields = line.rstrip("\n").split("\t")
+            if fields[0] == "R" and len(fields) == 3:
+                results.add(fields[1])
+            elif fields[0] == "C" and len(fields) == 4 and fields[1] == control_param_name:
+                links.append((int(fields[2]), fields[3]))
+    # The last link of a config wins (a config whose parameters changed is linked to the new result)
+    latest = dict(links)
+    return {config_id for config_id, result in latest.items() if result in results}
+
+
+def missing_configs(directory, config_id_min, config_id_max):
+    """Config IDs in config_id_min..config_id_max without a time-evol result in 'directory' (neither a .csv/.bin file
+    nor a finished entry in a sweep archive). Each archive index and the result cache manifest are read once, only
+    the configs they do not cover are checked file by file."""
+    done = cached_configs(directory)
+    for archive in glob.glob(os.path.join(directory, "archive_config-*.hfa")):
+        _, index = read_archive_index(archive)
+        done.update(int(i) for i in index["config_id"][index["status"] == 2])
+
+    missing = []
+    for config_id in range(config_id_min, config_id_max + 1):
+        if config_id in done:
+            continue
+        stem = os.path.join(directory, f"time-evol_config-{config_id:07d}")
+        if not os.path.isfile(stem + ".csv") and not os.path.isfile(stem + ".bin"):
+            missing.append(config_id)
+    return missing
+
+
+if __name__ == "__main__":
+    if len(sys.argv) == 5 and sys.argv[1] == "missing":
+        for config_id in missing_configs(sys.argv[2], int(sys.argv[3]), int(sys.argv[4])):
+            print(config_id)
+    else:
+        print("usage: python3 hopfield_io.py missing <time-evol dir> <config_id_min> <config_id_max>")
+        sys.exit(1)
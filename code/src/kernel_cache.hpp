@@ -0,0 +1,395 @@
+#pragma once
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <filesystem>
+#include <sstream>
+#include <cmath>
+#include <cstdint>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <gsl/gsl_sf_gamma.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+/* Since computing gamma functions of large values leads to numeric overflow I will use a trick:
+* Instead of calculating gamma(a)/gamma(b), where a=n-j+nu, b=n-j+1, one can calculate a natural logarithm of this
+* fraction using gsl_sf_lngamma: alpha = ln( gamma(a) / gamma(b)) = ln( gamma(a) ) - ln( gamma(b) )
+* Once the alpha is calculated (which is not supposed to be an enormous number) we can simply exponentiate it
+* and get the final result used for further calculations:
+*
+* gammafrac = std::exp(alpha)
+*
+* Two lngamma calls and an exp per entry are only needed every kernel_anchor_interval entries though. In between the
+* ratio recurrence
+*
+*      gammafrac[k] = gamma(k+nu)/gamma(k+1) = gammafrac[k-1] * (k-1+nu) / k
+*
+* costs one multiplication and one division. Each step adds at most ~1 ulp of relative error, so re-anchoring to the
+* lngamma value every kernel_anchor_interval entries keeps the drift below ~kernel_anchor_interval * 1e-16 (relative).
+*
+* The recurrence changes the kernel by rounding, and chaotic trajectories pick that up after a few thousand steps. With
+* an anchor interval of 1 (--kernel=lngamma) every entry is computed from lngamma as it always was, which together with
+* the scalar summation order (--simd=scalar) reproduces older results bit for bit. */
+constexpr int kernel_anchor_interval = 256;
+
+// Anchor interval of the kernel selected by --kernel=<method>: 'recurrence' (default) or 'lngamma', 0 if unknown
+inline int kernelAnchorInterval(const std::string& method)
+{
+    if(method == "recurrence") return kernel_anchor_interval;
+    if(method == "lngamma") return 1;
+    return 0;
+}
+
+inline std::vector<double> buildGammafracCache(double nu, int n_iter, int anchor_interval=kernel_anchor_interval)
+{
+    std::vector<double> gammafrac_cache(n_iter, 0.0);
+    const int n_max = n_iter - 1; // must substract one cuz 'n' is always less than 'n_iter' (look at nested for loops in HopfieldNetwork::solve())
+    for(int k=0; k<n_max; k++) {
+        if(k % anchor_interval == 0) {
+            double alpha {0.0};
+            alpha = gsl_sf_lngamma(k+nu) - gsl_sf_lngamma(k+1);
+            gammafrac_cache[k] = std::exp(alpha);
+        }
+        else gammafrac_cache[k] = gammafrac_cache[k-1] * (k-1+nu) / k;
+    }
+    return gammafrac_cache;
+}
+
+/*
+ * Read-only view of a gammafrac_cache, either built in memory or mapped from the on-disk kernel cache. Engines only
+ * read the kernel, so they take it through this type and do not care where it lives.
+ */
+class GammafracKernel
+{
+    std::vector<double> owned;
+    const double* ptr {nullptr};
+    size_t n {0};
+    void* map {nullptr};
+    size_t map_length {0};
+
+public:
+    GammafracKernel() = default;
+    explicit GammafracKernel(std::vector<double>&& values) : owned(std::move(values)), ptr(owned.data()), n(owned.size()) {}
+    GammafracKernel(void* map_, size_t map_length_, const double* values, size_t n_)
+        : ptr(values), n(n_), map(map_), map_length(map_length_) {}
+
+    GammafracKernel(const GammafracKernel&) = delete;
+    GammafracKernel& operator=(const GammafracKernel&) = delete;
+    GammafracKernel(GammafracKernel&& other) noexcept {*this = std::move(other);}
+    GammafracKernel& operator=(GammafracKernel&& other) noexcept
+    {
+        if(this == &other) return *this;
+        if(map != nullptr) munmap(map, map_length);
+        owned = std::move(other.owned);
+        ptr = owned.empty() ? other.ptr : owned.data();
+        n = other.n;
+        map = other.map;
+        map_length = other.map_length;
+        other.ptr = nullptr;
+        other.n = 0;
+        other.map = nullptr;
+        other.map_length = 0;
+        return *this;
+    }
+    ~GammafracKernel() {if(map != nullptr) munmap(map, map_length);}
+
+    const double* data() const {return ptr;}
+    size_t size() const {return n;}
+    const double* begin() const {return ptr;}
+    const double* end() const {return ptr + n;}
+    double operator[](size_t k) const {return ptr[k];}
+    bool mapped() const {return map != nullptr;}
+};
+
+/*
+ * On-disk kernel cache. Every process of a sweep in which the control parameter is a weight or an initial state needs
+ * the very same kernel, so it can be stored once in
+ *
+ *      <cache dir>/gammafrac_nu-<bits of nu in hex>_a-<anchor interval>_n-<n_iter>.bin
+ *
+ * and mapped read-only by all later processes (processes on one node then share a single page-cache copy). The file
+ * starts with a KernelCacheHeader, the doubles follow at offset 64. It is written to a temporary file first and renamed
+ * into place, so a reader sees either nothing or the complete file, also when several processes race to create it.
+ *
+ * The anchor interval is part of the name since it changes the kernel (--kernel=lngamma has its own files). The
+ * entries do not depend on n_iter (the anchors sit at multiples of the anchor interval), and the last entry
+ * gammafrac_cache[n_iter-1] is never read by any engine (step n < n_iter only uses entries up to n-1). A file stored
+ * for a larger n_iter therefore serves every shorter run with the same nu: its first n_iter entries are mapped.
+ *
+ * The cache directory is $HOPFIELD_KERNEL_CACHE, or $PROJECT/data/kernel_cache if that is not set; setting
+ * HOPFIELD_KERNEL_CACHE=off (or to an empty string) disables the cache. Existing files are always used, but a missing
+ * kernel is only written when HOPFIELD_KERNEL_CACHE_WRITE=1: a sweep over nu needs a different kernel in every
+ * process, and writing all of them would only fill the disk (one file of 8*n_iter bytes per nu) with files nobody
+ * reads again. Nothing is ever evicted; the cache can be removed at any time (rm -rf <cache dir>), or trimmed to the
+ * files not used for a while with e.g. find <cache dir> -name 'gammafrac_*' -atime +30 -delete. Any problem with the
+ * cache is reported and the kernel is simply built in memory.
+ */
+struct KernelCacheHeader
+{
+    char magic[8];          // "HFKERN01"
+    double nu;
+    std::int64_t n_iter;
+    std::int64_t anchor_interval;
+    std::int64_t data_offset;
+};
+
+constexpr char kernel_cache_magic[8] = {'H', 'F', 'K', 'E', 'R', 'N', '0', '1'};
+constexpr std::int64_t kernel_cache_data_offset = 64;
+
+inline fs::path kernelCacheDir()
+{
+    const char* dir = std::getenv("HOPFIELD_KERNEL_CACHE");
+    if(dir != nullptr) return (std::string(dir) == "off") ? fs::path() : fs::path(dir);
+
+    const char* project = std::getenv("PROJECT");
+    if(project != nullptr && *project != '\0') return fs::path(project) / "data" / "kernel_cache";
+    return fs::path();
+}
+
+inline fs::path kernelCachePath(const fs::path& dir, double nu, int n_iter, int anchor_interval)
+{
+    std::uint64_t nu_bits;
+    std::memcpy(&nu_bits, &nu, sizeof(nu_bits));
+
+    std::ostringstream oss;
+    oss << "gammafrac_nu-" << std::hex << std::setw(16) << std::setfill('0') << nu_bits << std::dec
+        << "_a-" << anchor_interval << "_n-" << n_iter << ".bin";
+    return dir / oss.str();
+}
+
+// Maps an existing cache file, returns false (and leaves 'kernel' alone) if it is missing, does not match nu or the
+// anchor interval or holds fewer than n_iter entries; the kernel then views the first n_iter entries of the file
+inline bool mapKernelCache(const fs::path& path, double nu, int n_iter, int anchor_interval, GammafracKernel& kernel)
+{
+    const int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0) return false;
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (size_t)st.st_size < kernel_cache_data_offset + (size_t)n_iter * sizeof(double))
+    {
+        close(fd);
+        return false;
+    }
+
+    const size_t length = (size_t)st.st_size;
+    void* map = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED) return false;
+
+    KernelCacheHeader header;
+    std::memcpy(&header, map, sizeof(header));
+    if(std::memcmp(header.magic, kernel_cache_magic, sizeof(header.magic)) != 0 || std::memcmp(&header.nu, &nu, sizeof(nu)) != 0
+       || header.n_iter < n_iter || header.anchor_interval != anchor_interval || header.data_offset != kernel_cache_data_offset
+       || length != kernel_cache_data_offset + (size_t)header.n_iter * sizeof(double))
+    {
+        munmap(map, length);
+        return false;
+    }
+
+    kernel = GammafracKernel(map, length, (const double*)((const char*)map + kernel_cache_data_offset), (size_t)n_iter);
+    return true;
+}
+
+// Maps the kernel of (nu, n_iter) from 'dir': the file for exactly n_iter, otherwise the smallest one of the same nu
+// and anchor interval with more entries. Returns the path of the mapped file, or an empty path if there is none.
+inline fs::path findKernelCache(const fs::path& dir, double nu, int n_iter, int anchor_interval, GammafracKernel& kernel)
+{
+    const fs::path exact = kernelCachePath(dir, nu, n_iter, anchor_interval);
+    if(mapKernelCache(exact, nu, n_iter, anchor_interval, kernel)) return exact;
+
+    // "gammafrac_nu-<bits>_a-<anchor interval>_n-" without the n_iter and the extension
+    const std::string exact_name = exact.filename().string();
+    const std::string prefix = exact_name.substr(0, exact_name.rfind("_n-") + 3);
+    const std::string extension = ".bin";
+
+    std::error_code ec;
+    fs::path best;
+    long long best_n = -1;
+    for(fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec))
+    {
+        const std::string name = it->path().filename().string();
+        if(name.size() <= prefix.size() + extension.size() || name.compare(0, prefix.size(), prefix) != 0
+           || name.compare(name.size() - extension.size(), extension.size(), extension) != 0) continue;
+
+        const std::string digits = name.substr(prefix.size(), name.size() - prefix.size() - extension.size());
+        if(digits.find_first_not_of("0123456789") != std::string::npos) continue;
+        const long long n = std::atoll(digits.c_str());
+        if(n > n_iter && (best_n < 0 || n < best_n))
+        {
+            best = it->path();
+            best_n = n;
+        }
+    }
+
+    if(!best.empty() && mapKernelCache(best, nu, n_iter, anchor_interval, kernel)) return best;
+    return fs::path();
+}
+
+// Whether a kernel missing from the cache is written to it (HOPFIELD_KERNEL_CACHE_WRITE=1)
+inline bool kernelCacheWritable()
+{
+    const char* write = std::getenv("HOPFIELD_KERNEL_CACHE_WRITE");
+    return write != nullptr && std::string(write) == "1";
+}
+
+// Writes the kernel to a temporary file next to 'path' and renames it into place, returns false on any error
+inline bool writeKernelCache(const fs::path& path, double nu, int n_iter, int anchor_interval,
+                             const std::vector<double>& gammafrac_cache)
+{
+    char hostname[256] = "host";
+    gethostname(hostname, sizeof(hostname) - 1);
+    fs::path tmp_path = path;
+    static std::atomic<int> n_written {0}; // threads of one process (sweep) may write at the same time as well
+    tmp_path += ".tmp." + std::string(hostname) + "." + std::to_string(getpid()) + "." + std::to_string(n_written++);
+
+    KernelCacheHeader header {};
+    std::memcpy(header.magic, kernel_cache_magic, sizeof(header.magic));
+    header.nu = nu;
+    header.n_iter = n_iter;
+    header.anchor_interval = anchor_interval;
+    header.data_offset = kernel_cache_data_offset;
+
+    char padded_header[kernel_cache_data_offset] = {};
+    std::memcpy(padded_header, &header, sizeof(header));
+
+    {
+        std::ofstream file(tmp_path, std::ios::binary);
+        if(!file) return false;
+        file.write(padded_header, sizeof(padded_header));
+        file.write((const char*)gammafrac_cache.data(), (std::streamsize)(gammafrac_cache.size() * sizeof(double)));
+        if(!file)
+        {
+            file.close();
+            std::error_code ec;
+            fs::remove(tmp_path, ec);
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    fs::rename(tmp_path, path, ec);
+    if(ec)
+    {
+        fs::remove(tmp_path, ec);
+        return false;
+    }
+    return true;
+}
+
+// Kernel for (nu, n_iter) with the given anchor interval (kernelAnchorInterval): mapped from the cache if it is there,
+// otherwise built (and stored in the cache if enabled)
+inline GammafracKernel loadGammafracKernel(double nu, int n_iter, int anchor_interval, bool verbose=false)
+{
+    const fs::path dir = kernelCacheDir();
+    if(dir.empty()) return GammafracKernel(buildGammafracCache(nu, n_iter, anchor_interval));
+
+    GammafracKernel kernel;
+    const fs::path mapped = findKernelCache(dir, nu, n_iter, anchor_interval, kernel);
+    if(!mapped.empty())
+    {
+        if(verbose) std::cout << "gammafrac_cache mapped from " << mapped << '\n';
+        return kernel;
+    }
+
+    std::vector<double> gammafrac_cache = buildGammafracCache(nu, n_iter, anchor_interval);
+    if(!kernelCacheWritable()) return GammafracKernel(std::move(gammafrac_cache));
+
+    const fs::path path = kernelCachePath(dir, nu, n_iter, anchor_interval);
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    if(writeKernelCache(path, nu, n_iter, anchor_interval, gammafrac_cache))
+    {
+        if(verbose) std::cout << "gammafrac_cache stored in " << path << '\n';
+
+        // Mapping the file just written instead of keeping the private copy, so that concurrent processes on this node
+        // share the pages
+        if(mapKernelCache(path, nu, n_iter, anchor_interval, kernel)) return kernel;
+    }
+    else std::cerr << "WARNING could not write kernel cache " << path << ", continuing without it\n";
+
+    return GammafracKernel(std::move(gammafrac_cache));
+}
+
+/*
+ * Kernels shared by the networks of one process (sweep --grid): all points of a parameter plane with the same nu need
+ * the same kernel, so it is loaded once per (nu, n_iter) group instead of once per point. The number of users of each
+ * group is announced up front with expect(); acquire() loads the kernel for the first user (other groups are loaded
+ * in parallel) and release() frees it after the last one, so only the kernels of the groups in progress are held.
+ */
+class SharedKernels
+{
+    struct Group
+    {
+        std::mutex mutex;
+        GammafracKernel kernel;
+        bool loaded {false};
+        int users {0};
+    };
+
+    std::mutex mutex;
+    std::map<std::pair<std::uint64_t, int>, std::shared_ptr<Group>> groups;
+    int anchor_interval; // of all kernels (every network of the process uses the same --kernel method)
+
+    static std::pair<std::uint64_t, int> key(double nu, int n_iter)
+    {
+        std::uint64_t nu_bits;
+        std::memcpy(&nu_bits, &nu, sizeof(nu_bits));
+        return {nu_bits, n_iter};
+    }
+
+public:
+    explicit SharedKernels(int anchor_interval_=kernel_anchor_interval) : anchor_interval(anchor_interval_) {}
+
+    void expect(double nu, int n_iter)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::shared_ptr<Group>& group = groups[key(nu, n_iter)];
+        if(!group) group = std::make_shared<Group>();
+        group->users++;
+    }
+
+    // Kernel of (nu, n_iter), valid until the matching release()
+    const GammafracKernel* acquire(double nu, int n_iter)
+    {
+        std::shared_ptr<Group> group;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto found = groups.find(key(nu, n_iter));
+            if(found == groups.end()) return nullptr;
+            group = found->second;
+        }
+        std::lock_guard<std::mutex> lock(group->mutex);
+        if(!group->loaded)
+        {
+            group->kernel = loadGammafracKernel(nu, n_iter, anchor_interval);
+            group->loaded = true;
+        }
+        return &group->kernel;
+    }
+
+    void release(double nu, int n_iter)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = groups.find(key(nu, n_iter));
+        if(found != groups.end() && --found->second->users == 0) groups.erase(found);
+    }
+
+    int size()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return (int)groups.size();
+    }
+};
@@ -2,12 +2,8 @@ import os
 import sys
 import matplotlib.pyplot as plt
 import numpy as np
-from collections import deque
 
-# Returns N last lines of a file (emulating 'tail' bash command)
-def tail(fname, N):
-    with open(fname, 'r') as f:
-        return list(deque(f, N))
+import hopfield_io
 
 if __name__ == '__main__':
     
@@ -41,22 +37,23 @@ if __name__ == '__main__':
                     continue
 
                 f_data_path = f_data_path.strip()
-                last_n_data_lines = tail(f_data_path, n_iter_last)
+                f_data_path = hopfield_io.resolve_path(f_data_path) or f_data_path # CSV or binary (--format=bin) output
+
+                # Aggregated bifurcation file (sweep --bifur): tails of a whole range of configs with their control
+                # parameter values, only the last n_iter_last steps of each config are plotted
+                if hopfield_io.is_bifurcation(f_data_path):
+                    _, _, control_param_vals, n_vals, x_vals, y_vals, z_vals = hopfield_io.load_bifurcation(f_data_path)
+                    last = n_vals >= n_iter - n_iter_last
+                    all_control_param_vals.extend(control_param_vals[last])
+                    all_x.extend(x_vals[last])
+                    all_y.extend(y_vals[last])
+                    all_z.extend(z_vals[last])
+                    continue
 
                 control_param_val = control_param_min + i*control_param_step
                 control_param_vals = np.ones(n_iter_last) * control_param_val
                 # x, y and z values associated with a single parameter configuration (a single value of control parameter)
-                x_vals = []
-                y_vals = []
-                z_vals = []
-
-                for data_line in last_n_data_lines:
-                    data_in_row = data_line.strip().split(',')
-                    x, y, z = map(float, data_in_row[1:]) # skips the first value (int: n_iter)
-
-                    x_vals.append(x)
-                    y_vals.append(y)
-                    z_vals.append(z)
+                x_vals, y_vals, z_vals = hopfield_io.load_tail(f_data_path, n_iter_last)
 
                 # TUTAJ PLOTUJ DANE DLA POJEDYNCZEJ WARTOSCI PARAMETRU
                 all_control_param_vals.extend(control_param_vals)
@@ -0,0 +1,45 @@
+import sys
+import matplotlib.pyplot as plt
+import numpy as np
+
+import hopfield_io
+
+# Bifurcation diagram from the density rasters of bifur_render (<prefix>_counts.bin): the points are already binned,
+# so only the three images and the axes are drawn, independently of the number of configs and tail steps.
+if __name__ == '__main__':
+
+    counts_path = sys.argv[1]
+    bifur_xyz_figure_path = sys.argv[2]
+    graphic_file_extension = sys.argv[3]
+
+    n_iter = int(sys.argv[4])
+    n_iter_last = int(sys.argv[5])
+
+    header, counts = hopfield_io.load_bifur_raster(counts_path)
+    control_param_name = header["control_param_name"].decode()
+
+    # Column k is centred on param_min + k*(param_max - param_min)/(width - 1)
+    width = counts.shape[2]
+    half_column = 0.5 * (header["param_max"] - header["param_min"]) / max(width - 1, 1)
+
+    fig, (ax_x, ax_y, ax_z) = plt.subplots(3, 1, figsize=(8, 10), sharex=True)
+
+    for c, (ax, cmap, label) in enumerate(zip((ax_x, ax_y, ax_z), ('Reds', 'Greens', 'Blues'), ('x', 'y', 'z'))):
+        density = np.log1p(counts[c].astype(float))
+        density = np.ma.masked_equal(density, 0.0) # no sample: background stays white
+        extent = (header["param_min"] - half_column, header["param_max"] + half_column, header["value_min"][c], header["value_max"][c])
+        ax.imshow(density, extent=extent, aspect='auto', origin='upper', cmap=cmap, interpolation='nearest')
+
+        ax.set_xlabel(control_param_name)
+        ax.set_ylabel(label)
+
+    fig.tight_layout()
+
+    fig.suptitle(f"N_ITER={n_iter}, N_ITER_LAST={n_iter_last}")
+
+    if graphic_file_extension == "pdf":
+        fig.savefig(bifur_xyz_figure_path, format=graphic_file_extension)
+    elif graphic_file_extension == "png":
+        fig.savefig(bifur_xyz_figure_path, dpi=400)
+    else:
+        print("The graphic file extension is incorrect\n")
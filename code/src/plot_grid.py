@@ -0,0 +1,48 @@
+import sys
+import matplotlib.pyplot as plt
+import numpy as np
+
+import hopfield_io
+
+# Parameter-plane diagram from a sweep --grid file: the tail amplitude (max - min over the tail) of x, y and z at every
+# point, which separates fixed points (amplitude 0) from oscillating and chaotic regimes.
+if __name__ == '__main__':
+
+    grid_path = sys.argv[1]
+    grid_figure_path = sys.argv[2]
+    graphic_file_extension = sys.argv[3]
+
+    header, points, samples = hopfield_io.load_grid(grid_path)
+    param_name = header["param_name"].decode()
+    param_name2 = header["param_name2"].decode() or "-"
+
+    done = points["status"] == 1
+    amplitude = np.where(done[..., None], points["max"] - points["min"], np.nan)
+
+    # Cell (i, j) is centred on (param2[i, j], param[i, j])
+    param, param2 = points["param"], points["param2"]
+    rows, cols = param.shape
+    half_row = 0.5 * (param[-1, 0] - param[0, 0]) / max(rows - 1, 1)
+    half_col = 0.5 * (param2[0, -1] - param2[0, 0]) / max(cols - 1, 1) if cols > 1 else 0.5
+    extent = (param2[0, 0] - half_col, param2[0, -1] + half_col, param[0, 0] - half_row, param[-1, 0] + half_row)
+    if cols == 1:
+        extent = (-0.5, 0.5, extent[2], extent[3])
+
+    fig, axes = plt.subplots(1, 3, figsize=(15, 5), sharey=True)
+
+    for c, (ax, label) in enumerate(zip(axes, ('x', 'y', 'z'))):
+        image = ax.imshow(amplitude[:, :, c], extent=extent, aspect='auto', origin='lower', cmap='viridis', interpolation='nearest')
+        fig.colorbar(image, ax=ax, label=f"{label} tail amplitude")
+        ax.set_xlabel(param_name2)
+    axes[0].set_ylabel(param_name)
+
+    fig.tight_layout()
+
+    fig.suptitle(f"N_ITER={header['n_iter']}, tail={header['tail']}")
+
+    if graphic_file_extension == "pdf":
+        fig.savefig(grid_figure_path, format=graphic_file_extension)
+    elif graphic_file_extension == "png":
+        fig.savefig(grid_figure_path, dpi=400)
+    else:
+        print("The graphic file extension is incorrect\n")
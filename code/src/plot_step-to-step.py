@@ -2,6 +2,8 @@ import sys
 import numpy as np
 import matplotlib.pyplot as plt
 
+import hopfield_io
+
 # -----------------------------
 # Command-line arguments
 # -----------------------------
@@ -14,12 +16,8 @@ step_max = int(step_max)
 # -----------------------------
 # Load data
 # -----------------------------
-# Assume CSV has 4 columns: index, x, y, z
-data = np.loadtxt(data_csv, delimiter=',')
-indices = data[:, 0].astype(int)
-x_values = data[:, 1]
-y_values = data[:, 2]
-z_values = data[:, 3]
+# CSV with 4 columns (index, x, y, z) or binary columnar file (--format=bin), only step_min..step_max is read
+indices, x_values, y_values, z_values = hopfield_io.load_range(hopfield_io.resolve_path(data_csv) or data_csv, step_min, step_max)
 
 # -----------------------------
 # Select steps
@@ -1,8 +1,9 @@
 import sys
 import os
-import pandas as pd
 import matplotlib.pyplot as plt
 
+import hopfield_io
+
 N_ITER = int(sys.argv[1])
 data_path = sys.argv[2]
 xyz_figure_path = sys.argv[3]
@@ -10,21 +11,20 @@ graphic_file_extension = sys.argv[4]
 n_iter_init = int(sys.argv[5])  # Initial iteration on x-axis that will get displayed
 n_iter_fin = int(sys.argv[6])   # Final iteration on x-axis that will get displayed
 
-if not os.path.isfile(data_path):
+data_path_found = hopfield_io.resolve_path(data_path)  # CSV or binary (--format=bin) output
+if data_path_found is None:
     print(f"[SKIP] Data was not found in {data_path}")
     sys.exit(0)
 
-data = pd.read_csv(data_path)
-
-n_col = data.columns[0]
-x_col = data.columns[1]
-y_col = data.columns[2]
-z_col = data.columns[3]
+n_col, x_col, y_col, z_col = "n", "x", "y", "z"
 
-n = data[n_col]
-x = data[x_col]
-y = data[y_col]
-z = data[z_col]
+# Long ranges are drawn as min/max envelopes from the level-of-detail sidecar (time-evol --lod) if there is one, so
+# that only O(pixels) values are read; otherwise only the steps n_iter_init..n_iter_fin are loaded
+max_points = 4000
+lod_path = hopfield_io.lod_path(data_path_found)
+use_lod = lod_path is not None and n_iter_fin - n_iter_init + 1 > max_points
+if not use_lod:
+    n, x, y, z = hopfield_io.load_range(data_path_found, n_iter_init, n_iter_fin)
 
 num_ranges = 4
 range_step = (n_iter_fin - n_iter_init + 1) // num_ranges  # e.g. 99 - 0 + 1 = 100
@@ -32,14 +32,23 @@ ranges = [(n_iter_init + i * range_step, n_iter_init + (i+1) * range_step) for i
 
 fig, axs = plt.subplots(1, 3, figsize=(18, 5), dpi=150)  # 1 row, 3 columns
 
-variables = [(x, x_col, 'red'), (y, y_col, 'green'), (z, z_col, 'blue')]
-
-for ax, (variable, var_name, color) in zip(axs, variables):
-    y_min, y_max = variable.min(), variable.max()
+for c, (ax, var_name, color) in enumerate(zip(axs, (x_col, y_col, z_col), ('red', 'green', 'blue'))):
+    y_min, y_max = None, None
 
     # Divide into 4 ranges and plot
     for i, (start, end) in enumerate(ranges):
-        ax.scatter(n[start:end], variable[start:end], s=5, color=color, label=f"[{start}–{end}]")
+        if use_lod:
+            n_lod, *envelopes = hopfield_io.load_lod(lod_path, start, end - 1, max_points // num_ranges)
+            v_min, v_max, v_mean = envelopes[c]
+            ax.fill_between(n_lod, v_min, v_max, step='post', color=color, alpha=0.35, linewidth=0, label=f"[{start}–{end}]")
+            ax.plot(n_lod, v_mean, drawstyle='steps-post', color=color, linewidth=0.5)
+        else:
+            in_range = (n >= start) & (n < end)
+            v_min, v_max = (x, y, z)[c][in_range], (x, y, z)[c][in_range]
+            ax.scatter(n[in_range], v_min, s=5, color=color, label=f"[{start}–{end}]")
+        if len(v_min) > 0:
+            y_min = v_min.min() if y_min is None else min(y_min, v_min.min())
+            y_max = v_max.max() if y_max is None else max(y_max, v_max.max())
 
     ax.set_title(f"{var_name} evolution")
     ax.set_xlabel(n_col)
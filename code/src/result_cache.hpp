@@ -0,0 +1,191 @@
+#pragma once
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <fstream>
+#include <filesystem>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "trajectory_io.hpp"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+/*
+ * Content-addressed result cache (sweep --cache): a trajectory is stored once per distinct
+ *
+ *      key = nu, x0, y0, z0, W (exact bit patterns), n_iter, engine identity, output format, first step written
+ *
+ * under $PROJECT/data/cache/results/<hash[0..1]>/<hash>.<csv|bin> (hash: 64-bit FNV-1a of the key), and the
+ * time-evol_config-XXXXXXX files of all configs with that key are hard links to it (symbolic links if the cache is on
+ * another file system). Repeated configurations, e.g. the base configuration that appears in every gen_params range,
+ * are computed once.
+ *
+ * $PROJECT/data/cache/manifest.txt is an append-only text file with one tab-separated record per line:
+ *
+ *      R  <hash>  <key>                                a result is complete in the cache
+ *      C  <control param name>  <config ID>  <hash>    time-evol_config-<config ID> of that parameter links to it
+ *
+ * Records are appended under an exclusive flock, so several sweep processes can share the manifest; a record is only
+ * written once its file is complete (results are written to a temporary name and renamed). Reading the manifest once
+ * gives O(1) lookups both for "is this key computed" (sweep) and "is this config done" (find_missing_data.sh).
+ */
+// 64-bit FNV-1a hash of 'key' as 16 hex digits (names of result cache files and of tuning profiles)
+inline std::string fnv1aHex(const std::string& key)
+{
+    std::uint64_t h = 14695981039346656037ull;
+    for(unsigned char c : key)
+    {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    std::ostringstream oss;
+    oss << std::hex << std::setw(16) << std::setfill('0') << h;
+    return oss.str();
+}
+
+class ResultCache
+{
+    fs::path dir;
+    std::unordered_map<std::string, std::string> results; // hash -> key
+    std::unordered_set<std::string> links;                 // "<control param name>\t<config ID>\t<hash>"
+    std::mutex mutex;
+
+    bool append(const std::string& record)
+    {
+        const int fd = ::open((dir / "manifest.txt").c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if(fd < 0) return false;
+        flock(fd, LOCK_EX);
+        const bool ok = ::write(fd, record.data(), record.size()) == (ssize_t)record.size();
+        flock(fd, LOCK_UN);
+        ::close(fd);
+        return ok;
+    }
+
+public:
+    // Reads the manifest of the cache in 'dir' (created if needed), returns false if the directory cannot be created
+    bool open(const fs::path& dir_)
+    {
+        dir = dir_;
+        std::error_code ec;
+        fs::create_directories(dir / "results", ec);
+        if(ec)
+        {
+            std::cerr << "ERROR creating result cache " << dir << '\n';
+            return false;
+        }
+
+        std::ifstream manifest(dir / "manifest.txt");
+        std::string line;
+        while(std::getline(manifest, line))
+        {
+            if(line.rfind("R\t", 0) == 0)
+            {
+                const size_t tab = line.find('\t', 2);
+                if(tab != std::string::npos) results[line.substr(2, tab-2)] = line.substr(tab+1);
+            }
+            else if(line.rfind("C\t", 0) == 0) links.insert(line.substr(2));
+        }
+        return true;
+    }
+
+    // Cache file of 'hash' (whether or not it exists)
+    fs::path resultPath(const std::string& hash, const std::string& extension) const
+    {
+        return dir / "results" / hash.substr(0, 2) / (hash + extension);
+    }
+
+    // Cache file holding the result of 'key', "" if it has not been computed (or has been removed since)
+    fs::path find(const std::string& key, const std::string& extension)
+    {
+        const std::string h = fnv1aHex(key);
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = results.find(h);
+        if(found == results.end() || found->second != key) return {};
+        const fs::path path = resultPath(h, extension);
+        return fs::exists(path) ? path : fs::path();
+    }
+
+    // Path to write a new result of 'key' to before it is added with add(), unique across the nodes sharing the cache
+    // (host name and pid) and the threads of this process (counter)
+    fs::path temporaryPath(const std::string& key, const std::string& extension) const
+    {
+        const std::string h = fnv1aHex(key);
+        std::error_code ec;
+        fs::create_directories(dir / "results" / h.substr(0, 2), ec);
+
+        char hostname[256] = "host";
+        gethostname(hostname, sizeof(hostname) - 1);
+        static std::atomic<int> n_temporary {0};
+        return resultPath(h, extension + ".tmp." + std::string(hostname) + "." + std::to_string(getpid()) + "."
+                             + std::to_string(n_temporary++));
+    }
+
+    // Moves a complete result (and its .lod sidecar, if any) from 'temporary' into the cache under 'key'
+    fs::path add(const std::string& key, const std::string& extension, const fs::path& temporary)
+    {
+        const std::string h = fnv1aHex(key);
+        const fs::path path = resultPath(h, extension);
+        std::error_code ec;
+        if(fs::exists(temporary.string() + ".lod")) fs::rename(temporary.string() + ".lod", path.string() + ".lod", ec);
+        fs::rename(temporary, path, ec);
+        if(ec || !append("R\t" + h + "\t" + key + "\n"))
+        {
+            std::cerr << "ERROR adding " << path << " to the result cache\n";
+            return {};
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        results[h] = key;
+        return path;
+    }
+
+    // Makes 'target' (time-evol_config-XXXXXXX.<ext>) a link to the cached result 'path' and records it
+    bool link(const fs::path& path, const fs::path& target, const std::string& control_param_name, int config_id)
+    {
+        std::error_code ec;
+        if(!fs::exists(target) || !fs::equivalent(path, target, ec))
+        {
+            for(const std::string& suffix : {std::string(), std::string(".lod")})
+            {
+                const fs::path from = path.string() + suffix, to = target.string() + suffix;
+                fs::remove(to, ec);
+                if(!fs::exists(from)) continue;
+                fs::create_hard_link(from, to, ec);
+                if(ec) fs::create_symlink(fs::absolute(from), to, ec);
+                if(ec)
+                {
+                    std::cerr << "ERROR linking " << to << " to " << from << '\n';
+                    return false;
+                }
+            }
+        }
+
+        const std::string record = control_param_name + "\t" + std::to_string(config_id) + "\t" + path.stem().string();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(!links.insert(record).second) return true;
+        }
+        return append("C\t" + record + "\n");
+    }
+};
+
+// Canonical cache key of an n_iter-step run of 'info' with the engine identity of SolverOptions::engineKey()
+inline std::string resultCacheKey(const TrajectoryInfo& info, const std::string& engine_key, const std::string& format)
+{
+    std::ostringstream oss;
+    oss << std::hexfloat << "nu=" << info.nu << " x0=" << info.x0 << " y0=" << info.y0 << " z0=" << info.z0 << " w=";
+    for(int k=0; k<9; k++) oss << (k ? "," : "") << info.w[k];
+    oss << std::dec << " n_iter=" << info.n_iter << " engine=" << engine_key << " format=" << format << " n_first=" << info.n_first;
+    return oss.str();
+}
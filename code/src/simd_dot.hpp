@@ -0,0 +1,186 @@
+#pragma once
+
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HOPFIELD_X86 1
+#endif
+
+/*
+ * Triple dot product of the memory sum of HopfieldNetwork::solve():
+ *
+ *      sx = sum_{i=0}^{n-1} g[i] * fx[i],     sy, sz likewise with fy, fz
+ *
+ * where g is a slice of the REVERSED kernel (gammafrac_cache[n-1-i] = g[i]), so every stream is read in ascending
+ * order and no in-register permutes are needed. One kernel load feeds three multiply-adds.
+ *
+ * Variants:
+ *  - scalar: one accumulator per neuron, i ascending; bit for bit the double loop of the original solve() (older
+ *            results are reproduced with the original kernel as well, --kernel=lngamma)
+ *  - sse2:   2 x 2 doubles per neuron (baseline of every x86-64 CPU)
+ *  - avx2:   2 x 4 doubles per neuron with FMA
+ *  - avx512: 2 x 8 doubles per neuron with FMA
+ * The SIMD variants sum in a different order (several partial sums reduced at the end), so their results differ from
+ * the scalar one by rounding (~1e-16 relative per sum). The variant is picked at runtime from the CPU features
+ * (selectTripleDot), so one binary built with the default flags runs the widest kernel each node supports.
+ */
+typedef void (*TripleDotKernel)(const double* g, const double* fx, const double* fy, const double* fz, int n,
+                                double& sx, double& sy, double& sz);
+
+inline void tripleDotScalar(const double* g, const double* fx, const double* fy, const double* fz, int n,
+                            double& sx, double& sy, double& sz)
+{
+    double xs {0};
+    double ys {0};
+    double zs {0};
+    for(int i=0; i<n; i++)
+    {
+        xs += g[i] * fx[i];
+        ys += g[i] * fy[i];
+        zs += g[i] * fz[i];
+    }
+    sx = xs;
+    sy = ys;
+    sz = zs;
+}
+
+#ifdef HOPFIELD_X86
+inline double horizontalSum(__m128d v)
+{
+    return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+inline void tripleDotSSE2(const double* g, const double* fx, const double* fy, const double* fz, int n,
+                          double& sx, double& sy, double& sz)
+{
+    __m128d x0 = _mm_setzero_pd(), x1 = _mm_setzero_pd();
+    __m128d y0 = _mm_setzero_pd(), y1 = _mm_setzero_pd();
+    __m128d z0 = _mm_setzero_pd(), z1 = _mm_setzero_pd();
+
+    int i = 0;
+    for(; i+4<=n; i+=4)
+    {
+        const __m128d g0 = _mm_loadu_pd(g+i), g1 = _mm_loadu_pd(g+i+2);
+        x0 = _mm_add_pd(x0, _mm_mul_pd(g0, _mm_loadu_pd(fx+i))); x1 = _mm_add_pd(x1, _mm_mul_pd(g1, _mm_loadu_pd(fx+i+2)));
+        y0 = _mm_add_pd(y0, _mm_mul_pd(g0, _mm_loadu_pd(fy+i))); y1 = _mm_add_pd(y1, _mm_mul_pd(g1, _mm_loadu_pd(fy+i+2)));
+        z0 = _mm_add_pd(z0, _mm_mul_pd(g0, _mm_loadu_pd(fz+i))); z1 = _mm_add_pd(z1, _mm_mul_pd(g1, _mm_loadu_pd(fz+i+2)));
+    }
+
+    double xs = horizontalSum(_mm_add_pd(x0, x1));
+    double ys = horizontalSum(_mm_add_pd(y0, y1));
+    double zs = horizontalSum(_mm_add_pd(z0, z1));
+    for(; i<n; i++)
+    {
+        xs += g[i] * fx[i];
+        ys += g[i] * fy[i];
+        zs += g[i] * fz[i];
+    }
+    sx = xs;
+    sy = ys;
+    sz = zs;
+}
+
+__attribute__((target("avx2,fma")))
+inline double horizontalSum(__m256d v)
+{
+    return horizontalSum(_mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1)));
+}
+
+__attribute__((target("avx2,fma")))
+inline void tripleDotAVX2(const double* g, const double* fx, const double* fy, const double* fz, int n,
+                          double& sx, double& sy, double& sz)
+{
+    __m256d x0 = _mm256_setzero_pd(), x1 = _mm256_setzero_pd();
+    __m256d y0 = _mm256_setzero_pd(), y1 = _mm256_setzero_pd();
+    __m256d z0 = _mm256_setzero_pd(), z1 = _mm256_setzero_pd();
+
+    int i = 0;
+    for(; i+8<=n; i+=8)
+    {
+        const __m256d g0 = _mm256_loadu_pd(g+i), g1 = _mm256_loadu_pd(g+i+4);
+        x0 = _mm256_fmadd_pd(g0, _mm256_loadu_pd(fx+i), x0); x1 = _mm256_fmadd_pd(g1, _mm256_loadu_pd(fx+i+4), x1);
+        y0 = _mm256_fmadd_pd(g0, _mm256_loadu_pd(fy+i), y0); y1 = _mm256_fmadd_pd(g1, _mm256_loadu_pd(fy+i+4), y1);
+        z0 = _mm256_fmadd_pd(g0, _mm256_loadu_pd(fz+i), z0); z1 = _mm256_fmadd_pd(g1, _mm256_loadu_pd(fz+i+4), z1);
+    }
+
+    double xs = horizontalSum(_mm256_add_pd(x0, x1));
+    double ys = horizontalSum(_mm256_add_pd(y0, y1));
+    double zs = horizontalSum(_mm256_add_pd(z0, z1));
+    for(; i<n; i++)
+    {
+        xs += g[i] * fx[i];
+        ys += g[i] * fy[i];
+        zs += g[i] * fz[i];
+    }
+    sx = xs;
+    sy = ys;
+    sz = zs;
+}
+
+__attribute__((target("avx512f")))
+inline double horizontalSum(__m512d v)
+{
+    alignas(64) double lanes[8];
+    _mm512_store_pd(lanes, v);
+    return ((lanes[0] + lanes[4]) + (lanes[2] + lanes[6])) + ((lanes[1] + lanes[5]) + (lanes[3] + lanes[7]));
+}
+
+__attribute__((target("avx512f")))
+inline void tripleDotAVX512(const double* g, const double* fx, const double* fy, const double* fz, int n,
+                            double& sx, double& sy, double& sz)
+{
+    __m512d x0 = _mm512_setzero_pd(), x1 = _mm512_setzero_pd();
+    __m512d y0 = _mm512_setzero_pd(), y1 = _mm512_setzero_pd();
+    __m512d z0 = _mm512_setzero_pd(), z1 = _mm512_setzero_pd();
+
+    int i = 0;
+    for(; i+16<=n; i+=16)
+    {
+        const __m512d g0 = _mm512_loadu_pd(g+i), g1 = _mm512_loadu_pd(g+i+8);
+        x0 = _mm512_fmadd_pd(g0, _mm512_loadu_pd(fx+i), x0); x1 = _mm512_fmadd_pd(g1, _mm512_loadu_pd(fx+i+8), x1);
+        y0 = _mm512_fmadd_pd(g0, _mm512_loadu_pd(fy+i), y0); y1 = _mm512_fmadd_pd(g1, _mm512_loadu_pd(fy+i+8), y1);
+        z0 = _mm512_fmadd_pd(g0, _mm512_loadu_pd(fz+i), z0); z1 = _mm512_fmadd_pd(g1, _mm512_loadu_pd(fz+i+8), z1);
+    }
+
+    double xs = horizontalSum(_mm512_add_pd(x0, x1));
+    double ys = horizontalSum(_mm512_add_pd(y0, y1));
+    double zs = horizontalSum(_mm512_add_pd(z0, z1));
+    for(; i<n; i++)
+    {
+        xs += g[i] * fx[i];
+        ys += g[i] * fy[i];
+        zs += g[i] * fz[i];
+    }
+    sx = xs;
+    sy = ys;
+    sz = zs;
+}
+#endif
+
+struct TripleDot
+{
+    std::string name;
+    TripleDotKernel kernel; // nullptr if the requested variant is unknown or not supported by this CPU
+};
+
+// Returns the variant named 'isa' ('auto', 'scalar', 'sse2', 'avx2' or 'avx512'), 'auto' being the widest one the CPU
+// supports
+inline TripleDot selectTripleDot(const std::string& isa)
+{
+    if(isa == "scalar") return {"scalar", tripleDotScalar};
+
+#ifdef HOPFIELD_X86
+    __builtin_cpu_init();
+    const bool has_avx512 = __builtin_cpu_supports("avx512f");
+    const bool has_avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+
+    if(isa == "avx512" || (isa == "auto" && has_avx512)) return {"avx512", has_avx512 ? tripleDotAVX512 : nullptr};
+    if(isa == "avx2" || (isa == "auto" && has_avx2)) return {"avx2", has_avx2 ? tripleDotAVX2 : nullptr};
+    if(isa == "sse2" || isa == "auto") return {"sse2", tripleDotSSE2};
+#else
+    if(isa == "auto") return {"scalar", tripleDotScalar};
+#endif
+
+    return {isa, nullptr};
+}
@@ -0,0 +1,559 @@
+/*
+    In-process sweep runner: solves a whole range of parameter configurations on all cores of one node.
+
+    Usage: sweep <config_id_min> <config_id_max> [--threads=N] [--shard=i/N] [--bifur|--refine=S|--archive|--grid] [--engine=...] [engine options]
+
+    The config IDs are resolved like in scripts/bash/perf_time-evol.sh: parameters/configs/config_id_list.txt tells which
+    config-XXXXXXX-YYYYYYY.sh file (and therefore which CONTROL_PARAM_NAME) an ID belongs to, the inputs are
+    $PROJECT/parameters/wparams/<CONTROL_PARAM_NAME>/wparams_config-XXXXXXX.txt (or, for a range generated with
+    gen_params --spec, the sweep spec config-XXXXXXX-YYYYYYY.spec next to the CONFIG file, see sweep_spec.hpp, read once
+    per range) and the results are written to
+    $PROJECT/data/time-evol/<CONTROL_PARAM_NAME>/time-evol_config-XXXXXXX.csv (same files as time-evol writes, .bin with
+    --format=bin/bin32).
+
+    --threads=N   number of worker threads (default: all hardware threads)
+    --shard=i/N   process only the i-th (0-based) of N contiguous slices of the ID range, so that one SLURM array task
+                  can take a whole slice (see scripts/slurm/sweep.slurm)
+    --bifur       bifurcation mode: no time-evol files, the tails of all configs of one gen_params range go to a single
+                  $PROJECT/data/bifur/<CONTROL_PARAM_NAME>/bifur_config-XXXXXXX-YYYYYYY.csv with the columns
+                  config_id,<CONTROL_PARAM_NAME>,n,x,y,z (XXXXXXX-YYYYYYY is the part of the range in this shard).
+                  The rows of a config are appended as soon as it is done, so the configs are in completion order
+                  (readers sort by config_id) and a job stopped at its time limit keeps every config it finished.
+                  The tail length is --tail/--transient, or N_ITER_LAST of the range's CONFIG file if neither is given
+    --refine=S    adaptive bifurcation mode (see adaptive_refine.hpp): like --bifur, but every gen_params range of the shard
+                  is solved on every S-th config first, and the interval between two neighbouring solved configs is
+                  bisected (in waves, each wave on all threads) until their tails have the same class (period k, 1 for a
+                  fixed point, up to --period-max=K, default 32, with the steps equal to --period-tol=T, default 1e-6;
+                  aperiodic otherwise) and their min/max of x, y and z agree to --refine-tol=D (default 0.05), or they
+                  are neighbouring configs. The bifurcation file only has the solved configs; their classes go to
+                  refine_config-XXXXXXX-YYYYYYY.csv next to it (config_id,<CONTROL_PARAM_NAME>,period,x_min,x_max,
+                  y_min,y_max,z_min,z_max, period 0: aperiodic, -1: failed) and the class changes are printed
+    --archive     all configs of one gen_params range go to a single append-only container
+                  $PROJECT/data/time-evol/<CONTROL_PARAM_NAME>/archive_config-XXXXXXX-YYYYYYY.hfa (see sweep_archive.hpp)
+                  instead of one file per config; the parameters are taken from the archive if gen_params stored them
+                  there (gen_params ... --archive), otherwise from the wparams files. The trajectories are stored as
+                  float64 columns (float32 with --format=bin32)
+    --continue --n-iter=N
+                  extends the existing per-config time-evol files in place to N steps instead of recomputing them (see
+                  --continue in time-evol.cpp); configs without a file are solved from the start
+    --cache       content-addressed result cache (see result_cache.hpp): every distinct (parameters, n_iter, engine,
+                  format) is solved once into $PROJECT/data/cache/results and the time-evol_config-XXXXXXX files are
+                  links to it, so repeated configurations and re-submitted sweeps only compute what is new. Recorded in
+                  $PROJECT/data/cache/manifest.txt, which find_missing_data.sh reads instead of testing every file.
+                  Per-config files only (not with --bifur, --archive, --continue or --resume)
+    --grid        parameter-plane mode for ranges generated with gen_params --spec/--grid: no time-evol files, every
+                  point is summarised (min/max/mean of x, y, z over its tail, plus its last --grid-samples=S tail steps,
+                  default 0) into one fixed-layout file per range, $PROJECT/data/grid/<NAME>[-<NAME2>]/
+                  grid_config-XXXXXXX-YYYYYYY.bin (see grid_summary.hpp and hopfield_io.load_grid), shared by all
+                  shards. The tail length is chosen as with --bifur. The points are scheduled grouped by nu and every
+                  group loads its memory kernel once for all of its points (SharedKernels in kernel_cache.hpp): with
+                  the tasks dealt round-robin, all threads work through the same nu row at a time, so only the
+                  kernels of one or two rows are held at once
+
+    --engine=auto picks the engine per config from the tuning profile of the node (time-evol --calibrate, see
+    engine_tuning.hpp) among the single-threaded settings, since the configs already run one per thread
+    (--engine-threads=T allows up to T).
+
+    The configurations are distributed with a work-stealing pool (thread_pool.hpp), so threads that finish early keep
+    taking work from the others until the whole shard is done.
+
+    Build: g++ -std=c++17 -O2 sweep.cpp -o sweep -lgsl -lgslcblas -pthread
+*/
+
+#include "hopfield.hpp"
+#include "thread_pool.hpp"
+#include "sweep_archive.hpp"
+#include "sweep_config.hpp"
+#include "result_cache.hpp"
+#include "grid_summary.hpp"
+#include "adaptive_refine.hpp"
+
+#include <chrono>
+#include <deque>
+#include <cstdlib>
+#include <mutex>
+#include <numeric>
+
+// Fetching the environment variable $PROJECT which is a path to the whole project (same as gen_params)
+const char* PROJECT_ENV = std::getenv("PROJECT");
+
+struct TailSample
+{
+    int n;
+    double x, y, z;
+};
+
+// Keeps the steps n >= n_first of one run in memory (sweep --bifur)
+class TailCollector : public TrajectoryWriter
+{
+    std::vector<TailSample>& samples;
+    int n_first;
+
+public:
+    TailCollector(std::vector<TailSample>& samples_, int n_first_) : samples(samples_), n_first(n_first_) {}
+
+    void write(int n, double x, double y, double z) override
+    {
+        if(n >= n_first) samples.push_back({n, x, y, z});
+    }
+
+    void close() override {}
+};
+
+struct SweepTask
+{
+    int config_id;
+    fs::path params_path;
+    fs::path result_path;
+    int range;                      // index into 'ranges' (sweep --bifur/--archive)
+    std::string control_param_name;
+    const SweepSpec* spec;          // parameters come from the sweep spec of the range (nullptr: params_path)
+};
+
+// Part of one gen_params range handled by this shard, written to one aggregated file in bifurcation mode
+struct BifurRange
+{
+    int id_low, id_high;
+    std::string control_param_name;
+    int tail;                       // N_ITER_LAST of the range's CONFIG file
+    fs::path result_path;
+    std::unique_ptr<SweepArchive> archive; // sweep --archive
+    std::unique_ptr<GridFile> grid;        // sweep --grid
+};
+int main(int argc, char* argv[])
+{
+    if(argc < 3)
+    {
+        std::cerr << "usage: sweep <config_id_min> <config_id_max> [--threads=N] [--shard=i/N] [--bifur] [--engine=...]\n";
+        return 1;
+    }
+    if(PROJECT_ENV == nullptr)
+    {
+        std::cerr << "ERROR environment variable PROJECT is not set\n";
+        return 1;
+    }
+    const fs::path PROJECT = PROJECT_ENV;
+    const fs::path PARAMS_DIR = PROJECT / "parameters";
+    const fs::path DATA_DIR = PROJECT / "data";
+
+    const int config_id_min = std::stoi(argv[1]);
+    const int config_id_max = std::stoi(argv[2]);
+
+    SolverOptions options;
+    int n_threads = (int)std::thread::hardware_concurrency();
+    int shard = 0, n_shards = 1;
+    bool bifur = false, archive = false, cache = false, grid = false;
+    int grid_samples = 0;
+    int refine_stride = 0, period_max = 32;
+    double period_tol = 1e-6, refine_tol = 0.05;
+    for(int i=3; i<argc; i++)
+    {
+        std::string arg = argv[i];
+        if(options.parse(arg)) continue;
+        else if(arg == "--bifur") bifur = true;
+        else if(arg == "--archive") archive = true;
+        else if(arg == "--cache") cache = true;
+        else if(arg == "--grid") grid = true;
+        else if(arg.rfind("--grid-samples=", 0) == 0) grid_samples = std::stoi(arg.substr(15));
+        else if(arg.rfind("--refine=", 0) == 0) refine_stride = std::stoi(arg.substr(9));
+        else if(arg.rfind("--period-max=", 0) == 0) period_max = std::stoi(arg.substr(13));
+        else if(arg.rfind("--period-tol=", 0) == 0) period_tol = std::stod(arg.substr(13));
+        else if(arg.rfind("--refine-tol=", 0) == 0) refine_tol = std::stod(arg.substr(13));
+        else if(arg.rfind("--threads=", 0) == 0) n_threads = std::stoi(arg.substr(10));
+        else if(arg.rfind("--shard=", 0) == 0)
+        {
+            std::string value = arg.substr(8);
+            shard = std::stoi(value.substr(0, value.find('/')));
+            n_shards = std::stoi(value.substr(value.find('/')+1));
+        }
+        else
+        {
+            std::cerr << "ERROR unknown argument " << arg << '\n';
+            return 1;
+        }
+    }
+    const bool refine = refine_stride != 0;
+    if((int)(bifur || refine) + (int)archive + (int)grid > 1)
+    {
+        std::cerr << "ERROR --bifur/--refine, --archive and --grid cannot be combined\n";
+        return 1;
+    }
+    if(refine && (refine_stride < 1 || period_max < 1 || options.continue_run || options.resume))
+    {
+        std::cerr << "ERROR --refine needs S >= 1 and --period-max >= 1 and cannot be combined with --continue or --resume\n";
+        return 1;
+    }
+    bifur = bifur || refine;
+    if((bifur || archive || grid) && (options.checkpoint > 0 || options.resume))
+    {
+        std::cerr << "ERROR --checkpoint and --resume need plain output files, they cannot be combined with --bifur/--refine, "
+                     "--archive or --grid\n";
+        return 1;
+    }
+    if(grid && (cache || options.continue_run || options.resume || grid_samples < 0))
+    {
+        std::cerr << "ERROR --grid cannot be combined with --cache, --continue or --resume\n";
+        return 1;
+    }
+    if(cache && (bifur || archive || grid || options.continue_run || options.resume))
+    {
+        std::cerr << "ERROR --cache cannot be combined with --bifur, --archive, --continue or --resume\n";
+        return 1;
+    }
+    if((archive || cache) && !validTrajectoryFormat(options.format))
+    {
+        std::cerr << "ERROR unknown output format " << options.format << '\n';
+        return 1;
+    }
+    if(options.engine != "auto" && HopfieldNetwork::findEngine(options.engine) == nullptr) return 1;
+    if(kernelAnchorInterval(options.kernel) == 0)
+    {
+        std::cerr << "ERROR unknown kernel method " << options.kernel << " (use 'recurrence' or 'lngamma')\n";
+        return 1;
+    }
+    // --engine=auto: the configs already run one per thread, so the tuned engine gets one thread unless told otherwise
+    if(options.engine == "auto" && options.engine_threads == 0) options.engine_threads = 1;
+    if(n_shards < 1 || shard < 0 || shard >= n_shards)
+    {
+        std::cerr << "ERROR invalid --shard=" << shard << "/" << n_shards << '\n';
+        return 1;
+    }
+
+    // Contiguous slice of the ID range handled by this shard
+    const long n_total = config_id_max - config_id_min + 1;
+    const int shard_min = config_id_min + (int)(n_total * shard / n_shards);
+    const int shard_max = config_id_min + (int)(n_total * (shard+1) / n_shards) - 1;
+
+    // Resolving input/output paths (config ranges are looked up once per gen_params range, not once per ID)
+    std::vector<SweepTask> tasks;
+    std::vector<BifurRange> ranges;
+    std::deque<SweepSpec> specs;
+    ConfigRange range {-1, -2, "", "", ""};
+    for(int config_id=shard_min; config_id<=shard_max; config_id++)
+    {
+        if(config_id < range.id_low || config_id > range.id_high)
+        {
+            if(!resolveConfigRange(PARAMS_DIR, config_id, range)) return 1;
+            if(!range.spec_file.empty())
+            {
+                specs.emplace_back();
+                if(!specs.back().read(range.spec_file)) return 1;
+            }
+
+            const int id_high = std::min(range.id_high, shard_max);
+            if(grid)
+            {
+                if(range.spec_file.empty())
+                {
+                    std::cerr << "ERROR --grid needs a range generated with gen_params --spec or --grid, configs "
+                              << range.id_low << "-" << range.id_high << " have wparams files\n";
+                    return 1;
+                }
+                const SweepSpec& spec = specs.back();
+                const std::string n_iter_last = readConfigValue(range.config_file, "N_ITER_LAST");
+                const std::string dir_name = spec.control_param_name + (spec.isGrid() ? "-" + spec.control_param_name2 : "");
+                fs::create_directories(DATA_DIR / "grid" / dir_name);
+                ranges.push_back({config_id, id_high, range.control_param_name, n_iter_last.empty() ? 0 : std::stoi(n_iter_last),
+                                  DATA_DIR / "grid" / dir_name / gridFileName(range.id_low, range.id_high), nullptr,
+                                  std::make_unique<GridFile>()});
+
+                // The grid file always covers the whole gen_params range, so that all shards share it
+                const int n_iter = options.n_iter > 0 ? options.n_iter : (int)spec.base.n_iter;
+                SolverOptions grid_options = options;
+                if(options.tail == 0 && options.transient == 0) grid_options.tail = ranges.back().tail;
+                GridHeader header {};
+                header.id_low = range.id_low;
+                header.id_high = range.id_high;
+                header.rows = spec.rows();
+                header.cols = spec.n_values2;
+                header.tail = n_iter - grid_options.firstStep(n_iter);
+                header.n_samples = grid_samples;
+                header.n_iter = n_iter;
+                std::strncpy(header.param_name, spec.control_param_name.c_str(), sizeof(header.param_name) - 1);
+                std::strncpy(header.param_name2, spec.control_param_name2.c_str(), sizeof(header.param_name2) - 1);
+                if(!ranges.back().grid->open(ranges.back().result_path, header)) return 1;
+            }
+            else if(bifur)
+            {
+                const std::string n_iter_last = readConfigValue(range.config_file, "N_ITER_LAST");
+                fs::create_directories(DATA_DIR / "bifur" / range.control_param_name);
+                ranges.push_back({
+                    config_id, id_high, range.control_param_name, n_iter_last.empty() ? 0 : std::stoi(n_iter_last),
+                    DATA_DIR / "bifur" / range.control_param_name
+                        / (configFileName("bifur_config-", config_id, "") + configFileName("-", id_high, ".csv")),
+                    nullptr, nullptr
+                });
+            }
+            else if(archive)
+            {
+                // The archive always covers the whole gen_params range, so that all shards share it
+                fs::create_directories(DATA_DIR / "time-evol" / range.control_param_name);
+                ranges.push_back({config_id, id_high, range.control_param_name, 0,
+                                  DATA_DIR / "time-evol" / range.control_param_name / sweepArchiveName(range.id_low, range.id_high),
+                                  std::make_unique<SweepArchive>(), nullptr});
+                if(!ranges.back().archive->open(ranges.back().result_path, range.id_low, range.id_high)) return 1;
+            }
+            else fs::create_directories(DATA_DIR / "time-evol" / range.control_param_name);
+        }
+
+        tasks.push_back({
+            config_id,
+            configParamsPath(PARAMS_DIR, range, config_id),
+            DATA_DIR / "time-evol" / range.control_param_name
+                / configFileName("time-evol_config-", config_id, trajectoryExtension(options.format)),
+            (int)ranges.size() - 1,
+            range.control_param_name,
+            range.spec_file.empty() ? nullptr : &specs.back()
+        });
+    }
+
+    ResultCache result_cache;
+    if(cache && !result_cache.open(DATA_DIR / "cache")) return 1;
+    const std::string cache_engine_key = cache ? options.engineKey() : "";
+    const std::string cache_format = options.format + (options.lod ? "+lod" : "");
+
+    std::cout << "sweep: configs " << shard_min << "-" << shard_max << " (shard " << shard << "/" << n_shards << ")"
+              << ", engine " << options.engine << ", " << n_threads << " threads\n";
+
+    // --bifur: one file per range, the rows of every config are appended under bifur_mutex when it is done
+    std::vector<std::ofstream> bifur_files(bifur ? ranges.size() : 0);
+    std::mutex bifur_mutex;
+    for(int r=0; r<(int)bifur_files.size(); r++)
+    {
+        bifur_files[r].open(ranges[r].result_path);
+        if(!bifur_files[r].is_open())
+        {
+            std::cerr << "ERROR opening " << ranges[r].result_path << '\n';
+            return 1;
+        }
+        bifur_files[r] << "config_id," << ranges[r].control_param_name << ",n,x,y,z\n" << std::flush;
+    }
+    std::vector<TailClass> tail_classes(refine ? tasks.size() : 0); // --refine: class of every solved config
+
+    std::mutex log_mutex;
+    int n_done = 0, n_failed = 0, n_cached = 0;
+    const auto t_start = std::chrono::steady_clock::now();
+
+    // --grid: tasks in (nu, config ID) order, every nu group shares one kernel
+    std::vector<int> order(tasks.size());
+    std::iota(order.begin(), order.end(), 0);
+    SharedKernels shared_kernels(kernelAnchorInterval(options.kernel));
+    if(grid)
+    {
+        std::vector<double> task_nu(tasks.size());
+        for(int task=0; task<(int)tasks.size(); task++)
+        {
+            const TrajectoryInfo info = tasks[task].spec->config(tasks[task].config_id);
+            task_nu[task] = info.nu;
+            shared_kernels.expect(info.nu, options.n_iter > 0 ? options.n_iter : (int)info.n_iter);
+        }
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) {return task_nu[a] < task_nu[b];});
+        std::cout << "grid: " << shared_kernels.size() << " distinct kernels for " << tasks.size() << " points\n";
+    }
+
+    // --refine: the first wave is every refine_stride-th config of each range (tasks are in ID order from shard_min)
+    std::vector<Refinement> refinements;
+    if(refine)
+    {
+        order.clear();
+        for(const BifurRange& r : ranges)
+        {
+            refinements.emplace_back(r.id_low, r.id_high);
+            for(int config_id : refinements.back().coarse(refine_stride)) order.push_back(config_id - shard_min);
+        }
+    }
+
+    const auto solve = [&](int slot, int thread) {
+        const int task = order[slot];
+        const SweepTask& t = tasks[task];
+        const auto t0 = std::chrono::steady_clock::now();
+
+        SweepArchive* config_archive = archive ? ranges[t.range].archive.get() : nullptr;
+        SweepArchiveEntry entry {};
+        if(config_archive != nullptr) entry = config_archive->entry(t.config_id);
+
+        bool ok = (entry.status != archive_empty) || t.spec != nullptr || fs::exists(t.params_path);
+        bool cached = false;
+        if(ok)
+        {
+            Params wparams = (entry.status != archive_empty) ? Params(archivedInfo(entry))
+                             : (t.spec != nullptr) ? Params(t.spec->config(t.config_id)) : Params(t.params_path);
+            HopfieldNetwork H(&wparams);
+            H.verbose = false;
+            if(bifur)
+            {
+                SolverOptions task_options = options;
+                if(options.tail == 0 && options.transient == 0) task_options.tail = ranges[t.range].tail;
+                const double param = controlParamValue(trajectoryInfo(wparams, wparams.n_iter), ranges[t.range].control_param_name);
+                std::vector<TailSample> samples;
+                H.output_writer = [&] { return std::unique_ptr<TrajectoryWriter>(new TailCollector(samples, H.first_step)); };
+                ok = H.run(task_options, t.result_path);
+                if(!ok) samples.clear();
+
+                if(refine)
+                {
+                    const int n = (int)samples.size();
+                    std::vector<double> v(3 * n);
+                    for(int k=0; k<n; k++)
+                    {
+                        v[k] = samples[k].x;
+                        v[n+k] = samples[k].y;
+                        v[2*n+k] = samples[k].z;
+                    }
+                    tail_classes[task] = classifyTail(param, v.data(), v.data() + n, v.data() + 2*n, n, period_max, period_tol);
+                }
+
+                std::ostringstream rows;
+                rows << std::fixed << std::setprecision(9);
+                for(const TailSample& s : samples)
+                    rows << t.config_id << ',' << param << ',' << s.n << ',' << s.x << ',' << s.y << ',' << s.z << '\n';
+                std::lock_guard<std::mutex> lock(bifur_mutex);
+                std::ofstream& file = bifur_files[t.range];
+                file << rows.str() << std::flush;
+                if(!file.good())
+                {
+                    std::cerr << "ERROR writing " << ranges[t.range].result_path << '\n';
+                    ok = false;
+                }
+            }
+            else if(grid)
+            {
+                SolverOptions task_options = options;
+                if(options.tail == 0 && options.transient == 0) task_options.tail = ranges[t.range].tail;
+                const int n_iter = options.n_iter > 0 ? options.n_iter : wparams.n_iter;
+                std::vector<TailSample> samples;
+                H.shared_kernel = shared_kernels.acquire(wparams.nu, n_iter);
+                H.output_writer = [&] { return std::unique_ptr<TrajectoryWriter>(new TailCollector(samples, H.first_step)); };
+                ok = H.run(task_options, t.result_path);
+                shared_kernels.release(wparams.nu, n_iter);
+
+                const int n = (int)samples.size();
+                std::vector<double> v(3 * n);
+                for(int k=0; k<n; k++)
+                {
+                    v[k] = samples[k].x;
+                    v[n+k] = samples[k].y;
+                    v[2*n+k] = samples[k].z;
+                }
+                GridPoint point = gridPoint(t.config_id, t.spec->controlValue(t.config_id),
+                                            t.spec->isGrid() ? t.spec->controlValue2(t.config_id) : std::nan(""),
+                                            v.data(), v.data() + n, v.data() + 2*n, n);
+                if(!ok) point.status = grid_failed;
+
+                // Last grid_samples tail steps, x, y, z of each step
+                std::vector<double> last;
+                for(int k=std::max(0, n - grid_samples); k<n; k++)
+                    last.insert(last.end(), {samples[k].x, samples[k].y, samples[k].z});
+                ok = ranges[t.range].grid->write(point, last) && ok;
+            }
+            else if(config_archive != nullptr)
+            {
+                const std::uint32_t value_size = (options.format == "bin32") ? 4 : 8;
+                H.output_writer = [&] {
+                    return std::unique_ptr<TrajectoryWriter>(new ArchiveTrajectoryWriter(
+                        *config_archive, t.config_id, trajectoryInfo(wparams, wparams.n_iter, H.first_step), value_size));
+                };
+                ok = H.run(options, t.result_path);
+            }
+            else if(cache)
+            {
+                const int n_iter = options.n_iter > 0 ? options.n_iter : wparams.n_iter;
+                const std::string key = resultCacheKey(trajectoryInfo(wparams, n_iter, options.firstStep(n_iter)),
+                                                       (options.engine == "auto") ? options.tuned(n_iter).engineKey()
+                                                                                  : cache_engine_key, cache_format);
+                const std::string extension = trajectoryExtension(options.format);
+                fs::path path = result_cache.find(key, extension);
+                cached = !path.empty();
+                if(!cached)
+                {
+                    const fs::path temporary = result_cache.temporaryPath(key, extension);
+                    ok = H.run(options, temporary);
+                    if(ok) path = result_cache.add(key, extension, temporary);
+                    else
+                    {
+                        std::error_code ec;  // a throw here would escape the pool worker
+                        fs::remove(temporary, ec);
+                        fs::remove(temporary.string() + ".lod", ec);
+                    }
+                }
+                ok = ok && !path.empty() && result_cache.link(path, t.result_path, t.control_param_name, t.config_id);
+            }
+            else ok = H.run(options, t.result_path);
+        }
+        if(!ok && config_archive != nullptr)
+        {
+            entry.config_id = t.config_id;
+            entry.status = archive_failed;
+            config_archive->setEntry(entry);
+        }
+
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        std::lock_guard<std::mutex> lock(log_mutex);
+        n_done++;
+        if(cached) n_cached++;
+        if(!ok)
+        {
+            n_failed++;
+            std::cerr << "ERROR config " << t.config_id << " failed (" << t.params_path << ")\n";
+        }
+        std::cout << "[" << n_done << "/" << tasks.size() << "] config " << t.config_id << (cached ? " cached in " : " done in ")
+                  << std::fixed << std::setprecision(2) << seconds << " s (thread " << thread << ")\n" << std::defaultfloat;
+    };
+
+    WorkStealingPool pool;
+    pool.run((int)order.size(), n_threads, solve);
+
+    // --refine: adding the classes of the last wave and solving the midpoints of the intervals that still differ
+    for(int wave=1; refine; wave++)
+    {
+        for(int task : order) refinements[tasks[task].range].add(tasks[task].config_id, tail_classes[task]);
+
+        order.clear();
+        for(const Refinement& refinement : refinements)
+            for(int config_id : refinement.next(refine_tol)) order.push_back(config_id - shard_min);
+        if(order.empty()) break;
+
+        std::cout << "refine: wave " << wave << ", " << order.size() << " configs\n";
+        pool.run((int)order.size(), n_threads, solve);
+    }
+
+    for(int r=0; r<(int)ranges.size() && grid; r++) std::cout << "grid summary written to " << ranges[r].result_path << '\n';
+
+    for(int r=0; r<(int)ranges.size() && bifur; r++) std::cout << "bifurcation data written to " << ranges[r].result_path << '\n';
+
+    // --refine: classes of the solved configs and the bifurcation points found
+    for(int r=0; r<(int)ranges.size() && refine; r++)
+    {
+        const fs::path classes_path = ranges[r].result_path.parent_path()
+            / (configFileName("refine_config-", ranges[r].id_low, "") + configFileName("-", ranges[r].id_high, ".csv"));
+        std::ofstream file(classes_path);
+        if(!file.is_open())
+        {
+            std::cerr << "ERROR opening " << classes_path << '\n';
+            n_failed++;
+            continue;
+        }
+
+        const std::string& name = ranges[r].control_param_name;
+        file << "config_id," << name << ",period,x_min,x_max,y_min,y_max,z_min,z_max\n" << std::setprecision(9);
+        for(const auto& [config_id, c] : refinements[r].configs())
+        {
+            file << config_id << ',' << c.param << ',' << c.period;
+            for(int i=0; i<3; i++) file << ',' << c.min[i] << ',' << c.max[i];
+            file << '\n';
+        }
+
+        std::cout << "refine: configs " << ranges[r].id_low << "-" << ranges[r].id_high << " of " << name << ", "
+                  << refinements[r].configs().size() << " of " << ranges[r].id_high - ranges[r].id_low + 1
+                  << " solved, classes written to " << classes_path << '\n';
+        refinements[r].printTransitions(std::cout, name);
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+    std::cout << "sweep finished: " << n_done - n_failed << " ok";
+    if(cache) std::cout << " (" << n_cached << " from the result cache)";
+    std::cout << ", " << n_failed << " failed, "
+              << std::fixed << std::setprecision(1) << seconds << " s\n";
+
+    return n_failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,293 @@
+#pragma once
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+
+#include "trajectory_io.hpp"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Sweep archive: one append-only container per gen_params range instead of one wparams_config-XXXXXXX.txt and one
+ * time-evol_config-XXXXXXX.csv per config ID (all little-endian):
+ *
+ *      offset   0  SweepArchiveHeader (64 bytes)
+ *              64  index: one SweepArchiveEntry (160 bytes) per config ID id_low..id_high, in ID order
+ *     data_offset  data blocks, appended in the order in which the configs finish
+ *
+ * The index is allocated in full when the archive is created, so the entry of a config is at a fixed position and a
+ * reader needs one seek for the entry and one for the data block. A data block holds the x, y and z columns of one
+ * trajectory (n_rows values each, float64 or float32), exactly like the columns of a binary trajectory file, and can
+ * be mapped with np.memmap (see hopfield_io.py).
+ *
+ * gen_params may fill in the parameters (status 'params') instead of writing wparams files; sweep --archive appends
+ * the results (status 'done'). Several threads and processes on one node may append to the same archive at the same
+ * time: space for a block is reserved at the end of the file under an exclusive flock, the block is written without
+ * the lock, and the index entry is only updated (again under the lock) once the block is complete. A crash therefore
+ * leaves at worst an unreferenced block behind, never an entry pointing at incomplete data. Shards running on
+ * different nodes rely on flock being coherent across nodes (Lustre mounted with -o flock).
+ */
+enum SweepArchiveStatus : std::int32_t
+{
+    archive_empty = 0,   // nothing known about the config
+    archive_params = 1,  // parameters stored, no result yet
+    archive_done = 2,    // parameters and trajectory stored
+    archive_failed = 3   // the run failed
+};
+
+struct SweepArchiveHeader
+{
+    char magic[8];              // "HFSWEEP1"
+    std::uint32_t header_size;  // 64
+    std::uint32_t entry_size;   // sizeof(SweepArchiveEntry)
+    std::int64_t id_low, id_high;
+    std::int64_t data_offset;   // end of the index, first data block
+    char reserved[24];
+};
+
+struct SweepArchiveEntry
+{
+    std::int64_t config_id;
+    std::int32_t status;        // SweepArchiveStatus
+    std::uint32_t value_size;   // bytes per value of the data block (8 or 4)
+    std::int64_t offset;        // data block: x[0..n_rows-1], y[...], z[...]
+    std::int64_t length;
+    std::int64_t n_rows;
+    std::int64_t n_first;       // step of the first row (tail mode)
+    double nu;
+    double x0, y0, z0;
+    double w[9];
+    std::int64_t n_iter;
+};
+
+static_assert(sizeof(SweepArchiveHeader) == 64, "unexpected SweepArchiveHeader layout");
+static_assert(sizeof(SweepArchiveEntry) == 160, "unexpected SweepArchiveEntry layout");
+
+constexpr char sweep_archive_magic[8] = {'H', 'F', 'S', 'W', 'E', 'E', 'P', '1'};
+
+class SweepArchive
+{
+    int fd {-1};
+    SweepArchiveHeader header {};
+    std::mutex mutex; // flock does not exclude threads sharing one file descriptor
+
+    // Exclusive lock against the other threads of this process and (flock) the other processes
+    class Lock
+    {
+        SweepArchive& archive;
+        std::lock_guard<std::mutex> guard;
+
+    public:
+        explicit Lock(SweepArchive& archive_) : archive(archive_), guard(archive_.mutex) {flock(archive.fd, LOCK_EX);}
+        ~Lock() {flock(archive.fd, LOCK_UN);}
+    };
+
+    std::int64_t entryOffset(int config_id) const
+    {
+        return header.header_size + (std::int64_t)(config_id - header.id_low) * header.entry_size;
+    }
+
+public:
+    SweepArchive() = default;
+    SweepArchive(const SweepArchive&) = delete;
+    SweepArchive& operator=(const SweepArchive&) = delete;
+    ~SweepArchive() {if(fd >= 0) ::close(fd);}
+
+    // Opens the archive for IDs id_low..id_high, creating it (with an empty index) if it does not exist yet. Returns
+    // false (after printing the error) if it cannot be opened or was created for another range.
+    bool open(const std::string& path, int id_low, int id_high)
+    {
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if(fd < 0)
+        {
+            std::cerr << "ERROR opening sweep archive " << path << '\n';
+            return false;
+        }
+
+        Lock lock(*this);
+        struct stat st;
+        if(fstat(fd, &st) != 0) return false;
+
+        if(st.st_size == 0)
+        {
+            std::memcpy(header.magic, sweep_archive_magic, sizeof(header.magic));
+            header.header_size = sizeof(SweepArchiveHeader);
+            header.entry_size = sizeof(SweepArchiveEntry);
+            header.id_low = id_low;
+            header.id_high = id_high;
+            header.data_offset = header.header_size + (std::int64_t)(id_high - id_low + 1) * header.entry_size;
+
+            std::vector<SweepArchiveEntry> index(id_high - id_low + 1);
+            std::memset(index.data(), 0, index.size() * sizeof(SweepArchiveEntry));
+            for(int id=id_low; id<=id_high; id++) index[id - id_low].config_id = id;
+
+            if(!pwriteAll(fd, &header, sizeof(header), 0) || !pwriteAll(fd, index.data(), index.size() * sizeof(SweepArchiveEntry), header.header_size))
+            {
+                std::cerr << "ERROR writing sweep archive " << path << '\n';
+                return false;
+            }
+            return true;
+        }
+
+        if(pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)
+           || std::memcmp(header.magic, sweep_archive_magic, sizeof(header.magic)) != 0
+           || header.entry_size != sizeof(SweepArchiveEntry) || header.id_low != id_low || header.id_high != id_high)
+        {
+            std::cerr << "ERROR " << path << " is not a sweep archive for configs " << id_low << "-" << id_high << '\n';
+            return false;
+        }
+        return true;
+    }
+
+    // Opens an existing archive for reading (whatever its range), returns false if there is none
+    bool openExisting(const std::string& path)
+    {
+        fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0) return false;
+        return pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header)
+               && std::memcmp(header.magic, sweep_archive_magic, sizeof(header.magic)) == 0 && header.entry_size == sizeof(SweepArchiveEntry);
+    }
+
+    int idLow() const {return (int)header.id_low;}
+    int idHigh() const {return (int)header.id_high;}
+
+    bool contains(int config_id) const {return config_id >= header.id_low && config_id <= header.id_high;}
+
+    // Index entry of config_id (status archive_empty if it cannot be read)
+    SweepArchiveEntry entry(int config_id) const
+    {
+        SweepArchiveEntry e {};
+        if(!contains(config_id) || pread(fd, &e, sizeof(e), entryOffset(config_id)) != (ssize_t)sizeof(e)) e.status = archive_empty;
+        return e;
+    }
+
+    bool setEntry(const SweepArchiveEntry& e)
+    {
+        if(!contains((int)e.config_id)) return false;
+        Lock lock(*this);
+        return pwriteAll(fd, &e, sizeof(e), entryOffset((int)e.config_id));
+    }
+
+    // Last n_last steps of the trajectory of config_id (fewer if it is shorter), false if there is none
+    bool readTail(int config_id, std::int64_t n_last, std::vector<double>& x, std::vector<double>& y, std::vector<double>& z) const
+    {
+        const SweepArchiveEntry e = entry(config_id);
+        if(e.status != archive_done) return false;
+
+        const std::int64_t count = std::min(n_last, e.n_rows);
+        std::vector<double>* columns[3] = {&x, &y, &z};
+        for(int c=0; c<3; c++)
+            if(!readBinaryColumn(fd, e.offset + (c*e.n_rows + e.n_rows - count) * e.value_size, e.value_size, count, *columns[c])) return false;
+        return true;
+    }
+
+    // Appends a data block and points the entry of e.config_id at it (e.status, n_rows etc. are taken from 'e')
+    bool append(SweepArchiveEntry e, const std::vector<char>& block)
+    {
+        if(!contains((int)e.config_id)) return false;
+
+        std::int64_t offset;
+        {
+            Lock lock(*this);
+            struct stat st;
+            if(fstat(fd, &st) != 0) return false;
+            offset = std::max<std::int64_t>(st.st_size, header.data_offset);
+            offset = (offset + 63) / 64 * 64;
+            if(ftruncate(fd, offset + (std::int64_t)block.size()) != 0) return false;
+        }
+
+        if(!pwriteAll(fd, block.data(), block.size(), offset)) return false;
+
+        e.offset = offset;
+        e.length = (std::int64_t)block.size();
+        return setEntry(e);
+    }
+};
+
+// Index entry carrying the parameters of 'info' (status archive_params, no data block yet)
+inline SweepArchiveEntry sweepArchiveEntry(int config_id, const TrajectoryInfo& info)
+{
+    SweepArchiveEntry e {};
+    e.config_id = config_id;
+    e.status = archive_params;
+    e.nu = info.nu;
+    e.x0 = info.x0;
+    e.y0 = info.y0;
+    e.z0 = info.z0;
+    std::memcpy(e.w, info.w, sizeof(e.w));
+    e.n_iter = info.n_iter;
+    e.n_first = info.n_first;
+    return e;
+}
+
+/*
+ * Collects the columns of one trajectory in memory and appends them to the archive as one block on close(), rows
+ * before info.n_first are dropped. A run that stops early is stored with the rows it produced, but only an entry with
+ * all n_iter - n_first rows is marked archive_done, any other one archive_failed.
+ */
+class ArchiveTrajectoryWriter : public TrajectoryWriter
+{
+    SweepArchive& archive;
+    SweepArchiveEntry e;
+    std::vector<char> columns[3];
+    bool closed {false};
+
+public:
+    ArchiveTrajectoryWriter(SweepArchive& archive_, int config_id, const TrajectoryInfo& info, std::uint32_t value_size)
+        : archive(archive_), e(sweepArchiveEntry(config_id, info))
+    {
+        e.value_size = value_size;
+        for(int c=0; c<3; c++) columns[c].reserve((size_t)(info.n_iter - info.n_first) * value_size);
+    }
+
+    ~ArchiveTrajectoryWriter() override {close();}
+
+    void write(int n, double x, double y, double z) override
+    {
+        if(n < e.n_first) return;
+
+        const double values[3] = {x, y, z};
+        for(int c=0; c<3; c++)
+        {
+            if(e.value_size == 4)
+            {
+                const float value = (float)values[c];
+                columns[c].insert(columns[c].end(), (const char*)&value, (const char*)&value + 4);
+            }
+            else columns[c].insert(columns[c].end(), (const char*)&values[c], (const char*)&values[c] + 8);
+        }
+        e.n_rows++;
+    }
+
+    void close() override
+    {
+        if(closed) return;
+        closed = true;
+
+        std::vector<char> block;
+        block.reserve(3 * columns[0].size());
+        for(int c=0; c<3; c++) block.insert(block.end(), columns[c].begin(), columns[c].end());
+
+        e.status = (e.n_rows == e.n_iter - e.n_first) ? archive_done : archive_failed;
+        if(!archive.append(e, block)) std::cerr << "ERROR appending config " << e.config_id << " to the sweep archive\n";
+    }
+};
+
+// Archive file of the range id_low..id_high (in $PROJECT/data/time-evol/<CONTROL_PARAM_NAME>/)
+inline std::string sweepArchiveName(int id_low, int id_high)
+{
+    std::ostringstream oss;
+    oss << "archive_config-" << std::setw(7) << std::setfill('0') << id_low << "-" << std::setw(7) << std::setfill('0') << id_high << ".hfa";
+    return oss.str();
+}
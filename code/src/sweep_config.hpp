@@ -0,0 +1,106 @@
+#pragma once
+
+#include "hopfield.hpp"
+#include "sweep_archive.hpp"
+
+#include <algorithm>
+
+/*
+ * Helpers shared by the tools that work on whole gen_params ranges of configurations (sweep, bifur_render): which
+ * CONFIG file and CONTROL_PARAM_NAME a config ID belongs to, the file names used for it and its control parameter value.
+ */
+
+// Range of config IDs generated by one gen_params call, together with the CONFIG file saved for it
+struct ConfigRange
+{
+    int id_low, id_high;
+    fs::path config_file;
+    std::string control_param_name;
+    fs::path spec_file;             // sweep spec of the range (gen_params --spec), empty if it has wparams files
+};
+
+// Reads 'NAME=value' from a CONFIG-like shell file (quotes and trailing comments removed), "" if not found
+inline std::string readConfigValue(const fs::path& config_file, const std::string& name)
+{
+    std::ifstream file(config_file);
+    std::string line;
+    while(std::getline(file, line))
+    {
+        if(line.rfind(name + "=", 0) != 0) continue;
+
+        std::string value = line.substr(name.size() + 1);
+        value = value.substr(0, value.find_first_of(" \t#;"));
+        value.erase(std::remove(value.begin(), value.end(), '"'), value.end());
+        return value;
+    }
+    return "";
+}
+
+// Looks up the gen_params range holding config_id (parameters/configs/config_id_list.txt), returns false if there is none
+inline bool resolveConfigRange(const fs::path& PARAMS_DIR, int config_id, ConfigRange& range)
+{
+    std::ifstream config_id_list_file(PARAMS_DIR / "configs" / "config_id_list.txt");
+    if(!config_id_list_file.is_open())
+    {
+        std::cerr << "ERROR opening " << PARAMS_DIR / "configs" / "config_id_list.txt" << '\n';
+        return false;
+    }
+
+    int id_low, id_high;
+    while(config_id_list_file >> id_low >> id_high)
+    {
+        if(config_id < id_low || config_id > id_high) continue;
+
+        std::ostringstream oss;
+        oss << "config-" << std::setw(7) << std::setfill('0') << id_low << "-" << std::setw(7) << std::setfill('0') << id_high << ".sh";
+
+        for(const fs::directory_entry& dir : fs::directory_iterator(PARAMS_DIR / "configs"))
+        {
+            if(!dir.is_directory() || !fs::exists(dir.path() / oss.str())) continue;
+
+            range.id_low = id_low;
+            range.id_high = id_high;
+            range.config_file = dir.path() / oss.str();
+            range.control_param_name = readConfigValue(range.config_file, "CONTROL_PARAM_NAME");
+            if(range.control_param_name.empty()) range.control_param_name = dir.path().filename().string();
+            range.spec_file = sweepSpecPath(range.config_file.string());
+            if(!fs::exists(range.spec_file)) range.spec_file.clear();
+            return true;
+        }
+
+        std::cerr << "ERROR config file " << oss.str() << " not found in " << PARAMS_DIR / "configs" << '\n';
+        return false;
+    }
+
+    std::cerr << "ERROR config ID " << config_id << " is not listed in config_id_list.txt\n";
+    return false;
+}
+
+inline std::string configFileName(const std::string& prefix, int config_id, const std::string& extension)
+{
+    std::ostringstream oss;
+    oss << prefix << std::setw(7) << std::setfill('0') << config_id << extension;
+    return oss.str();
+}
+
+// Parameters of config_id for Params(): its wparams file, or "<spec file>#<config ID>" if the range has a sweep spec
+inline fs::path configParamsPath(const fs::path& PARAMS_DIR, const ConfigRange& range, int config_id)
+{
+    if(!range.spec_file.empty()) return range.spec_file.string() + "#" + std::to_string(config_id);
+    return PARAMS_DIR / "wparams" / range.control_param_name / configFileName("wparams_config-", config_id, ".txt");
+}
+
+// Value of the control parameter 'name' (nu, x0, ..., w33 as in gen_params, see trajectoryParam) in 'info'
+inline double controlParamValue(TrajectoryInfo info, const std::string& name)
+{
+    const double* value = trajectoryParam(info, name);
+    return (value != nullptr) ? *value : std::nan("");
+}
+
+// Parameters stored in a sweep archive entry
+inline TrajectoryInfo archivedInfo(const SweepArchiveEntry& e)
+{
+    TrajectoryInfo info {e.nu, e.x0, e.y0, e.z0, {}, e.n_iter, e.n_first};
+    std::copy(e.w, e.w + 9, info.w);
+    return info;
+}
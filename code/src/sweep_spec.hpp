@@ -0,0 +1,233 @@
+#pragma once
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <fstream>
+#include <limits>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+#include <string>
+
+#include "trajectory_io.hpp"
+
+/*
+ * Sweep spec: the whole gen_params range id_low..id_high in one small text file instead of one wparams file per config
+ * (gen_params --spec). It is saved next to the CONFIG copy of the range as parameters/configs/<CONTROL_PARAM_NAME>/
+ * config-XXXXXXX-YYYYYYY.spec and holds the base parameters and the grid of the control parameter:
+ *
+ *      id_low 9000
+ *      id_high 9999
+ *      control_param_name nu
+ *      param_min 0.001
+ *      param_step 0.001
+ *      nu 0.45
+ *      x0 0.2  y0 ...  z0 ...  w11 ... w33 ...
+ *      n_iter 100000
+ *
+ * (one 'name value' pair per line, values written with as many digits as they need to read back exactly). Config
+ * k = id_low + i is materialised on demand by config(k): the base parameters with the control parameter set to
+ * param_min + i*param_step. The solvers take a spec wherever they take a wparams file, as "<spec file>#<config ID>".
+ *
+ * A two-dimensional grid (gen_params --grid) adds a second control parameter with
+ *
+ *      control_param_name2 w31
+ *      param_min2 -5
+ *      param_step2 0.01
+ *      n_values2 500
+ *
+ * and lays the grid out row by row: config id_low + i*n_values2 + j has the first control parameter at its i-th and
+ * the second one at its j-th value. Without these lines n_values2 is 1 (one-dimensional range).
+ *
+ * param_min and param_step are kept as the decimal strings gen_params was given. If both are plain decimals, the
+ * value is computed as (min + i*step) * 10^d / 10^d in 64-bit integers (d = number of decimals), so every config gets
+ * the double closest to its decimal value (same values as the wparams files of 3-decimal ranges) at any step size.
+ */
+
+// Shortest decimal representation that reads back as exactly 'v'
+inline std::string exactDecimal(double v)
+{
+    for(int precision : {15, 16, 17})
+    {
+        std::ostringstream oss;
+        oss << std::setprecision(precision) << v;
+        if(std::stod(oss.str()) == v || precision == 17) return oss.str();
+    }
+    return "";
+}
+
+// Parses a plain decimal ("-1.25", "0.0001") into mantissa * 10^-decimals, false for anything else (e.g. "1e-6")
+inline bool parseDecimal(const std::string& s, std::int64_t& mantissa, int& decimals)
+{
+    if(s.empty()) return false;
+    size_t i = (s[0] == '-' || s[0] == '+') ? 1 : 0;
+    mantissa = 0;
+    decimals = -1;
+    bool digits = false;
+    for(; i<s.size(); i++)
+    {
+        if(s[i] == '.' && decimals < 0) decimals = 0;
+        else if(s[i] >= '0' && s[i] <= '9')
+        {
+            if(mantissa > (std::numeric_limits<std::int64_t>::max() - 9) / 10) return false;
+            mantissa = 10*mantissa + (s[i] - '0');
+            if(decimals >= 0) decimals++;
+            digits = true;
+        }
+        else return false;
+    }
+    if(s[0] == '-') mantissa = -mantissa;
+    if(decimals < 0) decimals = 0;
+    return digits && decimals <= 18;
+}
+
+// Pointer to the parameter 'name' (nu, x0, y0, z0, w11, ..., w33) in 'info', nullptr for an unknown name
+inline double* trajectoryParam(TrajectoryInfo& info, const std::string& name)
+{
+    if(name == "nu") return &info.nu;
+    if(name == "x0") return &info.x0;
+    if(name == "y0") return &info.y0;
+    if(name == "z0") return &info.z0;
+    if(name.size() == 3 && name[0] == 'w' && name[1] >= '1' && name[1] <= '3' && name[2] >= '1' && name[2] <= '3')
+        return &info.w[3*(name[1]-'1') + (name[2]-'1')];
+    return nullptr;
+}
+
+struct SweepSpec
+{
+    int id_low {0}, id_high {-1};
+    std::string control_param_name;
+    std::string param_min, param_step;
+    TrajectoryInfo base {};
+    std::string control_param_name2; // second control parameter of a 2D grid ("" for a 1D range)
+    std::string param_min2, param_step2;
+    int n_values2 {1};
+
+    bool contains(int config_id) const {return config_id >= id_low && config_id <= id_high;}
+    bool isGrid() const {return !control_param_name2.empty();}
+    int rows() const {return (id_high - id_low + 1) / n_values2;}
+
+    // i-th value of the grid param_min + i*param_step
+    static double gridValue(const std::string& param_min, const std::string& param_step, std::int64_t i)
+    {
+        std::int64_t min_mantissa, step_mantissa;
+        int min_decimals, step_decimals;
+        if(parseDecimal(param_min, min_mantissa, min_decimals) && parseDecimal(param_step, step_mantissa, step_decimals))
+        {
+            const int decimals = std::max(min_decimals, step_decimals);
+            std::int64_t scale_min = 1, scale_step = 1;
+            for(int d=min_decimals; d<decimals; d++) scale_min *= 10;
+            for(int d=step_decimals; d<decimals; d++) scale_step *= 10;
+
+            // Exact as long as the scaled values fit into 53 bits (then both conversions below are exact)
+            const long double scaled = (long double)min_mantissa * scale_min + (long double)i * step_mantissa * scale_step;
+            if(std::fabs(scaled) < 9007199254740992.0L)
+                return (double)(std::int64_t)scaled / std::pow(10.0, decimals);
+        }
+        return std::stod(param_min) + (double)i * std::stod(param_step);
+    }
+
+    // Value of the (first) control parameter of config_id
+    double controlValue(int config_id) const {return gridValue(param_min, param_step, (config_id - id_low) / n_values2);}
+
+    // Value of the second control parameter of config_id (2D grid only)
+    double controlValue2(int config_id) const {return gridValue(param_min2, param_step2, (config_id - id_low) % n_values2);}
+
+    // Parameters of config_id (n_first is 0)
+    TrajectoryInfo config(int config_id) const
+    {
+        TrajectoryInfo info = base;
+        *trajectoryParam(info, control_param_name) = controlValue(config_id);
+        if(isGrid()) *trajectoryParam(info, control_param_name2) = controlValue2(config_id);
+        return info;
+    }
+
+    bool write(const std::string& path) const
+    {
+        std::ofstream file(path);
+        if(!file.is_open())
+        {
+            std::cerr << "ERROR opening " << path << '\n';
+            return false;
+        }
+
+        const char* w_names[9] = {"w11", "w12", "w13", "w21", "w22", "w23", "w31", "w32", "w33"};
+        file << "id_low " << id_low << '\n' << "id_high " << id_high << '\n';
+        file << "control_param_name " << control_param_name << '\n';
+        file << "param_min " << param_min << '\n' << "param_step " << param_step << '\n';
+        if(isGrid())
+        {
+            file << "control_param_name2 " << control_param_name2 << '\n';
+            file << "param_min2 " << param_min2 << '\n' << "param_step2 " << param_step2 << '\n';
+            file << "n_values2 " << n_values2 << '\n';
+        }
+        file << "nu " << exactDecimal(base.nu) << '\n' << "x0 " << exactDecimal(base.x0) << '\n'
+             << "y0 " << exactDecimal(base.y0) << '\n' << "z0 " << exactDecimal(base.z0) << '\n';
+        for(int k=0; k<9; k++) file << w_names[k] << ' ' << exactDecimal(base.w[k]) << '\n';
+        file << "n_iter " << base.n_iter << '\n';
+        return file.good();
+    }
+
+    // Reads a spec written by write(), returns false (after printing the error) if it is incomplete
+    bool read(const std::string& path)
+    {
+        std::ifstream file(path);
+        if(!file.is_open())
+        {
+            std::cerr << "ERROR opening " << path << '\n';
+            return false;
+        }
+
+        base = {};
+        base.n_iter = -1;
+        int n_values = 0;
+        std::string name, value;
+        while(file >> name >> value)
+        {
+            if(name == "id_low") id_low = std::stoi(value);
+            else if(name == "id_high") id_high = std::stoi(value);
+            else if(name == "control_param_name") control_param_name = value;
+            else if(name == "param_min") param_min = value;
+            else if(name == "param_step") param_step = value;
+            else if(name == "control_param_name2") control_param_name2 = value;
+            else if(name == "param_min2") param_min2 = value;
+            else if(name == "param_step2") param_step2 = value;
+            else if(name == "n_values2") n_values2 = std::stoi(value);
+            else if(name == "n_iter") base.n_iter = std::stoll(value);
+            else if(double* p = trajectoryParam(base, name))
+            {
+                *p = std::stod(value);
+                n_values++;
+            }
+        }
+
+        TrajectoryInfo probe {};
+        if(n_values != 13 || base.n_iter < 0 || id_high < id_low || param_min.empty() || param_step.empty()
+           || trajectoryParam(probe, control_param_name) == nullptr || n_values2 < 1 || (id_high - id_low + 1) % n_values2 != 0
+           || (isGrid() && (trajectoryParam(probe, control_param_name2) == nullptr || param_min2.empty() || param_step2.empty())))
+        {
+            std::cerr << "ERROR " << path << " is not a complete sweep spec\n";
+            return false;
+        }
+        return true;
+    }
+};
+
+// Spec of the gen_params range whose CONFIG copy is 'config_file' (config-XXXXXXX-YYYYYYY.sh -> .spec)
+inline std::string sweepSpecPath(const std::string& config_file)
+{
+    const size_t dot = config_file.rfind(".sh");
+    return (dot == std::string::npos ? config_file : config_file.substr(0, dot)) + ".spec";
+}
+
+// Splits "<spec file>#<config ID>" into its parts, false if 'path' does not have this form
+inline bool splitSpecPath(const std::string& path, std::string& spec_path, int& config_id)
+{
+    const size_t hash = path.rfind('#');
+    if(hash == std::string::npos || hash + 1 == path.size() || path.find_first_not_of("0123456789", hash + 1) != std::string::npos)
+        return false;
+    spec_path = path.substr(0, hash);
+    config_id = std::stoi(path.substr(hash + 1));
+    return spec_path.size() > 5 && spec_path.compare(spec_path.size() - 5, 5, ".spec") == 0;
+}
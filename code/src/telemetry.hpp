@@ -0,0 +1,357 @@
+#pragma once
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <filesystem>
+#include <sstream>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <string>
+
+#include "checkpoint.hpp"
+#include "trajectory_io.hpp"
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+/*
+ * Run telemetry of time-evol: where the time of a run goes, and how far a running job is.
+ *
+ *  - Phase timers (always on): wall-clock seconds of the phases
+ *        params    argument parsing and reading the params file
+ *        kernel    engine setup up to the first step: kernel construction (or mapping it from the kernel cache),
+ *                  SOE fit, FFT plans, ...
+ *        stepping  the step loop, without the time spent handing steps to the output writer
+ *        output    opening the output file, writing the known steps (initial state, checkpoint, --continue), handing
+ *                  every computed step to the writer and closing it (with the asynchronous writer: waiting for it)
+ *  - Hardware counters (--perf-counters): cycles, instructions and last-level cache misses of the whole process,
+ *    threads included, counted with perf_event_open in user space. Not available everywhere (containers,
+ *    /proc/sys/kernel/perf_event_paranoid > 2); the run then goes on without them.
+ *  - Heartbeat (--heartbeat[=S]): <output file>.heartbeat, rewritten (atomically) every S seconds and at every phase
+ *    change as "name value" lines:
+ *
+ *        phase stepping
+ *        step 412000
+ *        n_iter 1000000
+ *        elapsed_s 1804.2
+ *        steps_per_s 161.7
+ *        eta_s 8921
+ *        projected_end 2026-10-17T21:14:05
+ *        updated 2026-10-17T18:45:24
+ *
+ *    steps_per_s is the rate since the previous heartbeat. eta_s extrapolates the time per step measured so far with
+ *    the cost model of the engine (HopfieldNetwork::Engine::work_exponent): the work up to step n grows like n^2 for
+ *    the O(n_iter^2) engines, so the ETA of a quadratic run is not the remaining steps over the current rate.
+ *  - Summary (--summary[=FILE], default <output file>.summary.json): JSON with engine, steps, status, the phase times
+ *    and the counters, written when the run ends, also when it fails or is stopped by SIGTERM (the time limit of a
+ *    SLURM job; status "terminated", the process then terminates as it would have without the summary).
+ */
+
+// Wall-clock time as YYYY-MM-DDTHH:MM:SS (local time)
+inline std::string isoTime(std::time_t t)
+{
+    std::tm tm {};
+    localtime_r(&t, &tm);
+    char buffer[32];
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &tm);
+    return buffer;
+}
+
+// Cycles, instructions and LLC misses of this process and of the threads it starts after open()
+class PerfCounters
+{
+    struct Counter
+    {
+        const char* name;
+        std::uint32_t type;
+        std::uint64_t config;
+        int fd;
+    };
+
+    std::vector<Counter> counters {
+        {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, -1},
+        {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, -1},
+        {"llc_misses", PERF_TYPE_HW_CACHE,
+         PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16), -1},
+    };
+
+public:
+    PerfCounters() = default;
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+    ~PerfCounters() {for(const Counter& c : counters) if(c.fd >= 0) ::close(c.fd);}
+
+    // Starts the counters the kernel lets us open, false (after printing a warning) if there is none
+    bool open()
+    {
+        bool any = false;
+        for(Counter& c : counters)
+        {
+            perf_event_attr attr {};
+            attr.size = sizeof(attr);
+            attr.type = c.type;
+            attr.config = c.config;
+            attr.inherit = 1;        // threads started later (writer thread, 'threaded' engine) are counted as well
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            c.fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+            any = any || c.fd >= 0;
+        }
+        if(!any) std::cerr << "WARNING hardware counters are not available (perf_event_open: " << std::strerror(errno) << ")\n";
+        return any;
+    }
+
+    // (name, count) of every open counter, scaled up if the kernel had to multiplex them; the counts of threads are
+    // included once they have ended
+    std::vector<std::pair<std::string, double>> read() const
+    {
+        std::vector<std::pair<std::string, double>> values;
+        for(const Counter& c : counters)
+        {
+            std::uint64_t v[3];
+            if(c.fd < 0 || ::read(c.fd, v, sizeof(v)) != (ssize_t)sizeof(v)) continue;
+            values.emplace_back(c.name, (v[2] > 0) ? (double)v[0] * ((double)v[1] / v[2]) : 0.0);
+        }
+        return values;
+    }
+};
+
+class RunTelemetry
+{
+    using Clock = std::chrono::steady_clock;
+
+    const Clock::time_point start {Clock::now()};
+    const std::time_t start_time {std::time(nullptr)};
+
+    std::vector<std::pair<std::string, double>> phases; // the four phases, then any other in the order of first use
+    std::string current;
+    Clock::time_point phase_start;
+    double deferred_output {0};   // output time spent inside the current phase (handing steps to the writer)
+
+    std::string engine;
+    int n_iter {0};
+    int work_exponent {2};
+    std::int64_t step_first {-1}; // first step computed by this process and when it was reached
+    Clock::time_point first_time;
+    std::int64_t step {-1};       // last step handed to the writer
+    std::int64_t heartbeat_step {0};
+    Clock::time_point heartbeat_time;
+    Clock::time_point next_heartbeat;
+
+    std::unique_ptr<PerfCounters> counters;
+    bool finished {false};
+
+    double& phaseSeconds(const std::string& name)
+    {
+        for(auto& [phase, seconds] : phases) if(phase == name) return seconds;
+        phases.emplace_back(name, 0.0);
+        return phases.back().second;
+    }
+
+    static double seconds(Clock::duration d) {return std::chrono::duration<double>(d).count();}
+
+    // Projected seconds to the last step, -1 while there is nothing to extrapolate from
+    double eta(Clock::time_point now) const
+    {
+        if(step_first < 0 || step <= step_first || n_iter <= 0) return -1;
+        const double p = work_exponent;
+        const double done = std::pow((double)step, p) - std::pow((double)step_first, p);
+        const double left = std::pow((double)n_iter - 1, p) - std::pow((double)step, p);
+        return (done > 0) ? seconds(now - first_time) * std::max(left, 0.0) / done : -1;
+    }
+
+    void writeHeartbeat(Clock::time_point now)
+    {
+        if(heartbeat_path.empty()) return;
+        const double interval = seconds(now - heartbeat_time);
+        const double rate = (interval > 0 && step > heartbeat_step) ? (step - heartbeat_step) / interval : 0.0;
+        heartbeat_step = std::max<std::int64_t>(step, 0);
+        heartbeat_time = now;
+        next_heartbeat = now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(heartbeat_interval));
+
+        const double eta_s = eta(now);
+        const std::time_t wall = std::time(nullptr);
+        const fs::path tmp = heartbeat_path + ".tmp";
+        {
+            std::ofstream file(tmp);
+            file << std::fixed << std::setprecision(1)
+                 << "phase " << current << '\n'
+                 << "step " << std::max<std::int64_t>(step, 0) << '\n'
+                 << "n_iter " << n_iter << '\n'
+                 << "elapsed_s " << seconds(now - start) << '\n'
+                 << "steps_per_s " << rate << '\n'
+                 << "eta_s " << (eta_s < 0 ? -1 : std::llround(eta_s)) << '\n'
+                 << "projected_end " << (eta_s < 0 ? "unknown" : isoTime(wall + (std::time_t)std::llround(eta_s))) << '\n'
+                 << "updated " << isoTime(wall) << '\n';
+        }
+        std::error_code ec;
+        fs::rename(tmp, heartbeat_path, ec);
+    }
+
+public:
+    std::string heartbeat_path;    // "" = no heartbeat
+    double heartbeat_interval {60};
+    std::string summary_path;      // "" = no summary
+
+    explicit RunTelemetry(bool perf_counters=false) : current("params"), phase_start(start), heartbeat_time(start)
+    {
+        for(const char* name : {"params", "kernel", "stepping", "output"}) phases.emplace_back(name, 0.0);
+        if(perf_counters)
+        {
+            counters = std::make_unique<PerfCounters>();
+            if(!counters->open()) counters.reset();
+        }
+    }
+
+    // Engine, steps and cost model (run time ~ n_iter^work_exponent) of the run, for the ETA
+    void setRun(const std::string& engine_, int n_iter_, int work_exponent_)
+    {
+        engine = engine_;
+        n_iter = n_iter_;
+        work_exponent = std::max(1, work_exponent_);
+    }
+
+    // Ends the current phase and starts 'name'
+    void phase(const std::string& name)
+    {
+        const Clock::time_point now = Clock::now();
+        phaseSeconds(current) += seconds(now - phase_start) - deferred_output;
+        phaseSeconds("output") += deferred_output;
+        deferred_output = 0;
+        current = name;
+        phase_start = now;
+        writeHeartbeat(now);
+    }
+
+    // The last step of the run has been handed to the writer
+    bool complete() const {return n_iter > 0 && step == n_iter - 1;}
+
+    // 'seconds' of the current phase were spent on the output
+    void addOutput(double seconds) {deferred_output += seconds;}
+
+    // Step n was handed to the writer at 'now' (steps written before the stepping phase are known ones, e.g. restored from
+    // a checkpoint, and do not count for the rate)
+    void progress(std::int64_t n, Clock::time_point now)
+    {
+        if(step_first < 0 && current == "stepping")
+        {
+            step_first = n;
+            first_time = now;
+        }
+        step = n;
+        if(!heartbeat_path.empty() && now >= next_heartbeat) writeHeartbeat(now);
+    }
+
+    // Summary and heartbeat are also wanted when the job is stopped at its time limit: SIGTERM only sets
+    // checkpoint_signal (as CheckpointWriter does), TelemetryWriter then finishes the run
+    void catchTermination() const {std::signal(SIGTERM, requestCheckpoint);}
+
+    // Ends the run: prints the phase times (if 'verbose') and writes the final heartbeat and the summary with 'status'
+    // ("completed", "failed", "terminated"); only the first call counts
+    void finish(const std::string& status, bool verbose=true)
+    {
+        if(finished) return;
+        phase("done");
+        finished = true;
+        const double total = seconds(Clock::now() - start);
+        std::vector<std::pair<std::string, double>> counts;
+        if(counters) counts = counters->read();
+
+        if(verbose)
+        {
+            const std::streamsize precision = std::cout.precision(3);
+            std::cout << std::fixed << "phases:";
+            for(const auto& [name, secs] : phases) std::cout << ' ' << name << ' ' << secs << " s";
+            std::cout << ", total " << total << " s\n" << std::defaultfloat;
+            if(!counts.empty())
+            {
+                std::cout << "counters:";
+                for(const auto& [name, value] : counts) std::cout << ' ' << name << ' ' << std::setprecision(4) << value;
+                std::cout << std::defaultfloat << '\n';
+            }
+            std::cout.precision(precision);
+        }
+
+        if(summary_path.empty()) return;
+        std::ofstream json(summary_path);
+        if(!json.is_open())
+        {
+            std::cerr << "ERROR opening " << summary_path << '\n';
+            return;
+        }
+        const std::int64_t steps = (step_first < 0) ? 0 : step - step_first + 1;
+        const double stepping = phaseSeconds("stepping");
+        json << std::setprecision(9)
+             << "{\n"
+             << "  \"status\": \"" << status << "\",\n"
+             << "  \"engine\": \"" << engine << "\",\n"
+             << "  \"n_iter\": " << n_iter << ",\n"
+             << "  \"last_step\": " << step << ",\n"
+             << "  \"steps_computed\": " << steps << ",\n"
+             << "  \"steps_per_s\": " << ((stepping > 0) ? steps / stepping : 0.0) << ",\n"
+             << "  \"started\": \"" << isoTime(start_time) << "\",\n"
+             << "  \"total_s\": " << total << ",\n"
+             << "  \"phases_s\": {";
+        for(size_t k=0; k<phases.size(); k++)
+            json << (k ? ", " : "") << '"' << phases[k].first << "\": " << phases[k].second;
+        json << "},\n  \"counters\": {";
+        for(size_t k=0; k<counts.size(); k++) json << (k ? ", " : "") << '"' << counts[k].first << "\": " << std::llround(counts[k].second);
+        json << "}\n}\n";
+        if(!json.good()) std::cerr << "ERROR writing " << summary_path << '\n';
+    }
+};
+
+/*
+ * Passes every step on to the output writer ('sink'), accounts the time this takes as output and reports the step to
+ * the telemetry. On SIGTERM (with a summary, see RunTelemetry) the summary is written, the sink closed (which commits
+ * a checkpoint) and the process terminated.
+ */
+class TelemetryWriter : public TrajectoryWriter
+{
+    std::unique_ptr<TrajectoryWriter> sink;
+    RunTelemetry& telemetry;
+    bool closed {false};
+
+public:
+    TelemetryWriter(std::unique_ptr<TrajectoryWriter> sink_, RunTelemetry& telemetry_) : sink(std::move(sink_)), telemetry(telemetry_) {}
+
+    ~TelemetryWriter() override {close();}
+
+    void write(int n, double x, double y, double z) override
+    {
+        if(checkpoint_signal == SIGTERM && !telemetry.summary_path.empty())
+        {
+            telemetry.finish("terminated", false);
+            closed = true;
+            sink->close();
+            std::signal(SIGTERM, SIG_DFL);
+            std::raise(SIGTERM);
+        }
+
+        const auto t0 = std::chrono::steady_clock::now();
+        sink->write(n, x, y, z);
+        const auto t1 = std::chrono::steady_clock::now();
+        telemetry.addOutput(std::chrono::duration<double>(t1 - t0).count());
+        telemetry.progress(n, t1);
+    }
+
+    void close() override
+    {
+        if(closed) return;
+        closed = true;
+        telemetry.phase("output");
+        sink->close();
+    }
+};
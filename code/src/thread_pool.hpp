@@ -0,0 +1,182 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <deque>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+#include <atomic>
+
+/*
+ * Work-stealing pool running n_tasks independent tasks (indexed 0..n_tasks-1) on n_threads threads.
+ *
+ * The tasks are dealt round-robin into one deque per thread. A thread takes work from the back of its own deque and,
+ * once that is empty, steals from the front of the other deques. A thread that drew short tasks (early-terminating or
+ * smaller configs) therefore keeps helping the others until the whole set is done, there is no static partition.
+ * Tasks are coarse (whole time evolutions), so a mutex per deque is cheap enough.
+ */
+class WorkStealingPool
+{
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<int> tasks;
+    };
+
+    std::vector<Queue> queues;
+
+    bool popOwn(int t, int& task)
+    {
+        std::lock_guard<std::mutex> lock(queues[t].mutex);
+        if(queues[t].tasks.empty()) return false;
+        task = queues[t].tasks.back();
+        queues[t].tasks.pop_back();
+        return true;
+    }
+
+    bool steal(int t, int& task)
+    {
+        const int n_threads = (int)queues.size();
+        for(int k=1; k<n_threads; k++)
+        {
+            Queue& victim = queues[(t+k) % n_threads];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if(victim.tasks.empty()) continue;
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+public:
+    // Blocks until every task has been executed; 'work' receives the task index and the index of the running thread
+    void run(int n_tasks, int n_threads, const std::function<void(int task, int thread)>& work)
+    {
+        if(n_threads < 1) n_threads = 1;
+        if(n_threads > n_tasks) n_threads = (n_tasks > 0) ? n_tasks : 1;
+
+        queues = std::vector<Queue>(n_threads);
+        for(int i=0; i<n_tasks; i++) queues[i % n_threads].tasks.push_front(i); // so that popOwn() starts with the lowest IDs
+
+        // No task is ever added after this point, so a thread whose own deque is empty and that finds nothing to steal
+        // can simply finish
+        auto worker = [&](int t) {
+            int task;
+            while(popOwn(t, task) || steal(t, task)) work(task, t);
+        };
+
+        std::vector<std::thread> threads;
+        for(int t=1; t<n_threads; t++) threads.emplace_back(worker, t);
+        worker(0);
+        for(std::thread& thread : threads) thread.join();
+    }
+};
+
+/*
+ * Fixed team of n_threads threads (the calling thread included) that repeatedly executes the same kind of job on all
+ * members, e.g. one parallel section per block of time steps. Unlike WorkStealingPool the threads stay alive between
+ * run() calls, so a parallel section costs one wake-up instead of thread creation.
+ */
+class ThreadTeam
+{
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable cv_start, cv_done;
+    const std::function<void(int thread)>* job {nullptr};
+    long generation {0};
+    int pending {0};
+    bool stop {false};
+
+    void worker(int t)
+    {
+        long seen = 0;
+        while(true)
+        {
+            const std::function<void(int)>* current;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv_start.wait(lock, [&] { return stop || generation != seen; });
+                if(stop) return;
+                seen = generation;
+                current = job;
+            }
+
+            (*current)(t);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if(--pending == 0) cv_done.notify_one();
+        }
+    }
+
+public:
+    explicit ThreadTeam(int n_threads)
+    {
+        for(int t=1; t<n_threads; t++) threads.emplace_back(&ThreadTeam::worker, this, t);
+    }
+
+    ~ThreadTeam()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        cv_start.notify_all();
+        for(std::thread& thread : threads) thread.join();
+    }
+
+    int size() const {return (int)threads.size() + 1;}
+
+    // Executes f(t) for t = 0..size()-1 (t = 0 on the calling thread) and returns once all of them are done
+    void run(const std::function<void(int thread)>& f)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &f;
+            pending = (int)threads.size();
+            generation++;
+        }
+        cv_start.notify_all();
+
+        f(0);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        cv_done.wait(lock, [&] { return pending == 0; });
+    }
+};
+
+/*
+ * Bounded lock-free single-producer/single-consumer queue (ring of 'capacity' slots, capacity a power of two).
+ * try_push() may only be called from one thread and try_pop() from one (other) thread; neither ever blocks, waiting
+ * is left to the caller. head and tail live on separate cache lines so the two threads do not share a line.
+ */
+template<typename T>
+class SpscQueue
+{
+    std::vector<T> slots;
+    const size_t mask;
+    alignas(64) std::atomic<size_t> head {0}; // next slot to pop (written by the consumer)
+    alignas(64) std::atomic<size_t> tail {0}; // next slot to push (written by the producer)
+
+public:
+    explicit SpscQueue(size_t capacity) : slots(capacity), mask(capacity - 1) {}
+
+    bool try_push(T value)
+    {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        if(t - head.load(std::memory_order_acquire) == slots.size()) return false;
+        slots[t & mask] = std::move(value);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T& value)
+    {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if(h == tail.load(std::memory_order_acquire)) return false;
+        value = std::move(slots[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+};
@@ -1,460 +1,309 @@
-#include <iostream>
-#include <iomanip>
-#include <fstream>
-#include <filesystem>
-#include <sstream>
-#include <cmath>
-#include <vector>
-#include <tuple>
-#include <string>
-#include <gsl/gsl_errno.h>
-#include <gsl/gsl_odeiv2.h>
-#include <gsl/gsl_sf_gamma.h>
+// Build: g++ -std=c++17 -O2 time-evol.cpp -o time-evol -lgsl -lgslcblas -pthread
 
-namespace fs = std::filesystem;
+#include "hopfield.hpp"
 
-/*
- * ##################################################################################################
- *      [w11 w12 w13]                                                                               |
- *  W = [w21 w22 w23] , where wij is the weight between i-th and j-th neurons                       |
- *      [w31 w32 w33]                                                                               |
- *                                                                                                  |
- *  The following convention was adopted: (1 -> x), (2 -> y), (3 -> z) as this model operates with  |
- *  only three neurons.                                                                             |
- *                                                                                                  |
- * ##################################################################################################
- */ 
-struct Params
-{
-    double nu;
-
-    double x0, y0, z0;
-
-    double w11, w12, w13;
-    double w21, w22, w23;
-    double w31, w32, w33;
-
-    int n_iter;
+#include <chrono>
 
-    Params(std::string filename_wparams_) {setParams(filename_wparams_);}
-
-private:
-    void setParams(const std::string& filename)
+// Seconds taken by one n_iter-step run of the base configuration of CONFIG.sh with 'options', the fastest of a few
+// repetitions for short runs
+double timeEngine(const SolverOptions& options, int n_iter)
+{
+    const TrajectoryInfo info {0.45, 0.2, -0.5, 0.8, {2.0, -1.2, 0.0, 1.9, 1.71, 1.15, -4.75, 0.0, 1.1}, n_iter, 0};
+    double best = std::numeric_limits<double>::infinity(), total = 0.0;
+    for(int repeat=0; repeat<5 && total < 0.5; repeat++)
     {
-        std::ifstream file(filename);
-        
-        if(!file.is_open())
-        {
-            std::cerr << "ERROR opening " << filename << std::endl;
-            return;
-        }
-
-        std::string line;
-
-        // getting nu parameter
-        std::getline(file, line);
-        nu = std::stod(line);
+        Params wparams(info);
+        HopfieldNetwork H(&wparams);
+        H.verbose = false;
+        H.output_writer = [] { return std::unique_ptr<TrajectoryWriter>(new DiscardWriter()); };
+
+        const auto t0 = std::chrono::steady_clock::now();
+        if(!H.run(options, "")) return std::numeric_limits<double>::infinity();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        best = std::min(best, seconds);
+        total += seconds;
+    }
+    return best;
+}
 
-        // getting initial state of the system: x0, y0, z0
-        std::getline(file, line);
-        std::istringstream iss_xyz0(line);
+// time-evol --calibrate: times the exact engines for every n_iter in 'n_iters' on this machine (threaded with up to
+// max_threads threads) and writes the tuning profile --engine=auto picks from (see engine_tuning.hpp)
+int calibrate(const std::vector<int>& n_iters, int max_threads)
+{
+    const fs::path path = tuningProfilePath();
+    if(path.empty())
+    {
+        std::cerr << "ERROR no place for the tuning profile, set PROJECT or HOPFIELD_TUNING\n";
+        return 1;
+    }
 
-        std::vector<double> XYZ0;
-        double xyz0;
-        while(iss_xyz0 >> xyz0)
-        {
-            XYZ0.push_back(xyz0);
-        }
+    std::vector<int> thread_counts;
+    for(int t=2; t<max_threads; t*=2) thread_counts.push_back(t);
+    if(max_threads > 1) thread_counts.push_back(max_threads);
 
-        x0 = XYZ0[0]; y0 = XYZ0[1]; z0 = XYZ0[2];
+    TuningProfile profile;
+    for(int n_iter : n_iters)
+    {
+        std::vector<TunedEngine> settings {{"cached", 0, 1}, {"fft", 0, 1}};
+        for(int block : {512, 1024, 2048, 4096, 8192})
+            if(block < n_iter) settings.push_back({"tiled", block, 1});
 
-        // getting the weights w11, w12, ..., w32, w33
-        std::vector<double> W;
-        while(std::getline(file, line))
+        TunedEngine best_tiled {"tiled", 2048, 1};
+        double best_tiled_seconds = std::numeric_limits<double>::infinity();
+        for(size_t k=0; k<settings.size(); k++)
         {
-            std::istringstream iss_w(line);
-
-            double wvalue;
-            while(iss_w >> wvalue)
+            const TunedEngine e = settings[k];
+            SolverOptions options;
+            options.engine = e.engine;
+            if(e.block_size > 0) options.block_size = e.block_size;
+            options.engine_threads = e.threads;
+
+            const double seconds = timeEngine(options, n_iter);
+            std::cout << "n_iter " << n_iter << ": " << e.engine;
+            if(e.block_size > 0) std::cout << " block " << e.block_size << ", " << e.threads << " thread(s)";
+            std::cout << ": " << seconds << " s\n";
+            if(!std::isfinite(seconds)) continue;
+            profile.add(n_iter, e, seconds);
+
+            if(e.engine == "tiled" && seconds < best_tiled_seconds)
             {
-                W.push_back(wvalue);
+                best_tiled = e;
+                best_tiled_seconds = seconds;
             }
+            // The thread counts of 'threaded' are timed with the best block size of 'tiled', once all of those are done
+            if(k + 1 == settings.size() && e.engine == "tiled")
+                for(int t : thread_counts) settings.push_back({"threaded", best_tiled.block_size, t});
         }
-
-        w11 = W[0]; w12 = W[1]; w13 = W[2];
-        w21 = W[3]; w22 = W[4]; w23 = W[5];
-        w31 = W[6]; w32 = W[7]; w33 = W[8];
-
-        std::getline(file, line);
-        n_iter = std::stoi(line);
-
-        return;
     }
-};
-
-class HopfieldNetwork
-{
-    double x0, y0, z0;
-    Params* wp; // wp - weight parameters including nu which is the order of fractional difference equation (wparams)
-    int n_iter;
 
-public:
-    std::vector<double> x, y, z;
+    if(!profile.write(path)) return 1;
+    std::cout << "tuning profile written to " << path << '\n';
 
-    // Constructor enabling user to specify initial state of the system
-    HopfieldNetwork(double x0_, double y0_, double z0_, void* wparams_, int n_iter_=-1) : x0(x0_), y0(y0_), z0(z0_)
+    for(int n_iter : n_iters)
     {
-        wp = static_cast<Params*>(wparams_);
-
-        // Number of time-evol iterations
-        if(n_iter_ == -1) n_iter = wp->n_iter;
-        else n_iter = n_iter_;
-
-        // Vectors holding the neurons' state
-        x = std::vector<double>(n_iter, 0.0);
-        y = std::vector<double>(n_iter, 0.0);
-        z = std::vector<double>(n_iter, 0.0);
-
-        x[0] = x0;
-        y[0] = y0;
-        z[0] = z0;
+        TunedEngine choice;
+        double seconds;
+        if(!profile.choose(n_iter, max_threads, choice, seconds)) continue;
+        std::cout << "n_iter " << n_iter << " -> " << choice.engine;
+        if(choice.engine == "tiled" || choice.engine == "threaded")
+            std::cout << " block " << choice.block_size << ", " << choice.threads << " thread(s)";
+        std::cout << '\n';
     }
+    return 0;
+}
 
-    // Constructor that uses the initial state of the system specified in the file
-    HopfieldNetwork(void* wparams_)
+// Solves the configurations config_id_min..config_id_max found in wparamsDir (wparams_config-XXXXXXX.txt, or the configs
+// of a sweep spec if wparamsDir is a .spec file) in batches of LANES and writes time-evol_config-XXXXXXX.csv (.bin)
+// files to resultDir
+template<int LANES>
+int solveBatches(const fs::path& wparamsDir, const fs::path& resultDir, int config_id_min, int config_id_max,
+                 const SolverOptions& options)
+{
+    for(int first=config_id_min; first<=config_id_max; first+=LANES)
     {
-        wp = static_cast<Params*>(wparams_);
-
-        n_iter = wp->n_iter;
+        const int last = std::min(first+LANES-1, config_id_max);
 
-        x0 = wp->x0;
-        y0 = wp->y0;
-        z0 = wp->z0;
-
-        // Vectors holding the neurons' state
-        x = std::vector<double>(n_iter, 0.0);
-        y = std::vector<double>(n_iter, 0.0);
-        z = std::vector<double>(n_iter, 0.0);
+        std::vector<std::unique_ptr<Params>> params;
+        std::vector<Params*> wps;
+        std::vector<std::string> filenames;
+        for(int id=first; id<=last; id++)
+        {
+            std::ostringstream oss_params, oss_result;
+            oss_params << "wparams_config-" << std::setw(7) << std::setfill('0') << id << ".txt";
+            oss_result << "time-evol_config-" << std::setw(7) << std::setfill('0') << id << trajectoryExtension(options.format);
 
-        x[0] = x0;
-        y[0] = y0;
-        z[0] = z0;
-    }
+            const bool from_spec = (wparamsDir.extension() == ".spec");
+            fs::path paramsPath = from_spec ? fs::path(wparamsDir.string() + "#" + std::to_string(id)) : wparamsDir / oss_params.str();
+            if(!from_spec && !fs::exists(paramsPath))
+            {
+                std::cerr << "ERROR " << paramsPath << " does not exist\n";
+                return 1;
+            }
+            params.push_back(std::make_unique<Params>(paramsPath));
+            if(params.back()->n_iter < 0) return 1; // not readable or not in the spec (reported by Params)
+            wps.push_back(params.back().get());
+            filenames.push_back(resultDir / oss_result.str());
+        }
 
-    void displayParams()
-    {
-        std::cout << wp->w11 << " " << wp->w12 << " " << wp->w13 << '\n';
-        std::cout << wp->w21 << " " << wp->w22 << " " << wp->w23 << '\n';
-        std::cout << wp->w31 << " " << wp->w32 << " " << wp->w33 << '\n';
-        std::cout << wp->nu << '\n';
-        std::cout << wp->n_iter << '\n';
+        std::cout << "batch " << first << "-" << last << '\n';
+        HopfieldBatch<LANES> batch(wps);
+        batch.output_format = options.format;
+        batch.async_output = options.async_output;
+        batch.first_step = options.firstStep(params[0]->n_iter);
+        batch.lod = options.lod;
+        batch.kernel_anchors = kernelAnchorInterval(options.kernel);
+        if(!batch.solve(filenames)) return 1;
     }
+    return 0;
+}
 
-    // Method that computes the states of all three neurons in n_iter steps, optionally saves all these states to file (saveToFile=true)
-    // and returns a tuple holding three 1D vectors, one for each neuron x, y and z, that hold full information about system's evolution
-    void solve(const std::string& filename="")
+int main(int argc, char* argv[])
+{
+    // time-evol --calibrate[=N1,N2,...] [--engine-threads=T]: tuning profile of this machine for --engine=auto, timed
+    // at n_iter N1, N2, ... (default 10000, 40000, 160000) with up to T threads (default: the CPUs of this process)
+    if(argc >= 2 && std::string(argv[1]).rfind("--calibrate", 0) == 0)
     {
-        // Creating file for results and writing initial state of the system (n=0)
-        std::ofstream file(filename);
-        if(!file)
+        std::vector<int> n_iters {10000, 40000, 160000};
+        const std::string arg = argv[1];
+        if(arg.rfind("--calibrate=", 0) == 0)
         {
-            std::cerr << "ERROR opening " << filename << '\n';
-            return;
-        }
-        file << "n,x,y,z\n";
-        file << 0 << "," << std::fixed << std::setprecision(9) << x[0] << "," << y[0] << "," << z[0] << '\n';
-
-        // calculating value of gamma function for given 'nu'
-        double gammanu = gsl_sf_gamma(wp->nu);
-
-        // Creating variables/objects used for caching repetetive values to avoid ------------------------------------------------------
-        // unnecessary computations
-        
-        /* Since computing gamma functions of large values leads to numeric overflow I will use a trick:
-        * Instead of calculating gamma(a)/gamma(b), where a=n-j+nu, b=n-j+1, one can calculate a natural logarithm of this
-        * fraction using gsl_sf_lngamma: alpha = ln( gamma(a) / gamma(b)) = ln( gamma(a) ) - ln( gamma(b) )
-        * Once the alpha is calculated (which is not supposed to be an enormous number) we can simply exponentiate it 
-        * and get the final result used for further calculations:
-        *
-        * gammafrac = std::exp(alpha) */
-        std::vector<double> gammafrac_cache(n_iter, 0.0);
-        for(int j=1; j<n_iter; j++) {
-            const int n_max = n_iter - 1; // must substract one cuz 'n' is always less than 'n_iter' (look at nested for loops below)
-            
-            double alpha {0.0};
-            alpha = gsl_sf_lngamma(n_max-j+wp->nu) - gsl_sf_lngamma(n_max-j+1);
-            gammafrac_cache[n_max-j] = std::exp(alpha);
+            n_iters.clear();
+            std::istringstream iss(arg.substr(12));
+            std::string value;
+            while(std::getline(iss, value, ',')) n_iters.push_back(std::stoi(value));
         }
-        std::cout << "gammafrac_cache vector created...\n";
-
-        /* Vectors initialized right below are used to store results of repetitive calculations of this kind:
-            for(int n=1; n<n_iter; n++)    
-                for(int j=1; j<n; j++) {
-                    xnsum += gammafrac * (
-                        -x[j-1] +                       |
-                        wp->w11*std::tanh(x[j-1]) +     |~~~> this is what's getting stored in xjsum_cache[j-1]
-                        wp->w12*std::tanh(y[j-1]) +     |
-                        wp->w13*std::tanh(z[j-1])       |
-                    );
-                }
-        */
-        std::vector<double> xjsum_cache(n_iter, 0.0);
-        std::vector<double> yjsum_cache(n_iter, 0.0);
-        std::vector<double> zjsum_cache(n_iter, 0.0);
-
-        xjsum_cache[0] = -x[0] +
-                    wp->w11*std::tanh(x[0]) +
-                    wp->w12*std::tanh(y[0]) +
-                    wp->w13*std::tanh(z[0]);
-
-        yjsum_cache[0] = -y[0] +
-                    wp->w21*std::tanh(x[0]) +
-                    wp->w22*std::tanh(y[0]) +
-                    wp->w23*std::tanh(z[0]);
-
-        zjsum_cache[0] = -z[0] +
-                    wp->w31*std::tanh(x[0]) +
-                    wp->w32*std::tanh(y[0]) +
-                    wp->w33*std::tanh(z[0]);
-
-        for(int n=1; n<n_iter; n++)
+        int max_threads = availableCpus();
+        for(int i=2; i<argc; i++)
         {
-            double xnsum {0};
-            double ynsum {0};
-            double znsum {0};
-
-            for(int j=1; j<=n; j++)
-            {   
-                xnsum += gammafrac_cache[n-j] * xjsum_cache[j-1];
-
-                ynsum += gammafrac_cache[n-j] * yjsum_cache[j-1];
-
-                znsum += gammafrac_cache[n-j] * zjsum_cache[j-1];
+            const std::string option = argv[i];
+            if(option.rfind("--engine-threads=", 0) == 0) max_threads = std::stoi(option.substr(17));
+            else
+            {
+                std::cerr << "ERROR unknown argument " << option << '\n';
+                return 1;
             }
+        }
+        return calibrate(n_iters, std::max(1, max_threads));
+    }
 
-            // Caclulating the next step and writing it to the file
-            x[n] = x[0] + xnsum / gammanu;
-            y[n] = y[0] + ynsum / gammanu;
-            z[n] = z[0] + znsum / gammanu;
-            file << n << "," << std::fixed << std::setprecision(9) << x[n] << "," << y[n] << "," << z[n] << '\n';
-
-            xjsum_cache[n] = -x[n] +
-                    wp->w11*std::tanh(x[n]) +
-                    wp->w12*std::tanh(y[n]) +
-                    wp->w13*std::tanh(z[n]);
+    // Phase timers of the run start here (see telemetry.hpp); --perf-counters is looked for first so that the counters
+    // cover the whole process
+    bool perf_counters = false;
+    for(int i=3; i<argc; i++) if(std::string(argv[i]) == "--perf-counters") perf_counters = true;
+    RunTelemetry telemetry(perf_counters);
 
-            yjsum_cache[n] = -y[n] +
-                    wp->w21*std::tanh(x[n]) +
-                    wp->w22*std::tanh(y[n]) +
-                    wp->w23*std::tanh(z[n]);
+    fs::path paramsPath = argv[1];
+    fs::path resultPath = argv[2]; 
 
-            zjsum_cache[n] = -z[n] +
-                    wp->w31*std::tanh(x[n]) +
-                    wp->w32*std::tanh(y[n]) +
-                    wp->w33*std::tanh(z[n]);
+    // The params path is a wparams_config-XXXXXXX.txt file or "<sweep spec>#<config ID>" for a range generated with
+    // gen_params --spec (see sweep_spec.hpp)
+    //
+    // Optional arguments (after the two paths):
+    //  --engine=<name>    convolution engine: 'cached' (default, O(n_iter^2)), 'fft' (O(n_iter log^2 n_iter))
+    //                     'soe' (sum-of-exponentials kernel, O(n_iter), 0 < nu < 1 only),
+    //                     'short' (kernel truncated to the last L lags, O(L) memory and O(L) per step)
+    //                     'tiled' (same result as 'cached', cache-blocked for large n_iter)
+    //                     'threaded' ('tiled' with one trajectory spread over several cores)
+    //                     or 'naive' (reference only: the defining sum with gsl_sf_lngamma evaluated in the inner loop,
+    //                     what perf_time-evol used to run; see HopfieldNetwork::engines for the list)
+    //                     or 'auto' (the fastest of cached/tiled/threaded/fft for this n_iter according to the tuning
+    //                     profile of the machine, written by 'time-evol --calibrate', see engine_tuning.hpp; with
+    //                     --engine-threads=T the choice uses at most T threads)
+    //  --soe-tol=<tol>    target accuracy of the 'soe' kernel approximation (default 1e-10)
+    //  --memory-length=L  number of lags kept by the 'short' engine (default 10000)
+    //  --block-size=B     steps per history/local block of the 'tiled'/'threaded' engines (default 2048)
+    //  --engine-threads=T threads of the 'threaded' engine (default: all hardware threads; with 'auto': the CPUs of
+    //                     this process)
+    //  --simd=<isa>       memory sum kernel of the 'cached' engine: 'auto' (default, widest one the CPU supports),
+    //                     'avx512', 'avx2', 'sse2' or 'scalar' (original summation order; bit-compatible with older
+    //                     results together with --kernel=lngamma)
+    //  --kernel=<method>  how the memory kernel is built: 'recurrence' (default, ratio recurrence re-anchored every 256
+    //                     entries) or 'lngamma' (every entry from lngamma, the kernel of older results; see kernel_cache.hpp)
+    //  --format=<fmt>     output file format: 'csv' (default), 'bin' (binary float64 columns, see trajectory_io.hpp and
+    //                     hopfield_io.py) or 'bin32' (float32 columns)
+    //  --sync-output      write the output file on the solver thread instead of a separate writer thread
+    //  --tail=K           write only the last K steps (e.g. N_ITER_LAST for bifurcation diagrams)
+    //  --transient=N      write only the steps n >= N (combined with --tail the later of the two cutoffs applies)
+    //  --lod              also write <output file>.lod, a min/max/mean pyramid for plotting long runs (see
+    //                     LodPyramidWriter in trajectory_io.hpp and hopfield_io.load_lod)
+    //  --checkpoint=S     every S seconds append the steps computed since the last checkpoint to <output file>.ckpt
+    //                     (also on SIGUSR1 and SIGTERM, see checkpoint.hpp); the file is removed when the run completes
+    //  --resume           continue from <output file>.ckpt if it exists (checkpoints go on every --checkpoint seconds,
+    //                     600 by default); the output file is rewritten and ends up identical to an uninterrupted run
+    //  --continue[=FILE]  extend an existing trajectory (default: the output file itself, which is rewritten) to n_iter
+    //                     steps: its steps are read back (CSV or binary), the engine state is rebuilt from them and
+    //                     only the missing steps are computed; from binary float64 the cached/tiled/threaded/short
+    //                     engines continue bit-exactly, fft and soe only to rounding (their block layout and
+    //                     exponential fit depend on n_iter)
+    //  --n-iter=N         overrides n_iter of the params file (e.g. with --continue after raising N_ITER)
+    //  --heartbeat[=S]    every S seconds (default 60) and at every phase change rewrite <output file>.heartbeat with
+    //                     the phase, current step, steps/s and projected completion time (see telemetry.hpp)
+    //  --summary[=FILE]   at exit write a JSON summary (status, phase times, steps/s, counters) to FILE (default
+    //                     <output file>.summary.json), also when the job is stopped by SIGTERM
+    //  --perf-counters    count cycles, instructions and LLC misses with perf_event_open (printed and in the summary)
+    //  --batch=MIN-MAX    batched mode: the two paths are directories (wparams/<name>/, or a sweep spec file, and
+    //                     time-evol/<name>/), configs MIN..MAX are solved --lanes at a time with the SIMD batched
+    //                     solver (HopfieldBatch; same results as --engine=cached --simd=scalar, the engine options
+    //                     are rejected)
+    //  --lanes=<4|8>      number of configurations advanced together in batched mode (default 4)
+    SolverOptions options;
+    int batch_min = -1, batch_max = -1;
+    int lanes = 4;
+    for(int i=3; i<argc; i++)
+    {
+        std::string arg = argv[i];
+        if(options.parse(arg)) continue;
+        else if(arg.rfind("--batch=", 0) == 0)
+        {
+            std::string range = arg.substr(8);
+            batch_min = std::stoi(range.substr(0, range.find('-')));
+            batch_max = std::stoi(range.substr(range.find('-')+1));
+        }
+        else if(arg.rfind("--lanes=", 0) == 0) lanes = std::stoi(arg.substr(8));
+        else if(arg == "--perf-counters") continue;
+        else if(arg == "--heartbeat") telemetry.heartbeat_path = resultPath.string() + ".heartbeat";
+        else if(arg.rfind("--heartbeat=", 0) == 0)
+        {
+            telemetry.heartbeat_path = resultPath.string() + ".heartbeat";
+            telemetry.heartbeat_interval = std::stod(arg.substr(12));
+        }
+        else if(arg == "--summary") telemetry.summary_path = resultPath.string() + ".summary.json";
+        else if(arg.rfind("--summary=", 0) == 0) telemetry.summary_path = arg.substr(10);
+        else
+        {
+            std::cerr << "ERROR unknown argument " << arg << '\n';
+            return 1;
         }
-        file.close();
-        
-        return;
     }
 
-/*
-    void bifurcation(std::ofstream& filex, std::ofstream& filey, std::ofstream& filez)
+    if(batch_min >= 0)
     {
-        int nstepsLast {100}; // number of steps to save (counted from the end of neuron's evolution vector)
-        std::vector<double> xb(nstepsLast, 0), yb(nstepsLast, 0), zb(nstepsLast, 0); // vectors holding last nstepsLast steps of neurons' evolution
-
-        auto [x, y, z] = solve(n_iter);
-
-        for(int i=0; i<nstepsLast; ++i)
+        if(!validTrajectoryFormat(options.format))
         {
-            int indx = n_iter-1-i;
-
-            xb[i] = x[indx];
-            yb[i] = y[indx];
-            zb[i] = z[indx];
-
-            filex << "," << xb[i];
-            filey << "," << yb[i];
-            filez << "," << zb[i];
+            std::cerr << "ERROR unknown output format " << options.format << '\n';
+            return 1;
+        }
+        if(kernelAnchorInterval(options.kernel) == 0)
+        {
+            std::cerr << "ERROR unknown kernel method " << options.kernel << " (use 'recurrence' or 'lngamma')\n";
+            return 1;
+        }
+        if(options.checkpoint > 0 || options.resume || options.continue_run || options.n_iter > 0
+           || !telemetry.heartbeat_path.empty() || !telemetry.summary_path.empty())
+        {
+            std::cerr << "ERROR --checkpoint/--resume/--continue/--n-iter/--heartbeat/--summary are not supported in batched mode\n";
+            return 1;
+        }
+        // Every lane runs the 'cached' engine in the scalar summation order, the settings of the other engines would be
+        // ignored
+        const SolverOptions defaults;
+        if(options.engine != defaults.engine || (options.simd != defaults.simd && options.simd != "scalar")
+           || options.soe_tol != defaults.soe_tol || options.memory_length != defaults.memory_length
+           || options.block_size != defaults.block_size || options.engine_threads != defaults.engine_threads)
+        {
+            std::cerr << "ERROR batched mode always solves like --engine=cached --simd=scalar, --engine/--simd/--soe-tol/"
+                         "--memory-length/--block-size/--engine-threads are not supported there\n";
+            return 1;
         }
-        filex << '\n';
-        filey << '\n';
-        filez << '\n';
+        if(lanes == 4) return solveBatches<4>(paramsPath, resultPath, batch_min, batch_max, options);
+        if(lanes == 8) return solveBatches<8>(paramsPath, resultPath, batch_min, batch_max, options);
+        std::cerr << "ERROR --lanes must be 4 or 8\n";
+        return 1;
     }
-*/
-    // THIS FEATURE IS NOT USED CURRENTLY!!!!
-    // Overloading operator: H1->H2 means that H1 (transmitter) sends synchronisation signal to H2 (receiver) which results in
-    // synchronisation of these two Hopfield networks
-    // void operator*(HopfieldNetwork& other) // here other is the receiver that is to be synchronised with the transmitter
-    // {
-    //     int nstepsChaos {50}; // number of steps to take in two networks befor synchronisation begins
-    //     int nstepsSynchro {2000}; // number of steps that will be used for synchronisation
-
-    //     auto [xtemp, ytemp, ztemp] = solve(nstepsChaos);
-    //     auto [xslavetemp, yslavetemp, zslavetemp] = other.solve(nstepsChaos);
-
-    //     std::ofstream fileTransmitter("transmitter.csv");
-    //     std::ofstream fileReceiver("receiver.csv");
-    //     std::ofstream fileSynchroError("synchroError.csv");
-
-    //     fileTransmitter << "n,x,y,z\n";
-    //     fileReceiver << "n,x,y,z\n";
-    //     fileSynchroError << "n,ex,ey,ez\n";
-
-    //     x[0] = x[nstepsChaos-1];
-    //     y[0] = y[nstepsChaos-1];
-    //     z[0] = z[nstepsChaos-1];
-
-    //     double gammanu = gsl_sf_gamma(wp->nu);
-
-    //     for(int n=1; n<nstepsSynchro; n++)
-    //     {
-    //         double xnsum {0};
-    //         double ynsum {0};
-    //         double znsum {0};
 
-    //         // other.x, other.y and other.z are equivalent to xslave, yslave, zslave
-    //         double xslavensum {0};
-    //         double yslavensum {0};
-    //         double zslavensum {0};
-
-    //         // Synchronisation errors
-    //         double ex {};
-    //         double ey {};
-    //         double ez {};
-
-    //         double k_safety = 1; // k_safety is to ensure that -1 < max{k_i} < 2^{nu} - 1
-
-    //         // k1 = kx, k2 = ky, k3 = kz
-    //         double k1 = 0.6311; // {std::pow(2, wp->nu) - 1 - k_safety}; 
-    //         double k2 = 0.6311; // {std::pow(2, wp->nu) - 1 - k_safety}; 
-    //         double k3 = 0.6311; // {std::pow(2, wp->nu) - 1 - k_safety}; 
-
-    //         for(int j=1; j<=n; j++)
-    //         {
-    //             /* Computing gammafrac in the same way as in solve() method */
-    //             double alpha = gsl_sf_lngamma(n-j+wp->nu) - gsl_sf_lngamma(n-j+1);
-    //             double gammafrac = std::exp(alpha);
-
-    //             // Computing x and xslave state - synchronising -----------------------------------
-    //             xnsum += gammafrac * (
-    //                 -x[j-1] +
-    //                 wp->w11*std::tanh(x[j-1]) +
-    //                 wp->w12*std::tanh(y[j-1]) +
-    //                 wp->w13*std::tanh(z[j-1])
-    //             );
-
-    //             // IF x state is NOT being sent
-    //             // xslavensum += gammafrac * (
-    //             //     -other.x[j-1] +
-    //             //     wp->w11*std::tanh(other.x[j-1]) +
-    //             //     wp->w12*std::tanh(other.y[j-1]) +
-    //             //     wp->w13*std::tanh(other.z[j-1])
-    //             // );
-
-    //             // IF x state is being sent:
-    //             xslavensum += gammafrac * (
-    //                 -other.x[j-1] +
-    //                 wp->w11*std::tanh(other.x[j-1]) +
-    //                 wp->w12*std::tanh(other.y[j-1]) +
-    //                 wp->w13*std::tanh(other.z[j-1]) -
-    //                 wp->w11*( std::tanh(other.x[j-1]) - std::tanh(x[j-1]) ) -
-    //                 wp->w12*( std::tanh(other.y[j-1]) - std::tanh(y[j-1]) ) -
-    //                 wp->w13*( std::tanh(other.z[j-1]) - std::tanh(z[j-1]) ) -
-    //                 k1*( other.x[j-1] - x[j-1] )
-    //             );
-
-    //             // Computing y and yslave state - synchronising -----------------------------------
-    //             ynsum += gammafrac * (
-    //                 -y[j-1] +
-    //                 wp->w21*std::tanh(x[j-1]) +
-    //                 wp->w22*std::tanh(y[j-1]) +
-    //                 wp->w23*std::tanh(z[j-1])
-    //             );
-
-    //             // IF y state is NOT being sent:
-    //             yslavensum += gammafrac * (
-    //                 -other.y[j-1] +
-    //                 wp->w21*std::tanh(other.x[j-1]) +
-    //                 wp->w22*std::tanh(other.y[j-1]) +
-    //                 wp->w23*std::tanh(other.z[j-1])
-    //             );
-
-    //             // IF y state is being sent:
-    //             // yslavensum += gammafrac * (
-    //             //     -other.y[j-1] +
-    //             //     wp->w21*std::tanh(other.x[j-1]) +
-    //             //     wp->w22*std::tanh(other.y[j-1]) +
-    //             //     wp->w23*std::tanh(other.z[j-1]) -
-    //             //     wp->w21*( std::tanh(other.x[j-1]) - std::tanh(x[j-1]) ) -
-    //             //     wp->w22*( std::tanh(other.y[j-1]) - std::tanh(y[j-1]) ) -
-    //             //     wp->w23*( std::tanh(other.z[j-1]) - std::tanh(z[j-1]) ) -
-    //             //     k2*( other.y[j-1] - y[j-1] )
-    //             // );
-
-    //             // Computing z and zslave state - synchronising -----------------------------------
-    //             znsum += gammafrac * (
-    //                 -z[j-1] +
-    //                 wp->w31*std::tanh(x[j-1]) +
-    //                 wp->w32*std::tanh(y[j-1]) +
-    //                 wp->w33*std::tanh(z[j-1])
-    //             );
-
-    //             // IF z state is NOT being sent:
-    //             zslavensum += gammafrac * (
-    //                 -other.z[j-1] +
-    //                 wp->w31*std::tanh(other.x[j-1]) +
-    //                 wp->w32*std::tanh(other.y[j-1]) +
-    //                 wp->w33*std::tanh(other.z[j-1])
-    //             );
-
-    //             // IF z state is being sent:
-    //             // zslavensum += gammafrac * (
-    //             //     -other.z[j-1] +
-    //             //     wp->w31*std::tanh(other.x[j-1]) +
-    //             //     wp->w32*std::tanh(other.y[j-1]) +
-    //             //     wp->w33*std::tanh(other.z[j-1]) -
-    //             //     wp->w31*( std::tanh(other.x[j-1]) - std::tanh(x[j-1]) ) -
-    //             //     wp->w32*( std::tanh(other.y[j-1]) - std::tanh(y[j-1]) ) -
-    //             //     wp->w33*( std::tanh(other.z[j-1]) - std::tanh(z[j-1]) ) -
-    //             //     k3*( other.z[j-1] - z[j-1] )
-    //             // );
-    //         }
-
-    //         x[n] = x[0] + xnsum / gammanu;
-    //         y[n] = y[0] + ynsum / gammanu;
-    //         z[n] = z[0] + znsum / gammanu;
-
-    //         other.x[n] = other.x[0] + xslavensum / gammanu;
-    //         other.y[n] = other.y[0] + yslavensum / gammanu;
-    //         other.z[n] = other.z[0] + zslavensum / gammanu;
-
-    //         ex = other.x[n] - x[n];
-    //         ey = other.y[n] - y[n];
-    //         ez = other.z[n] - z[n];
-
-    //         fileTransmitter << n << ',' << x[n] << ',' << y[n] << ',' << z[n] << '\n';
-    //         fileReceiver << n << ',' << other.x[n] << ',' << other.y[n] << ',' << other.z[n] << '\n';
-    //         fileSynchroError << n << ',' << ex << ',' << ey << ',' << ez << '\n';
-    //     }
-
-    //     fileTransmitter.close();
-    //     fileReceiver.close();
-    //     fileSynchroError.close();
-    // }
-
-};
-
-int main(int argc, char* argv[])
-{
-    fs::path paramsPath = argv[1];
-    fs::path resultPath = argv[2]; 
+    if(!telemetry.summary_path.empty()) telemetry.catchTermination();
 
     Params wparams(paramsPath);
+    if(wparams.n_iter < 0)
+    {
+        telemetry.finish("failed");
+        return 1;
+    }
 
     HopfieldNetwork H(&wparams);
-    H.solve(resultPath);
+    H.telemetry = &telemetry;
+    const bool ok = H.run(options, resultPath) && telemetry.complete();
+    telemetry.finish(ok ? "completed" : "failed", H.verbose);
 
-    return 0;
+    return ok ? 0 : 1;
 }
@@ -0,0 +1,784 @@
+#pragma once
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <cstdint>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <memory>
+#include <charconv>
+#include <chrono>
+
+#include "thread_pool.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "the binary trajectory format is written in host byte order, which must be little-endian"
+#endif
+
+/*
+ * Output of one time evolution. Engines hand over the states row by row (n = 0, 1, 2, ... in order) and do not care
+ * about the file format:
+ *
+ *  - 'csv':   the original text format, header "n,x,y,z" and one line per step with 9 decimal places
+ *  - 'bin':   binary columnar file with float64 columns (see BinaryTrajectoryWriter), ~45% smaller than the CSV
+ *  - 'bin32': float32 columns, ~70% smaller (~7 significant digits instead of the 9 decimal places of the CSV)
+ *
+ * The binary files are meant to be read with np.memmap (see hopfield_io.py), no parsing involved.
+ */
+class TrajectoryWriter
+{
+public:
+    virtual ~TrajectoryWriter() = default;
+    virtual void write(int n, double x, double y, double z) = 0;
+    virtual void close() = 0;
+};
+
+// Parameters stored in the header of a binary trajectory file. Only the steps n_first..n_iter-1 are written to the file
+// (tail mode, see SolverOptions::firstStep), n_first = 0 is the whole trajectory.
+struct TrajectoryInfo
+{
+    double nu;
+    double x0, y0, z0;
+    double w[9];
+    std::int64_t n_iter;
+    std::int64_t n_first;
+};
+
+// Works with any parameter struct exposing nu, x0..z0 and w11..w33 (Params in hopfield.hpp)
+template<typename P>
+TrajectoryInfo trajectoryInfo(const P& p, int n_iter, int n_first=0)
+{
+    return {p.nu, p.x0, p.y0, p.z0, {p.w11, p.w12, p.w13, p.w21, p.w22, p.w23, p.w31, p.w32, p.w33}, n_iter, n_first};
+}
+
+// Writes all 'length' bytes at 'offset' of fd (pwrite may write less than asked for), false on an error
+inline bool pwriteAll(int fd, const void* data, size_t length, std::int64_t offset)
+{
+    const char* p = (const char*)data;
+    while(length > 0)
+    {
+        const ssize_t written = pwrite(fd, p, length, offset);
+        if(written <= 0) return false;
+        p += written;
+        length -= written;
+        offset += written;
+    }
+    return true;
+}
+
+/*
+ * CSV writer producing exactly the bytes of
+ *
+ *      file << n << "," << std::fixed << std::setprecision(9) << x << "," << y << "," << z << '\n';
+ *
+ * but formatting with std::to_chars (fixed, precision 9 rounds like printf("%.9f"), -0, inf and nan included) into a
+ * preallocated buffer that goes to the file in write() calls of buffer_size bytes, without any iostream on the way.
+ */
+class CsvTrajectoryWriter : public TrajectoryWriter
+{
+public:
+    static constexpr size_t buffer_size = 1 << 20;
+    static constexpr size_t max_row_size = 1024; // 3 fixed-format doubles of at most 309+1+9+1 characters, n and separators
+
+private:
+    int fd {-1};
+    std::vector<char> buffer;
+    size_t used {0};
+
+    void flush()
+    {
+        const char* data = buffer.data();
+        size_t length = used;
+        while(length > 0)
+        {
+            const ssize_t written = ::write(fd, data, length);
+            if(written <= 0)
+            {
+                std::cerr << "ERROR writing CSV trajectory\n";
+                break;
+            }
+            data += written;
+            length -= written;
+        }
+        used = 0;
+    }
+
+    void append(const char* text)
+    {
+        const size_t length = std::strlen(text);
+        std::memcpy(buffer.data() + used, text, length);
+        used += length;
+    }
+
+public:
+    explicit CsvTrajectoryWriter(const std::string& filename) : buffer(buffer_size)
+    {
+        unlink(filename.c_str()); // a new file, never overwrite the target of a link (sweep --cache)
+        fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(fd >= 0) append("n,x,y,z\n");
+    }
+
+    ~CsvTrajectoryWriter() override {close();}
+
+    bool is_open() const {return fd >= 0;}
+
+    void write(int n, double x, double y, double z) override
+    {
+        if(buffer_size - used < max_row_size) flush();
+
+        char* p = buffer.data() + used;
+        char* const end = buffer.data() + buffer_size;
+        p = std::to_chars(p, end, n).ptr;
+        *p++ = ',';
+        p = std::to_chars(p, end, x, std::chars_format::fixed, 9).ptr;
+        *p++ = ',';
+        p = std::to_chars(p, end, y, std::chars_format::fixed, 9).ptr;
+        *p++ = ',';
+        p = std::to_chars(p, end, z, std::chars_format::fixed, 9).ptr;
+        *p++ = '\n';
+        used = p - buffer.data();
+    }
+
+    void close() override
+    {
+        if(fd < 0) return;
+        flush();
+        ::close(fd);
+        fd = -1;
+    }
+};
+
+/*
+ * Binary columnar trajectory (all little-endian):
+ *
+ *      offset   0  char[8]     magic "HFTRAJ01"
+ *               8  uint32      header size in bytes (128, or 136 for a tail file; the x column starts here)
+ *              12  uint32      bytes per value (8: float64, 4: float32)
+ *              16  int64       number of rows n_rows
+ *              24  float64     nu
+ *              32  float64[3]  x0, y0, z0
+ *              56  float64[9]  w11, w12, w13, w21, ..., w33
+ *            (128  int64       n_first, step of the first row, only present if the header size is 136)
+ *         header  x[0..n_rows-1], then y[0..n_rows-1], then z[0..n_rows-1]
+ *
+ * Row k holds step n_first + k, n_first is 0 (and the header 128 bytes) unless only the tail of the run was kept.
+ *
+ * The file is sized for all n_iter rows up front and every column is written in chunks of chunk_rows values with
+ * pwrite at its final offset. If fewer rows arrive (the run was interrupted), close() shrinks the row count in the
+ * header and moves the y/z columns so that the file is still consistent.
+ */
+class BinaryTrajectoryWriter : public TrajectoryWriter
+{
+public:
+    static constexpr int chunk_rows = 8192;
+
+private:
+    int fd {-1};
+    std::uint32_t header_size;
+    std::uint32_t value_size;
+    std::int64_t n_iter;            // rows the file is sized for
+    std::int64_t n_written {0};     // rows already flushed to the file
+    std::int64_t n_rows {0};        // rows received so far
+    std::vector<char> chunk[3];     // pending values of the x, y and z columns
+
+    void flush()
+    {
+        const std::int64_t n_pending = n_rows - n_written;
+        if(n_pending == 0) return;
+
+        for(int c=0; c<3; c++)
+        {
+            const std::int64_t offset = header_size + (c*n_iter + n_written) * value_size;
+            if(!pwriteAll(fd, chunk[c].data(), n_pending * value_size, offset))
+                std::cerr << "ERROR writing binary trajectory column " << "xyz"[c] << '\n';
+        }
+        n_written = n_rows;
+    }
+
+public:
+    BinaryTrajectoryWriter(const std::string& filename, const TrajectoryInfo& info, std::uint32_t value_size_)
+        : header_size(info.n_first > 0 ? 136 : 128), value_size(value_size_), n_iter(info.n_iter - info.n_first)
+    {
+        unlink(filename.c_str()); // a new file, never overwrite the target of a link (sweep --cache)
+        fd = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if(fd < 0) return;
+
+        char header[136] = {};
+        std::memcpy(header, "HFTRAJ01", 8);
+        std::memcpy(header + 8, &header_size, 4);
+        std::memcpy(header + 12, &value_size, 4);
+        std::memcpy(header + 16, &n_iter, 8);
+        std::memcpy(header + 24, &info.nu, 8);
+        std::memcpy(header + 32, &info.x0, 8);
+        std::memcpy(header + 40, &info.y0, 8);
+        std::memcpy(header + 48, &info.z0, 8);
+        std::memcpy(header + 56, info.w, 9*8);
+        std::memcpy(header + 128, &info.n_first, 8);
+
+        if(!pwriteAll(fd, header, header_size, 0) || ftruncate(fd, header_size + 3*n_iter*value_size) != 0)
+        {
+            ::close(fd);
+            fd = -1;
+            return;
+        }
+
+        for(int c=0; c<3; c++) chunk[c].resize((size_t)chunk_rows * value_size);
+    }
+
+    ~BinaryTrajectoryWriter() override {close();}
+
+    bool is_open() const {return fd >= 0;}
+
+    void write(int, double x, double y, double z) override
+    {
+        if(n_rows >= n_iter) return;
+
+        const double values[3] = {x, y, z};
+        const size_t k = (size_t)(n_rows - n_written) * value_size;
+        for(int c=0; c<3; c++)
+        {
+            if(value_size == 4)
+            {
+                const float value = (float)values[c];
+                std::memcpy(chunk[c].data() + k, &value, 4);
+            }
+            else std::memcpy(chunk[c].data() + k, &values[c], 8);
+        }
+
+        n_rows++;
+        if(n_rows - n_written == chunk_rows) flush();
+    }
+
+    void close() override
+    {
+        if(fd < 0) return;
+        flush();
+
+        // Interrupted run: compacting the columns to n_rows rows
+        if(n_rows < n_iter)
+        {
+            std::vector<char> column((size_t)n_rows * value_size);
+            for(int c=1; c<3; c++)
+            {
+                if(pread(fd, column.data(), column.size(), header_size + c*n_iter*value_size) != (ssize_t)column.size()
+                   || !pwriteAll(fd, column.data(), column.size(), header_size + c*n_rows*value_size))
+                    std::cerr << "ERROR compacting binary trajectory column " << "xyz"[c] << '\n';
+            }
+            pwriteAll(fd, (const char*)&n_rows, 8, 16);
+            if(ftruncate(fd, header_size + 3*n_rows*value_size) != 0)
+                std::cerr << "ERROR truncating binary trajectory\n";
+        }
+
+        ::close(fd);
+        fd = -1;
+    }
+};
+
+/*
+ * Level-of-detail sidecar ('<output file>.lod') for plotting long runs: per bucket of steps the min, max and
+ * mean of x, y and z, on several levels of bucket size, so that a plot of any range at screen resolution reads a few
+ * thousand records instead of the whole trajectory (see hopfield_io.load_lod). All little-endian:
+ *
+ *      offset   0  char[8]     magic "HFLOD001"
+ *               8  uint32      header size in bytes (64)
+ *              12  uint32      number of levels
+ *              16  int64       n_first, step of the first row
+ *              24  int64       n_rows
+ *              32  int64       steps per bucket on level 0 (lod_base_bucket)
+ *              40  int64       factor between the bucket sizes of consecutive levels (lod_level_factor)
+ *              64  level table, per level: int64 bucket size, int64 number of buckets, int64 offset of its records
+ *                  records, per bucket: float64 x_min, x_max, x_mean, y_min, y_max, y_mean, z_min, z_max, z_mean
+ *
+ * Bucket k of a level covers the rows k*size..(k+1)*size-1 (the last one may be shorter), the top level has a single
+ * bucket. Level 0 is accumulated row by row while the rows pass through, the coarser levels are reduced from it on
+ * close(); all levels together are about 6 bytes per step with the default sizes.
+ */
+constexpr std::int64_t lod_base_bucket = 16;
+constexpr std::int64_t lod_level_factor = 4;
+
+class LodPyramidWriter : public TrajectoryWriter
+{
+    std::unique_ptr<TrajectoryWriter> sink;
+    std::string path;
+    std::int64_t n_first;
+    std::int64_t n_rows {0};
+    bool closed {false};
+
+    // Level 0 bucket being accumulated: min, max and sum per neuron
+    double bucket_min[3], bucket_max[3], bucket_sum[3];
+    std::int64_t bucket_rows {0};
+
+    std::vector<std::vector<double>> levels {1}; // 9 values per bucket
+
+    static constexpr int record_size = 9;
+
+    void finishBucket()
+    {
+        std::vector<double>& level = levels[0];
+        for(int c=0; c<3; c++)
+        {
+            level.push_back(bucket_min[c]);
+            level.push_back(bucket_max[c]);
+            level.push_back(bucket_sum[c] / bucket_rows);
+        }
+        bucket_rows = 0;
+    }
+
+    // Merges groups of lod_level_factor buckets of the top level into a new level (means weighted by the rows covered)
+    void reduceLevel()
+    {
+        const std::vector<double>& fine = levels.back();
+        std::int64_t fine_size = lod_base_bucket;
+        for(size_t l=1; l<levels.size(); l++) fine_size *= lod_level_factor;
+        const std::int64_t n_fine = (std::int64_t)fine.size() / record_size;
+
+        std::vector<double> coarse;
+        for(std::int64_t first=0; first<n_fine; first+=lod_level_factor)
+        {
+            const std::int64_t last = std::min(first + lod_level_factor, n_fine);
+            for(int c=0; c<3; c++)
+            {
+                double v_min = fine[first*record_size + 3*c], v_max = fine[first*record_size + 3*c + 1], sum = 0.0;
+                std::int64_t rows = 0;
+                for(std::int64_t k=first; k<last; k++)
+                {
+                    const std::int64_t k_rows = std::min(fine_size, n_rows - k*fine_size);
+                    v_min = std::min(v_min, fine[k*record_size + 3*c]);
+                    v_max = std::max(v_max, fine[k*record_size + 3*c + 1]);
+                    sum += fine[k*record_size + 3*c + 2] * k_rows;
+                    rows += k_rows;
+                }
+                coarse.push_back(v_min);
+                coarse.push_back(v_max);
+                coarse.push_back(sum / rows);
+            }
+        }
+        levels.push_back(std::move(coarse));
+    }
+
+    bool writeFile()
+    {
+        while(levels.back().size() > (size_t)record_size) reduceLevel();
+
+        const std::uint32_t header_size = 64;
+        const std::uint32_t n_levels = (std::uint32_t)levels.size();
+        char header[header_size] = {};
+        std::memcpy(header, "HFLOD001", 8);
+        std::memcpy(header + 8, &header_size, 4);
+        std::memcpy(header + 12, &n_levels, 4);
+        std::memcpy(header + 16, &n_first, 8);
+        std::memcpy(header + 24, &n_rows, 8);
+        std::memcpy(header + 32, &lod_base_bucket, 8);
+        std::memcpy(header + 40, &lod_level_factor, 8);
+
+        std::vector<std::int64_t> table;
+        std::int64_t offset = header_size + 3 * 8 * (std::int64_t)n_levels;
+        std::int64_t bucket_size = lod_base_bucket;
+        for(const std::vector<double>& level : levels)
+        {
+            table.push_back(bucket_size);
+            table.push_back((std::int64_t)level.size() / record_size);
+            table.push_back(offset);
+            offset += (std::int64_t)(level.size() * sizeof(double));
+            bucket_size *= lod_level_factor;
+        }
+
+        unlink(path.c_str());
+        std::ofstream file(path, std::ios::binary);
+        file.write(header, header_size);
+        file.write((const char*)table.data(), (std::streamsize)(table.size() * sizeof(std::int64_t)));
+        for(const std::vector<double>& level : levels)
+            file.write((const char*)level.data(), (std::streamsize)(level.size() * sizeof(double)));
+        return (bool)file;
+    }
+
+public:
+    LodPyramidWriter(std::unique_ptr<TrajectoryWriter> sink_, const std::string& path_, std::int64_t n_first_)
+        : sink(std::move(sink_)), path(path_), n_first(n_first_) {}
+
+    ~LodPyramidWriter() override {close();}
+
+    void write(int n, double x, double y, double z) override
+    {
+        sink->write(n, x, y, z);
+
+        const double values[3] = {x, y, z};
+        if(bucket_rows == 0)
+        {
+            for(int c=0; c<3; c++) bucket_min[c] = bucket_max[c] = bucket_sum[c] = values[c];
+        }
+        else
+        {
+            for(int c=0; c<3; c++)
+            {
+                bucket_min[c] = std::min(bucket_min[c], values[c]);
+                bucket_max[c] = std::max(bucket_max[c], values[c]);
+                bucket_sum[c] += values[c];
+            }
+        }
+        bucket_rows++;
+        n_rows++;
+        if(bucket_rows == lod_base_bucket) finishBucket();
+    }
+
+    void close() override
+    {
+        if(closed) return;
+        closed = true;
+        sink->close();
+
+        if(bucket_rows > 0) finishBucket();
+        if(n_rows > 0 && !writeFile()) std::cerr << "ERROR writing level-of-detail file " << path << '\n';
+    }
+};
+
+/*
+ * Runs another writer ('sink') on a dedicated thread, so that neither formatting nor blocking file writes sit on the
+ * critical path of the solver. The solver fills chunks of chunk_rows steps and hands every full chunk over through a
+ * lock-free SPSC queue; the writer thread formats/writes it and returns the empty chunk through a second SPSC queue.
+ * With n_chunks buffers the solver only ever waits if the file system is slower than the solver for n_chunks chunks
+ * in a row. A side that has nothing to do spins briefly and then sleeps on a condition variable, so an idle writer
+ * thread does not take a core away from the solvers of a sweep.
+ */
+class AsyncTrajectoryWriter : public TrajectoryWriter
+{
+public:
+    static constexpr int chunk_rows = 4096;
+    static constexpr int n_chunks = 4;
+
+private:
+    struct Row
+    {
+        int n;
+        double x, y, z;
+    };
+
+    std::unique_ptr<TrajectoryWriter> sink;
+    std::vector<std::vector<Row>> chunks;
+    SpscQueue<int> full {2*n_chunks};  // solver -> writer thread (chunk index, -1 marks the end)
+    SpscQueue<int> empty {2*n_chunks}; // writer thread -> solver
+    int current {0};                   // chunk being filled by the solver
+    bool closed {false};
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::atomic<bool> sleeping {false};
+    std::thread thread;
+
+    // Pops from 'queue' into 'value', sleeping if nothing arrives for a while
+    void pop(SpscQueue<int>& queue, int& value)
+    {
+        for(int spin=0; spin<64; spin++)
+        {
+            if(queue.try_pop(value)) return;
+            std::this_thread::yield();
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        sleeping.store(true);
+        while(!queue.try_pop(value)) cv.wait_for(lock, std::chrono::milliseconds(1));
+        sleeping.store(false);
+    }
+
+    void push(SpscQueue<int>& queue, int value)
+    {
+        queue.try_push(value); // never full: there are only n_chunks chunks (plus the end marker) in flight
+        if(sleeping.load())
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            cv.notify_all();
+        }
+    }
+
+    void consume()
+    {
+        int chunk;
+        while(true)
+        {
+            pop(full, chunk);
+            if(chunk < 0) return;
+
+            for(const Row& row : chunks[chunk]) sink->write(row.n, row.x, row.y, row.z);
+            chunks[chunk].clear();
+            push(empty, chunk);
+        }
+    }
+
+public:
+    explicit AsyncTrajectoryWriter(std::unique_ptr<TrajectoryWriter> sink_) : sink(std::move(sink_)), chunks(n_chunks)
+    {
+        for(int c=0; c<n_chunks; c++) chunks[c].reserve(chunk_rows);
+        for(int c=1; c<n_chunks; c++) empty.try_push(c);
+        thread = std::thread(&AsyncTrajectoryWriter::consume, this);
+    }
+
+    ~AsyncTrajectoryWriter() override {close();}
+
+    void write(int n, double x, double y, double z) override
+    {
+        std::vector<Row>& chunk = chunks[current];
+        chunk.push_back({n, x, y, z});
+        if((int)chunk.size() == chunk_rows)
+        {
+            push(full, current);
+            pop(empty, current);
+        }
+    }
+
+    void close() override
+    {
+        if(closed) return;
+        closed = true;
+
+        if(!chunks[current].empty()) push(full, current);
+        push(full, -1);
+        thread.join();
+        sink->close();
+    }
+};
+
+// Passes on only the steps n >= n_first (tail mode), the rows before are dropped on the solver thread
+class TailTrajectoryWriter : public TrajectoryWriter
+{
+    std::unique_ptr<TrajectoryWriter> sink;
+    int n_first;
+
+public:
+    TailTrajectoryWriter(std::unique_ptr<TrajectoryWriter> sink_, int n_first_) : sink(std::move(sink_)), n_first(n_first_) {}
+
+    void write(int n, double x, double y, double z) override
+    {
+        if(n >= n_first) sink->write(n, x, y, z);
+    }
+
+    void close() override {sink->close();}
+};
+
+// Drops every step (timing the engines without any output: time-evol --calibrate, bench)
+class DiscardWriter : public TrajectoryWriter
+{
+public:
+    void write(int, double, double, double) override {}
+    void close() override {}
+};
+
+inline bool validTrajectoryFormat(const std::string& format)
+{
+    return format == "csv" || format == "bin" || format == "bin32";
+}
+
+// File extension used for 'format' when the file name is generated (sweep, batched mode)
+inline std::string trajectoryExtension(const std::string& format)
+{
+    return (format == "csv") ? ".csv" : ".bin";
+}
+
+// Opens 'filename' for writing in 'format', returns nullptr (after printing the error) if that fails. With 'async' the
+// file is written by a separate thread (AsyncTrajectoryWriter), with 'lod' the level-of-detail sidecar filename.lod is
+// built as well (LodPyramidWriter). Only the steps from info.n_first on end up in the files.
+inline std::unique_ptr<TrajectoryWriter> openTrajectoryWriter(const std::string& filename, const std::string& format,
+                                                              const TrajectoryInfo& info, bool async=true, bool lod=false)
+{
+    std::unique_ptr<TrajectoryWriter> writer;
+    if(format == "csv")
+    {
+        std::unique_ptr<CsvTrajectoryWriter> csv(new CsvTrajectoryWriter(filename));
+        if(csv->is_open()) writer = std::move(csv);
+    }
+    else if(format == "bin" || format == "bin32")
+    {
+        std::unique_ptr<BinaryTrajectoryWriter> bin(new BinaryTrajectoryWriter(filename, info, format == "bin" ? 8 : 4));
+        if(bin->is_open()) writer = std::move(bin);
+    }
+    else
+    {
+        std::cerr << "ERROR unknown output format " << format << '\n';
+        return nullptr;
+    }
+
+    if(!writer)
+    {
+        std::cerr << "ERROR opening " << filename << '\n';
+        return nullptr;
+    }
+    if(lod) writer.reset(new LodPyramidWriter(std::move(writer), filename + ".lod", info.n_first));
+    if(async) writer.reset(new AsyncTrajectoryWriter(std::move(writer)));
+    if(info.n_first > 0) writer.reset(new TailTrajectoryWriter(std::move(writer), (int)info.n_first));
+    return writer;
+}
+
+// Reads 'count' values of one binary column (float64 or float32) at 'offset' of fd into 'values'
+inline bool readBinaryColumn(int fd, std::int64_t offset, std::uint32_t value_size, std::int64_t count, std::vector<double>& values)
+{
+    std::vector<char> raw((size_t)(count * value_size));
+    if(pread(fd, raw.data(), raw.size(), offset) != (ssize_t)raw.size()) return false;
+
+    values.resize((size_t)count);
+    for(std::int64_t k=0; k<count; k++)
+    {
+        if(value_size == 4)
+        {
+            float value;
+            std::memcpy(&value, raw.data() + k*4, 4);
+            values[k] = value;
+        }
+        else std::memcpy(&values[k], raw.data() + k*8, 8);
+    }
+    return true;
+}
+
+/*
+ * Last n_last steps of a CSV or binary trajectory file (fewer if the file is shorter), without reading the rest of it:
+ * the binary columns are read with three preads, a CSV file is read backwards from its end in blocks until enough
+ * lines are found. Returns false if the file cannot be read.
+ */
+inline bool readTrajectoryTail(const std::string& path, std::int64_t n_last, std::vector<double>& x, std::vector<double>& y, std::vector<double>& z)
+{
+    const int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0) return false;
+
+    char magic[8] = {};
+    const bool binary = pread(fd, magic, 8, 0) == 8 && std::memcmp(magic, "HFTRAJ01", 8) == 0;
+    bool ok = true;
+    if(binary)
+    {
+        std::uint32_t header_size, value_size;
+        std::int64_t n_rows;
+        ok = pread(fd, &header_size, 4, 8) == 4 && pread(fd, &value_size, 4, 12) == 4 && pread(fd, &n_rows, 8, 16) == 8;
+        const std::int64_t count = std::min(n_last, n_rows);
+        std::vector<double>* columns[3] = {&x, &y, &z};
+        for(int c=0; c<3 && ok; c++)
+            ok = readBinaryColumn(fd, header_size + (c*n_rows + n_rows - count) * value_size, value_size, count, *columns[c]);
+    }
+    else
+    {
+        struct stat st;
+        ok = fstat(fd, &st) == 0;
+        std::int64_t start = ok ? st.st_size : 0;
+        std::string text;
+        std::int64_t n_lines = 0;
+        const std::int64_t block = 1 << 16;
+        while(ok && start > 0 && n_lines <= n_last)
+        {
+            const std::int64_t length = std::min(block, start);
+            start -= length;
+            std::string chunk((size_t)length, '\0');
+            ok = pread(fd, &chunk[0], (size_t)length, start) == (ssize_t)length;
+            n_lines += std::count(chunk.begin(), chunk.end(), '\n');
+            text.insert(0, chunk);
+        }
+
+        // Complete lines starting with a step number (the "n,x,y,z" header is skipped)
+        std::vector<const char*> lines;
+        size_t pos = (start == 0) ? 0 : text.find('\n') + 1; // the first line of the text may be cut off
+        while(pos < text.size())
+        {
+            const size_t end = std::min(text.find('\n', pos), text.size());
+            if(std::isdigit((unsigned char)text[pos])) lines.push_back(text.c_str() + pos);
+            pos = end + 1;
+        }
+        const size_t first = lines.size() > (size_t)n_last ? lines.size() - n_last : 0;
+        x.clear(); y.clear(); z.clear();
+        for(size_t k=first; k<lines.size(); k++)
+        {
+            char* p;
+            std::strtol(lines[k], &p, 10);
+            x.push_back(std::strtod(p + 1, &p));
+            y.push_back(std::strtod(p + 1, &p));
+            z.push_back(std::strtod(p + 1, &p));
+        }
+    }
+
+    ::close(fd);
+    return ok;
+}
+
+/*
+ * Whole trajectory of a CSV or binary file. For a binary file 'info' gets the parameters of its header (nu, x0..z0,
+ * w), its step count (n_iter) and first step (n_first) and value_size 8 or 4; a CSV file carries no parameters, so
+ * info.nu is NaN, n_first is the step of its first line and value_size is 0 (values rounded to the printed digits);
+ * an unterminated last line is left out.
+ * Returns false (after printing the error) if the file cannot be read.
+ */
+inline bool readTrajectory(const std::string& path, std::vector<double>& x, std::vector<double>& y, std::vector<double>& z,
+                           TrajectoryInfo& info, std::uint32_t& value_size)
+{
+    const int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+        std::cerr << "ERROR opening " << path << '\n';
+        return false;
+    }
+
+    info = {};
+    char header[136] = {};
+    bool ok = true;
+    if(pread(fd, header, 8, 0) == 8 && std::memcmp(header, "HFTRAJ01", 8) == 0)
+    {
+        std::uint32_t header_size;
+        std::int64_t n_rows;
+        ok = pread(fd, header, sizeof(header), 0) >= 128;
+        std::memcpy(&header_size, header + 8, 4);
+        std::memcpy(&value_size, header + 12, 4);
+        std::memcpy(&n_rows, header + 16, 8);
+        std::memcpy(&info.nu, header + 24, 8);
+        std::memcpy(&info.x0, header + 32, 8);
+        std::memcpy(&info.y0, header + 40, 8);
+        std::memcpy(&info.z0, header + 48, 8);
+        std::memcpy(info.w, header + 56, sizeof(info.w));
+        if(header_size >= 136) std::memcpy(&info.n_first, header + 128, 8);
+        info.n_iter = info.n_first + n_rows;
+
+        std::vector<double>* columns[3] = {&x, &y, &z};
+        for(int c=0; c<3 && ok; c++) ok = readBinaryColumn(fd, header_size + c*n_rows*value_size, value_size, n_rows, *columns[c]);
+    }
+    else
+    {
+        value_size = 0;
+        info.nu = std::nan("");
+        x.clear(); y.clear(); z.clear();
+
+        // Complete lines starting with a step number (the "n,x,y,z" header is skipped), read in blocks
+        std::string text;
+        std::vector<char> block(1 << 20);
+        std::int64_t offset = 0;
+        ssize_t length;
+        while((length = pread(fd, block.data(), block.size(), offset)) > 0)
+        {
+            offset += length;
+            text.append(block.data(), (size_t)length);
+
+            size_t pos = 0, end;
+            while((end = text.find('\n', pos)) != std::string::npos)
+            {
+                if(std::isdigit((unsigned char)text[pos]))
+                {
+                    char* p;
+                    const long n = std::strtol(text.c_str() + pos, &p, 10);
+                    if(x.empty()) info.n_first = n;
+                    x.push_back(std::strtod(p + 1, &p));
+                    y.push_back(std::strtod(p + 1, &p));
+                    z.push_back(std::strtod(p + 1, &p));
+                }
+                pos = end + 1;
+            }
+            text.erase(0, pos);
+        }
+        ok = length == 0; // an unterminated last line (run killed while writing) is left out
+        info.n_iter = info.n_first + (std::int64_t)x.size();
+    }
+
+    ::close(fd);
+    if(!ok) std::cerr << "ERROR reading trajectory " << path << '\n';
+    return ok;
+}
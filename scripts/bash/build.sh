@@ -0,0 +1,23 @@
+#!/bin/bash
+
+# Builds the C++ tools the scripts run (time-evol, sweep, gen_params, bifur_render, bench) in $SOURCE_CODE_DIR. The
+# binaries are not kept in the repository, so run this after every checkout/pull (on a login node of the cluster the
+# jobs run on) before submitting jobs; the job scripts refuse to run a missing or outdated binary (see check_build.sh).
+# No -march flags: the SIMD kernels are picked at run time (see simd_dot.hpp), and flags that enable FMA would change
+# the results of the exact engines (see HopfieldBatch in hopfield.hpp).
+
+# *** example of usage ***
+# bash build.sh                 all tools
+# bash build.sh time-evol sweep only these
+
+source "$PROJECT/CONFIG.sh"
+
+module load gcc/11.3.0 gsl/2.7-gcc-11.3.0
+
+TOOLS=${*:-"time-evol sweep gen_params bifur_render bench"}
+CXXFLAGS="-std=c++17 -O3 -Wall -pthread"
+
+for tool in $TOOLS; do
+    echo "building $tool"
+    g++ $CXXFLAGS "$SOURCE_CODE_DIR/$tool.cpp" -o "$SOURCE_CODE_DIR/$tool" -lgsl -lgslcblas || exit 1
+done
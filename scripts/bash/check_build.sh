@@ -0,0 +1,22 @@
+#!/bin/bash
+
+# Exits with an error if one of the given C++ tools in code/src is missing or older than any of the sources, so that no
+# job runs a binary that does not match the checked-out code. The tools are built with scripts/bash/build.sh.
+
+# *** example of usage ***
+# bash "$PROJECT/scripts/bash/check_build.sh" time-evol sweep || exit 1
+
+SOURCE_CODE_DIR="$PROJECT/code/src"
+
+for tool in "$@"; do
+    binary="$SOURCE_CODE_DIR/$tool"
+    if [[ ! -x "$binary" ]]; then
+        echo "error: $binary does not exist, build it with: bash $PROJECT/scripts/bash/build.sh" >&2
+        exit 1
+    fi
+    newer=$(find "$SOURCE_CODE_DIR" -maxdepth 1 \( -name '*.cpp' -o -name '*.hpp' \) -newer "$binary" -print -quit)
+    if [[ -n $newer ]]; then
+        echo "error: $binary is older than $newer, rebuild it with: bash $PROJECT/scripts/bash/build.sh" >&2
+        exit 1
+    fi
+done
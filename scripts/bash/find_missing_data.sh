@@ -1,9 +1,24 @@
 #!/bin/bash
 
-DATA_PATHS=($(seq -f "$PROJECT/data/time-evol/$3/time-evol_config-%07g.csv" $1 $2))
+# Lists the config IDs $1..$2 (control parameter $3) that have no time-evol output, neither as .csv nor as .bin
+# (written with --format=bin/bin32) nor as a finished entry of a sweep archive (sweep --archive) or of the result cache
+# (sweep --cache)
+
+DATA_DIR_TEVOL="$PROJECT/data/time-evol/$3"
+
+# With sweep archives or the result cache manifest the index tells which configs are done, so the lookup is left to
+# hopfield_io.py which reads each index once instead of checking every file
+if compgen -G "$DATA_DIR_TEVOL/archive_config-*.hfa" > /dev/null || [[ -f "$PROJECT/data/cache/manifest.txt" ]]; then
+    for config_id in $(python3 "$PROJECT/code/src/hopfield_io.py" missing "$DATA_DIR_TEVOL" $1 $2); do
+        printf "$DATA_DIR_TEVOL/time-evol_config-%07g.csv does not exist\n" $config_id
+    done
+    exit 0
+fi
+
+DATA_PATHS=($(seq -f "$DATA_DIR_TEVOL/time-evol_config-%07g" $1 $2))
 
 for file in "${DATA_PATHS[@]}"; do
-    if [[ ! -f $file ]]; then
-        echo "$file does not exist"
+    if [[ ! -f $file.csv && ! -f $file.bin ]]; then
+        echo "$file.csv does not exist"
     fi
-done
\ No newline at end of file
+done
@@ -89,6 +89,9 @@ if [[ -f $CONFIG_FILE_FOUND ]]; then
     echo "Values provided by the user: $config_id_min $config_id_max"
     echo "Values passed for further operations: $config_id_min_to_use $config_id_max_to_use"
 
+    if [[ $PLOT_BIFUR_NATIVE == "TRUE" ]]; then
+        bash "$PROJECT/scripts/bash/check_build.sh" bifur_render || exit 1
+    fi
     sbatch --time="$PLOT_BIFUR_TIME" "$PROJECT/scripts/slurm/plot_bifur.slurm" "$config_id_min_to_use" "$config_id_max_to_use" "$graphic_file_extension" "$CONFIG_FILE_FOUND"
 else
     echo "File $CONFIG_FILE_FOUND does not exist"
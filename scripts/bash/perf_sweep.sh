@@ -0,0 +1,25 @@
+#!/bin/bash
+
+# Solves configurations <config_id_min>..<config_id_max> with one SLURM array task per shard instead of one job per
+# config ID (compare perf_time-evol.sh). Each shard runs on a whole node with the work-stealing sweep runner.
+
+# *** example of usage ***
+# bash perf_sweep.sh 3000 3999 4 48 --engine=fft
+#   4 array tasks, each solving 250 configs on 48 cores
+# bash perf_sweep.sh 3000 3999 4 48 --bifur
+#   same, but only the last N_ITER_LAST steps of every config are kept, in one bifur_config-XXXXXXX-YYYYYYY.csv per
+#   shard (data/bifur/<CONTROL_PARAM_NAME>/) that plot_bifur.slurm picks up instead of the time-evol files
+# bash perf_sweep.sh 100010 200009 1 48 --refine=2000
+#   adaptive bifurcation sweep: every 2000th config first, then only the intervals whose tails differ are bisected
+#   down to CONTROL_PARAM_STEP (best with a fine gen_params --spec range); classes in refine_config-XXXXXXX-YYYYYYY.csv
+
+if [ "$#" -lt 4 ]; then
+    echo "error: Invalid number of arguments"
+    echo "try: bash perf_sweep.sh <config_id_min> <config_id_max> <n_shards> <cpus_per_shard> [sweep options]"
+    exit 1
+fi
+
+source "$PROJECT/CONFIG.sh"
+bash "$PROJECT/scripts/bash/check_build.sh" sweep || exit 1
+
+sbatch --array=0-$(( $3-1 )) --cpus-per-task="$4" --time="$PERF_TEVOL_TIME" "$PROJECT/scripts/slurm/sweep.slurm" "$1" "$2" "${@:5}"
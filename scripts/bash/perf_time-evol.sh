@@ -2,6 +2,8 @@
 
 module load gcc/11.3.0 gsl/2.7-gcc-11.3.0
 
+bash "$PROJECT/scripts/bash/check_build.sh" time-evol || exit 1
+
 config_id_min=$1
 config_id_max=$2
 
@@ -40,10 +42,15 @@ cat >&3 <<'EOF'
 
 source $2
 
-PERF_TEVOL_PARAM_PATH=$(printf "$PARAMS_DIR/wparams/$CONTROL_PARAM_NAME/wparams_config-%07g.txt" $1)
+# Ranges generated with gen_params --spec have no wparams files, the config is taken from the spec next to the CONFIG file
+if [[ -f "${2%.sh}.spec" ]]; then
+    PERF_TEVOL_PARAM_PATH="${2%.sh}.spec#$1"
+else
+    PERF_TEVOL_PARAM_PATH=$(printf "$PARAMS_DIR/wparams/$CONTROL_PARAM_NAME/wparams_config-%07g.txt" $1)
+fi
 PERF_TEVOL_OUTPUT_PATH=$(printf "$DATA_DIR/time-evol/$CONTROL_PARAM_NAME/time-evol_config-%07g.csv" $1)
 
-srun "$SOURCE_CODE_DIR/time-evol" "$PERF_TEVOL_PARAM_PATH" "$PERF_TEVOL_OUTPUT_PATH"
+srun "$SOURCE_CODE_DIR/time-evol" "$PERF_TEVOL_PARAM_PATH" "$PERF_TEVOL_OUTPUT_PATH" --engine="${TEVOL_ENGINE:-cached}" $TEVOL_TELEMETRY
 EOF
 
 exec 3>&-
@@ -0,0 +1,55 @@
+#!/bin/bash
+
+# Strong-scaling report of the 'threaded' time-evol engine: one wparams file is solved with the single-threaded
+# 'cached' engine in the scalar summation order (reference, --simd=scalar: the SIMD memory sums round differently) and
+# then with the 'threaded' engine on 1, 2, 4, ..., 64 cores. For every thread count the wall-clock time, the speed-up and
+# the parallel efficiency against the reference are printed, and the output file is compared with the reference (the
+# two engines must write identical files).
+# Run it on a whole node (e.g. inside 'srun --cpus-per-task=64 --pty bash'), thread counts above the number of cores
+# only measure oversubscription.
+
+# *** example of usage ***
+# bash scaling_time-evol.sh $PROJECT/parameters/wparams/nu/wparams_config-0000001.txt 2048 "1 2 4 8 16 32 64"
+
+if [ "$#" -lt 1 ]; then
+    echo "error: Invalid number of arguments"
+    echo "try: bash scaling_time-evol.sh <wparams_file> [block_size] [thread_counts]"
+    exit 1
+fi
+
+source "$PROJECT/CONFIG.sh"
+
+module load gcc/11.3.0 gsl/2.7-gcc-11.3.0
+
+bash "$PROJECT/scripts/bash/check_build.sh" time-evol || exit 1
+
+PARAMS_FILE=$1
+BLOCK_SIZE=${2:-2048}
+THREAD_COUNTS=${3:-"1 2 4 8 16 32 64"}
+
+TMP_DIR=$(mktemp -d)
+trap 'rm -rf "$TMP_DIR"' EXIT
+
+# Prints the wall-clock time (in seconds) of the given command
+wall_time() {
+    local t0 t1
+    t0=$(date +%s.%N)
+    "$@" >/dev/null || return 1
+    t1=$(date +%s.%N)
+    awk -v t0="$t0" -v t1="$t1" 'BEGIN { printf "%.3f", t1 - t0 }'
+}
+
+t_ref=$(wall_time "$SOURCE_CODE_DIR/time-evol" "$PARAMS_FILE" "$TMP_DIR/ref.csv" --engine=cached --simd=scalar) || exit 1
+echo "params: $PARAMS_FILE, block size: $BLOCK_SIZE"
+echo "reference (cached --simd=scalar, 1 thread): $t_ref s"
+printf "%8s %10s %9s %11s %s\n" "threads" "time[s]" "speed-up" "efficiency" "output"
+
+for n_threads in $THREAD_COUNTS; do
+    t=$(wall_time "$SOURCE_CODE_DIR/time-evol" "$PARAMS_FILE" "$TMP_DIR/threaded.csv" --engine=threaded \
+        --block-size="$BLOCK_SIZE" --engine-threads="$n_threads") || exit 1
+
+    if cmp -s "$TMP_DIR/ref.csv" "$TMP_DIR/threaded.csv"; then check="identical"; else check="DIFFERS"; fi
+
+    awk -v p="$n_threads" -v t="$t" -v t_ref="$t_ref" -v check="$check" \
+        'BEGIN { printf "%8d %10.3f %9.2f %10.1f%% %s\n", p, t, t_ref / t, 100 * t_ref / t / p, check }'
+done